@@ -0,0 +1,55 @@
+# - Check for the presence of LZMA
+#
+# The following variables are set when LZMA is found:
+#  HAVE_LZMA       = Set to true, if all components of LZMA
+#                          have been found.
+#  LZMA_INCLUDES   = Include path for the header files of LZMA
+#  LZMA_LIBRARIES  = Link these to use LZMA
+
+## -----------------------------------------------------------------------------
+## Check for the header files
+
+find_path (LZMA_INCLUDES lzma.h
+  PATHS /usr/local/include /usr/include ${CMAKE_EXTRA_INCLUDES}
+  )
+
+## -----------------------------------------------------------------------------
+## Check for the library
+
+find_library (LZMA_LIBRARIES lzma
+  PATHS /usr/local/lib /usr/lib /lib ${CMAKE_EXTRA_LIBRARIES}
+  )
+
+## -----------------------------------------------------------------------------
+## Actions taken when all components have been found
+
+if (LZMA_INCLUDES AND LZMA_LIBRARIES)
+  set (HAVE_LZMA TRUE)
+else (LZMA_INCLUDES AND LZMA_LIBRARIES)
+  if (NOT LZMA_FIND_QUIETLY)
+    if (NOT LZMA_INCLUDES)
+      message (STATUS "Unable to find LZMA header files!")
+    endif (NOT LZMA_INCLUDES)
+    if (NOT LZMA_LIBRARIES)
+      message (STATUS "Unable to find LZMA library files!")
+    endif (NOT LZMA_LIBRARIES)
+  endif (NOT LZMA_FIND_QUIETLY)
+endif (LZMA_INCLUDES AND LZMA_LIBRARIES)
+
+if (HAVE_LZMA)
+  if (NOT LZMA_FIND_QUIETLY)
+    message (STATUS "Found components for LZMA")
+    message (STATUS "LZMA_INCLUDES = ${LZMA_INCLUDES}")
+    message (STATUS "LZMA_LIBRARIES     = ${LZMA_LIBRARIES}")
+  endif (NOT LZMA_FIND_QUIETLY)
+else (HAVE_LZMA)
+  if (LZMA_FIND_REQUIRED)
+    message (FATAL_ERROR "Could not find LZMA!")
+  endif (LZMA_FIND_REQUIRED)
+endif (HAVE_LZMA)
+
+mark_as_advanced (
+  HAVE_LZMA
+  LZMA_LIBRARIES
+  LZMA_INCLUDES
+  )
\ No newline at end of file
@@ -27,7 +27,7 @@ Utility to help analyze results from the Shadow simulator. Use
 '$ python analyze --help' to get started
 """
 
-import sys, os, argparse, subprocess, pylab, numpy, itertools
+import sys, os, argparse, subprocess, pylab, numpy, itertools, csv
 
 ## PARSING DEFAULTS
 
@@ -341,14 +341,17 @@ class RelayStats(NodeStats):
 
 # holds client statistics
 class ClientStats(NodeStats):
-    def __init__(self, name):
+    def __init__(self, name, scrapedownloads=True):
         NodeStats.__init__(self, name)
         self.downloads = []
+        self.scrapedownloads = scrapedownloads # false if downloads come from a metrics file
 
     def parse(self, parts):
         tick = NodeStats.parse(self, parts)
         virtualt = parsetimestamp(parts[2])
         
+        if not self.scrapedownloads: return
+
         # filetransfer plug-in stats
         if parts[6] == "[fg-download-complete]":
             fbtime = float(parts[11])
@@ -362,6 +365,11 @@ class ClientStats(NodeStats):
             lbtime = float(parts[22])
             self.downloads.append(Download(bytes, fbtime, lbtime, virtualt))
 
+    def parsemetric(self, virtualt, metric, value, tags):
+        # plug-in results recorded with --metrics-file
+        if metric == "fg-download-complete" or metric == "client-block-complete":
+            self.downloads.append(Download(float(tags['bytes']), float(tags['ttfb']), value, virtualt))
+
 class Download():
     def __init__(self, bytes, ttfb, ttlb, time):
         self.bytes = bytes # size of the download
@@ -432,6 +440,13 @@ def main():
         action="store", dest="cutoff",
         default=CUTOFF)
 
+    parser_parse.add_argument('-m', '--metrics', 
+        help="""PATH to a metrics file written with shadow's --metrics-file. 
+                Downloads are then read from it instead of the log file.""", 
+        metavar="PATH",
+        action="store", dest="metricspath",
+        default=None)
+
     parser_parse.add_argument('-a', '--all', 
         help="export detailed stats for all nodes in addition to aggregate stats", 
         action="store_true", dest="all",
@@ -508,6 +523,11 @@ def parse(args):
     # statistics by nodename
     clients, relays = {}, {}
 
+    # downloads in the metrics file are not scraped from the log a second time
+    metricspath = None
+    if args.metricspath is not None:
+        metricspath = os.path.abspath(os.path.expanduser(args.metricspath))
+
     # parse the log file
     print "Parsing '{0}'".format(logpath)
     with open(logpath, 'r') as f:
@@ -535,12 +555,24 @@ def parse(args):
                 if nodename == "[n/a]": continue
                 name = nodename[1:nodename.index("-")]
                 if name.find("client") > -1:
-                    if name not in clients: clients[name] = ClientStats(name)
+                    if name not in clients: clients[name] = ClientStats(name, metricspath is None)
                     clients[name].parse(parts)
                 elif name.find("exit") > -1:
                     if name not in relays: relays[name] = RelayStats(name)
                     relays[name].parse(parts)
 
+    # parse the plug-in metrics
+    if metricspath is not None:
+        print "Parsing '{0}'".format(metricspath)
+        with open(metricspath, 'r') as f:
+            for row in csv.DictReader(f):
+                name = row['node'][0:row['node'].index("-")] if row['node'].find("-") > -1 else row['node']
+                if name.find("client") < 0: continue
+                if name not in clients: clients[name] = ClientStats(name, False)
+                tags = dict(t.split('=', 1) for t in row['tags'].split(';') if t.find('=') > -1)
+                virtualt = float(row['time']) / 1000000000.0
+                clients[name].parsemetric(virtualt, row['name'], float(row['value']), tags)
+
     # aggregate and save results
     print "Saving results to '{0}'".format(outputpath)
 
@@ -0,0 +1,186 @@
+#! /usr/bin/python
+
+# The Shadow Simulator
+#
+# Copyright (c) 2010-2012 Rob Jansen <jansen@cs.umn.edu>
+#
+# This file is part of Shadow.
+#
+# Shadow is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Shadow is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+"""
+benchmark.py
+
+Runs a fixed set of reproducible Shadow scenarios with a fixed seed, once for
+each requested number of worker threads, and prints one JSON object per run
+with the wall time, processed events per second, peak resident memory, and
+context switches per event. The micro-benchmarks of Shadow's internal data
+structures live in the shadow-bench-micro binary, and 'make shadow-bench' runs
+both. Use '$ python benchmark.py --help' to get started
+"""
+
+import sys, os, re, json, time, argparse, subprocess, tempfile, shutil, tarfile, random
+
+TOPOLOGY = """<topology>
+    <cluster id="NET" bandwidthdown="102400" bandwidthup="102400" packetloss="0.0"/>
+    <link id="link0" clusters="NET NET" latency="50" jitter="5"/>
+</topology>
+"""
+
+FILETRANSFER_HOSTS = """<plugin id="filex" path="{plugins}/libshadow-plugin-filetransfer.so" />
+<node id="server.node" cluster="NET">
+    <application plugin="filex" time="1" arguments="server 8080 {docroot}/" />
+</node>
+<node id="client.node" cluster="NET" quantity="{nodes}">
+    <application plugin="filex" time="2" arguments="client single server.node 8080 none 0 10 /bench.urnd" />
+</node>
+<kill time="{killtime}" />
+"""
+
+UDPSTORM_HOSTS = """<plugin id="echo" path="{plugins}/libshadow-plugin-echo.so" />
+<node id="server.node" cluster="NET">
+    <application plugin="echo" time="1" arguments="udp server" />
+</node>
+<node id="client.node" cluster="NET" quantity="{nodes}">
+    <application plugin="echo" time="2" arguments="udp client server.node" />
+</node>
+<kill time="{killtime}" />
+"""
+
+LOOPBACK_HOSTS = """<plugin id="echo" path="{plugins}/libshadow-plugin-echo.so" />
+<node id="loop.node" cluster="NET" quantity="{nodes}">
+    <application plugin="echo" time="1" arguments="tcp loopback" />
+    <application plugin="echo" time="1" arguments="udp loopback" />
+</node>
+<kill time="{killtime}" />
+"""
+
+EVENTS_RE = re.compile(r"processed (\d+) events in total")
+KILL_RE = re.compile(r'<kill time="\d+"\s*/>')
+
+def write_file(path, contents):
+    with open(path, "w") as f:
+        f.write(contents)
+
+def prepare_filetransfer(args, workdir):
+    docroot = os.path.join(workdir, "docroot")
+    os.mkdir(docroot)
+    # the same bytes every time, so every run transfers identical data
+    rng = random.Random(args.seed)
+    with open(os.path.join(docroot, "bench.urnd"), "wb") as f:
+        f.write(bytearray(rng.getrandbits(8) for i in range(1048576)))
+    write_file(os.path.join(workdir, "topology.xml"), TOPOLOGY)
+    write_file(os.path.join(workdir, "hosts.xml"), FILETRANSFER_HOSTS.format(plugins=args.plugins,
+        docroot=docroot, nodes=args.nodes, killtime=args.killtime))
+    return ["topology.xml", "hosts.xml"]
+
+def prepare_udpstorm(args, workdir):
+    write_file(os.path.join(workdir, "topology.xml"), TOPOLOGY)
+    write_file(os.path.join(workdir, "hosts.xml"), UDPSTORM_HOSTS.format(plugins=args.plugins,
+        nodes=args.nodes, killtime=args.killtime))
+    return ["topology.xml", "hosts.xml"]
+
+def prepare_loopback(args, workdir):
+    write_file(os.path.join(workdir, "topology.xml"), TOPOLOGY)
+    write_file(os.path.join(workdir, "hosts.xml"), LOOPBACK_HOSTS.format(plugins=args.plugins,
+        nodes=args.nodes, killtime=args.killtime))
+    return ["topology.xml", "hosts.xml"]
+
+def prepare_scallion(args, workdir):
+    # the minimal example network, cut short so it finishes in reasonable time
+    archive = os.path.join(args.examples, "scallion", "minimal.tar.xz")
+    subprocess.check_call(["tar", "xaf", archive, "-C", workdir])
+    hostspath = os.path.join(workdir, "minimal", "hosts.xml")
+    with open(hostspath) as f:
+        hosts = f.read()
+    write_file(hostspath, KILL_RE.sub('<kill time="{0}" />'.format(args.killtime), hosts))
+    return [os.path.join("minimal", "hosts.xml")]
+
+## the scenarios we run, as (name, setup function)
+SCENARIOS = [
+    ("filetransfer", prepare_filetransfer),
+    ("scallion", prepare_scallion),
+    ("udpstorm", prepare_udpstorm),
+    ("loopback", prepare_loopback),
+]
+
+def run_shadow(command, cwd):
+    """Runs shadow and returns (exit status, output, wall seconds, rusage)."""
+    outpath = os.path.join(cwd, "shadow.log")
+    with open(outpath, "w") as out:
+        start = time.time()
+        p = subprocess.Popen(command, cwd=cwd, stdout=out, stderr=subprocess.STDOUT)
+        # wait4 gives us the resource usage of this child alone
+        (pid, status, usage) = os.wait4(p.pid, 0)
+        wall = time.time() - start
+    with open(outpath) as f:
+        output = f.read()
+    return (status, output, wall, usage)
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Run reproducible Shadow benchmark scenarios and print machine-readable results',
+        formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+    parser.add_argument('-s', '--shadow', help="path to the shadow binary", default="shadow")
+    parser.add_argument('-p', '--plugins', help="directory holding the shadow plug-ins",
+        default=os.path.expanduser("~/.shadow/plugins"))
+    parser.add_argument('-e', '--examples', help="directory holding the example archives",
+        default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "resource", "examples"))
+    parser.add_argument('-w', '--workers', help="comma separated worker thread counts to run", default="0,2,4")
+    parser.add_argument('-n', '--nodes', help="number of nodes to scale the scenarios to", type=int, default=100)
+    parser.add_argument('-k', '--killtime', help="simulated seconds to run each scenario", type=int, default=600)
+    parser.add_argument('-r', '--seed', help="random seed given to shadow", type=int, default=1)
+    parser.add_argument('-o', '--only', help="comma separated scenario names to run", default=None)
+    args = parser.parse_args()
+
+    workers = [int(w) for w in args.workers.split(",")]
+    only = args.only.split(",") if args.only else None
+
+    for (name, prepare) in SCENARIOS:
+        if only and name not in only:
+            continue
+        for nworkers in workers:
+            result = {"scenario": name, "workers": nworkers, "nodes": args.nodes,
+                "seed": args.seed, "killtime": args.killtime}
+            workdir = tempfile.mkdtemp(prefix="shadow-bench-")
+            try:
+                inputs = prepare(args, workdir)
+                command = [args.shadow, "--log-level=message", "--seed={0}".format(args.seed),
+                    "--workers={0}".format(nworkers)] + inputs
+                (status, output, wall, usage) = run_shadow(command, workdir)
+
+                m = EVENTS_RE.search(output)
+                events = int(m.group(1)) if m else 0
+                switches = usage.ru_nvcsw + usage.ru_nivcsw
+
+                result["success"] = (status == 0 and events > 0)
+                result["wallSeconds"] = round(wall, 3)
+                result["events"] = events
+                result["eventsPerSecond"] = round(events / wall, 1) if wall > 0 else 0
+                # ru_maxrss is in KiB on Linux
+                result["peakRSSBytes"] = usage.ru_maxrss * 1024
+                result["contextSwitches"] = switches
+                result["contextSwitchesPerEvent"] = (float(switches) / events) if events > 0 else 0
+            except (OSError, IOError, subprocess.CalledProcessError) as e:
+                result["success"] = False
+                result["error"] = str(e)
+            finally:
+                shutil.rmtree(workdir)
+
+            print(json.dumps(result, sort_keys=True))
+            sys.stdout.flush()
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,109 @@
+#! /usr/bin/python
+
+# The Shadow Simulator
+#
+# Copyright (c) 2010-2012 Rob Jansen <jansen@cs.umn.edu>
+#
+# This file is part of Shadow.
+#
+# Shadow is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Shadow is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+"""
+releasecheck.py
+
+Regression test for release builds (cmake -DSHADOW_RELEASE=ON, optionally with
+PGO). Runs the built-in examples with a baseline Shadow and a release Shadow,
+checks that both produce the same simulation output, and reports the speedup.
+CPU delays and heartbeats are disabled, since they are measured from the
+running code and would legitimately differ between the builds. Use
+'$ python releasecheck.py --help' to get started
+"""
+
+import sys, os, re, time, argparse, subprocess, tempfile, shutil
+
+## the built-in examples we compare
+EXAMPLES = ["echo", "file", "torrent", "browser"]
+
+## lines that change with every run or build, not with the simulation
+IGNORE_RE = re.compile(r"Shadow v|private copy of plug-in|hibernated \d+ states")
+
+def normalize(output):
+    """Strips wall clock times, memory addresses and temporary paths, like
+    strip_log_for_compare.py does."""
+    lines = []
+    for line in output.splitlines():
+        if IGNORE_RE.search(line):
+            continue
+        parts = line.strip().split()[1:] # skip the first timer column
+        parts = [p for p in parts if not p.startswith("0x") and not p.startswith("/tmp/")]
+        lines.append(" ".join(parts))
+    return lines
+
+def run(shadow, example, args):
+    command = [shadow, "--{0}".format(example), "--seed={0}".format(args.seed),
+        "--cpu-threshold=-1", "--heartbeat-frequency=0", "--workers=0"]
+    workdir = tempfile.mkdtemp(prefix="shadow-releasecheck-")
+    try:
+        start = time.time()
+        output = subprocess.check_output(command, cwd=workdir, stderr=subprocess.STDOUT)
+        wall = time.time() - start
+    finally:
+        shutil.rmtree(workdir)
+    if not isinstance(output, str):
+        output = output.decode("utf-8", "replace")
+    return (normalize(output), wall)
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Check that a release build of Shadow simulates exactly like a baseline build, and time both',
+        formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+    parser.add_argument('-b', '--baseline', help="path to the baseline shadow wrapper", required=True)
+    parser.add_argument('-r', '--release', help="path to the release shadow wrapper", required=True)
+    parser.add_argument('-e', '--examples', help="comma separated built-in examples to run", default=",".join(EXAMPLES))
+    parser.add_argument('-n', '--repeat', help="runs of each build, of which the fastest counts", type=int, default=3)
+    parser.add_argument('-s', '--seed', help="random seed given to shadow", type=int, default=1)
+    args = parser.parse_args()
+
+    failed = 0
+    print("{0:<10} {1:>12} {2:>12} {3:>9} {4:>10}".format("example", "baseline(s)", "release(s)", "speedup", "output"))
+
+    for example in args.examples.split(","):
+        baselineTimes, releaseTimes = [], []
+        baselineOutput, releaseOutput = None, None
+        for i in range(args.repeat):
+            (baselineOutput, wall) = run(args.baseline, example, args)
+            baselineTimes.append(wall)
+            (releaseOutput, wall) = run(args.release, example, args)
+            releaseTimes.append(wall)
+
+        same = (baselineOutput == releaseOutput)
+        if not same:
+            failed += 1
+            for (a, b) in zip(baselineOutput, releaseOutput):
+                if a != b:
+                    sys.stderr.write("{0}: first difference:\n  baseline: {1}\n  release:  {2}\n".format(example, a, b))
+                    break
+            else:
+                sys.stderr.write("{0}: outputs differ in length ({1} vs {2} lines)\n".format(
+                    example, len(baselineOutput), len(releaseOutput)))
+
+        baseline, release = min(baselineTimes), min(releaseTimes)
+        print("{0:<10} {1:>12.3f} {2:>12.3f} {3:>8.2f}x {4:>10}".format(example, baseline, release,
+            baseline / release if release > 0 else 0, "same" if same else "DIFFERENT"))
+
+    return 1 if failed > 0 else 0
+
+if __name__ == '__main__':
+    sys.exit(main())
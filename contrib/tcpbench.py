@@ -0,0 +1,125 @@
+#! /usr/bin/python
+
+# The Shadow Simulator
+#
+# Copyright (c) 2010-2012 Rob Jansen <jansen@cs.umn.edu>
+#
+# This file is part of Shadow.
+#
+# Shadow is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# Shadow is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+"""
+tcpbench.py
+
+Runs the same lossy file transfer experiment once for each TCP congestion
+control setting, and compares retransmitted packets and processed events per
+transferred MiB. Use '$ python tcpbench.py --help' to get started
+"""
+
+import sys, os, re, argparse, subprocess, tempfile, shutil
+
+## the settings we compare, as (name, shadow arguments)
+SETTINGS = [
+    ("aimd", ["--tcp-congestion-control=aimd"]),
+    ("reno", ["--tcp-congestion-control=reno"]),
+    ("reno+sack", ["--tcp-congestion-control=reno", "--tcp-sack"]),
+    ("cubic", ["--tcp-congestion-control=cubic"]),
+    ("cubic+sack", ["--tcp-congestion-control=cubic", "--tcp-sack"]),
+]
+
+TOPOLOGY = """<topology>
+    <cluster id="SRV" bandwidthdown="102400" bandwidthup="102400" packetloss="{loss}"/>
+    <cluster id="CLI" bandwidthdown="102400" bandwidthup="102400" packetloss="{loss}"/>
+    <link id="link0" clusters="SRV SRV" latency="{latency}" jitter="0"/>
+    <link id="link1" clusters="SRV CLI" latency="{latency}" jitter="{jitter}"/>
+    <link id="link2" clusters="CLI CLI" latency="{latency}" jitter="0"/>
+    <link id="link3" clusters="CLI SRV" latency="{latency}" jitter="{jitter}"/>
+</topology>
+"""
+
+HOSTS = """<plugin id="filex" path="libshadow-plugin-filetransfer.so" />
+<node id="server.node" cluster="SRV">
+    <application plugin="filex" time="1" arguments="server 8080 {docroot}/" />
+</node>
+<node id="client.node" cluster="CLI" quantity="{clients}">
+    <application plugin="filex" time="2" arguments="client single server.node 8080 none 0 {downloads} /bench.urnd" />
+</node>
+<kill time="{killtime}" />
+"""
+
+TCP_RE = re.compile(r"\[shadow-tcp\] .* sent (\d+) data packets, retransmitted (\d+), (\d+) loss recoveries")
+EVENTS_RE = re.compile(r"processed (\d+) events in total")
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Compare TCP congestion control in Shadow on a lossy high-BDP path',
+        formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+    parser.add_argument('-s', '--shadow', help="path to the shadow binary", default="shadow")
+    parser.add_argument('-l', '--loss', help="packet loss rate at each end of the path", type=float, default=0.01)
+    parser.add_argument('-d', '--latency', help="one-way link latency in milliseconds", type=int, default=100)
+    parser.add_argument('-j', '--jitter', help="link jitter in milliseconds", type=int, default=10)
+    parser.add_argument('-c', '--clients', help="number of downloading clients", type=int, default=10)
+    parser.add_argument('-n', '--downloads', help="downloads per client", type=int, default=5)
+    parser.add_argument('-m', '--mib', help="size of the downloaded file in MiB", type=int, default=5)
+    parser.add_argument('-k', '--killtime', help="simulated seconds to run", type=int, default=3600)
+    parser.add_argument('-w', '--workers', help="shadow worker threads", type=int, default=0)
+    args = parser.parse_args()
+
+    workdir = tempfile.mkdtemp(prefix="shadow-tcpbench-")
+    try:
+        docroot = os.path.join(workdir, "docroot")
+        os.mkdir(docroot)
+        with open(os.path.join(docroot, "bench.urnd"), "wb") as f:
+            for i in range(args.mib):
+                f.write(os.urandom(1048576))
+
+        topologypath = os.path.join(workdir, "topology.xml")
+        with open(topologypath, "w") as f:
+            f.write(TOPOLOGY.format(loss=args.loss, latency=args.latency, jitter=args.jitter))
+        hostspath = os.path.join(workdir, "hosts.xml")
+        with open(hostspath, "w") as f:
+            f.write(HOSTS.format(docroot=docroot, clients=args.clients,
+                downloads=args.downloads, killtime=args.killtime))
+
+        mib = float(args.clients * args.downloads * args.mib)
+        print("{0:<12} {1:>12} {2:>12} {3:>14} {4:>14}".format(
+            "setting", "sent/MiB", "retx/MiB", "recoveries", "events/MiB"))
+
+        for (name, settingargs) in SETTINGS:
+            command = [args.shadow, "--log-level=info", "--workers={0}".format(args.workers)]
+            command += settingargs + [topologypath, hostspath]
+            output = subprocess.check_output(command, cwd=workdir)
+            if not isinstance(output, str):
+                output = output.decode("utf-8", "replace")
+
+            sent, retransmitted, recoveries, events = 0, 0, 0, 0
+            for line in output.splitlines():
+                m = TCP_RE.search(line)
+                if m:
+                    sent += int(m.group(1))
+                    retransmitted += int(m.group(2))
+                    recoveries += int(m.group(3))
+                    continue
+                m = EVENTS_RE.search(line)
+                if m:
+                    events = int(m.group(1))
+
+            print("{0:<12} {1:>12.1f} {2:>12.1f} {3:>14} {4:>14.1f}".format(
+                name, sent / mib, retransmitted / mib, recoveries, events / mib))
+    finally:
+        shutil.rmtree(workdir)
+
+if __name__ == '__main__':
+    sys.exit(main())
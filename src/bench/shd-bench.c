@@ -0,0 +1,167 @@
+/**
+ * The Shadow Simulator
+ *
+ * Copyright (c) 2010-2012 Rob Jansen <jansen@cs.umn.edu>
+ *
+ * This file is part of Shadow.
+ *
+ * Shadow is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shadow is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Micro-benchmarks of the data structures on Shadow's hot paths. Each one
+ * prints a single JSON line to stdout, so results are easy to compare across
+ * builds. The whole-simulation scenarios are run by contrib/benchmark.py.
+ */
+
+#include "shadow.h"
+
+/* all benchmarks draw from the same seed so runs are comparable */
+#define BENCH_SEED 1
+#define BENCH_QUEUE_ITEMS 1000000
+#define BENCH_BYTE_ROUNDS 1000000
+#define BENCH_CDF_LOOKUPS 1000000
+#define BENCH_PACKETS 1000000
+
+static void _bench_report(const gchar* name, guint64 operations, gint64 startMicros) {
+	gdouble seconds = ((gdouble)(g_get_monotonic_time() - startMicros)) / G_USEC_PER_SEC;
+	g_print("{\"benchmark\":\"%s\",\"operations\":%"G_GUINT64_FORMAT",\"seconds\":%f,\"nsPerOperation\":%f}\n",
+			name, operations, seconds, operations > 0 ? (seconds * 1000000000.0) / operations : 0.0);
+}
+
+static gint _bench_compareItems(gconstpointer a, gconstpointer b, gpointer userData) {
+	gint ia = GPOINTER_TO_INT(a);
+	gint ib = GPOINTER_TO_INT(b);
+	return ia > ib ? +1 : ia == ib ? 0 : -1;
+}
+
+static void _bench_priorityQueue(GRand* random) {
+	/* distinct items in random order, since the queue indexes them by value */
+	gint* items = g_new(gint, BENCH_QUEUE_ITEMS);
+	for(gint i = 0; i < BENCH_QUEUE_ITEMS; i++) {
+		items[i] = i + 1;
+	}
+	for(gint i = BENCH_QUEUE_ITEMS - 1; i > 0; i--) {
+		gint j = g_rand_int_range(random, 0, i + 1);
+		gint tmp = items[i];
+		items[i] = items[j];
+		items[j] = tmp;
+	}
+
+	PriorityQueue* queue = priorityqueue_new(_bench_compareItems, NULL, NULL);
+
+	gint64 start = g_get_monotonic_time();
+	for(gint i = 0; i < BENCH_QUEUE_ITEMS; i++) {
+		priorityqueue_push(queue, GINT_TO_POINTER(items[i]));
+	}
+	while(priorityqueue_pop(queue)) {
+		;
+	}
+	_bench_report("priorityqueue_push_pop", BENCH_QUEUE_ITEMS, start);
+
+	priorityqueue_free(queue);
+	g_free(items);
+}
+
+static void _bench_byteQueue() {
+	gchar buffer[CONFIG_MTU];
+	memset(buffer, 'x', sizeof(buffer));
+	ByteQueue* queue = bytequeue_new(8192);
+
+	/* keep a window of data in the queue, like a socket buffer does */
+	gint64 start = g_get_monotonic_time();
+	for(gint i = 0; i < 16; i++) {
+		bytequeue_push(queue, buffer, sizeof(buffer));
+	}
+	for(gint i = 0; i < BENCH_BYTE_ROUNDS; i++) {
+		bytequeue_push(queue, buffer, sizeof(buffer));
+		bytequeue_pop(queue, buffer, sizeof(buffer));
+	}
+	_bench_report("bytequeue_push_pop", BENCH_BYTE_ROUNDS, start);
+
+	bytequeue_free(queue);
+}
+
+static void _bench_cdf(GRand* random) {
+	CumulativeDistribution* cdf = cdf_generate(g_quark_from_string("bench"), 50, 10, 100);
+	gdouble sum = 0;
+
+	gint64 start = g_get_monotonic_time();
+	for(gint i = 0; i < BENCH_CDF_LOOKUPS; i++) {
+		sum += cdf_getValue(cdf, g_rand_double(random));
+	}
+	_bench_report("cdf_getValue", BENCH_CDF_LOOKUPS, start);
+
+	/* make sure the lookups are not optimized away */
+	if(sum < 0) {
+		g_print("%f\n", sum);
+	}
+
+	cdf_free(cdf);
+}
+
+static void _bench_packet() {
+	gchar payload[CONFIG_MTU - CONFIG_HEADER_SIZE_TCPIPETH];
+	memset(payload, 'x', sizeof(payload));
+
+	gint64 start = g_get_monotonic_time();
+	for(gint i = 0; i < BENCH_PACKETS; i++) {
+		Packet* packet = packet_new(payload, sizeof(payload));
+		packet_unref(packet);
+	}
+	_bench_report("packet_new_unref", BENCH_PACKETS, start);
+}
+
+gint main(gint argc, gchar* argv[]) {
+	/* the same options as shadow, though only a few matter here */
+	Configuration* config = configuration_new(argc, argv);
+	if(!config) {
+		return -1;
+	}
+	/* logs go to stdout too, so keep them out of the results */
+	configuration_setLogLevel(config, "warning");
+
+	shadow_engine = engine_new(config);
+	Worker* worker = worker_getPrivate();
+	worker->cached_engine = shadow_engine;
+
+	GLogLevelFlags configuredLogLevel = configuration_getLogLevel(config);
+	g_log_set_default_handler(logging_handleLog, &(configuredLogLevel));
+
+	/* packets take their priority from the node that creates them */
+	GString* hostname = g_string_new("bench");
+	Node* node = node_new(g_quark_from_string(hostname->str), NULL, 0, hostname,
+			10240, 10240, 0, -1, -1, BENCH_SEED, 0, 0, 0, FALSE, NULL, "fifo",
+			TCP_CC_AIMD, FALSE, CONFIG_RECV_BUFFER_SIZE, CONFIG_SEND_BUFFER_SIZE, 1024000);
+	worker->cached_node = node;
+
+	GRand* random = g_rand_new_with_seed(BENCH_SEED);
+
+	_bench_priorityQueue(random);
+	_bench_byteQueue();
+	_bench_cdf(random);
+	_bench_packet();
+
+	g_rand_free(random);
+	worker->cached_node = NULL;
+	node_free(node, NULL);
+	g_string_free(hostname, TRUE);
+
+	engine_free(shadow_engine);
+	shadow_engine = NULL;
+	worker_free(worker);
+	configuration_free(config);
+
+	return 0;
+}
@@ -46,13 +46,20 @@ Configuration* configuration_new(gint argc, gchar* argv[]) {
 	c->cpuThreshold = 1000;
 	c->cpuPrecision = 200;
 	c->heartbeatInterval = 60;
+	c->hibernateHorizon = 0;
 
 	/* set options to change defaults for the main group */
 	c->mainOptionGroup = g_option_group_new("main", "Application Options", "Various application related options", NULL, NULL);
 	const GOptionEntry mainEntries[] = {
 	  { "log-level", 'l', 0, G_OPTION_ARG_STRING, &(c->logLevelInput), "Log LEVEL above which to filter messages ('error' < 'critical' < 'warning' < 'message' < 'info' < 'debug') ['message']", "LEVEL" },
 	  { "heartbeat-log-level", 'g', 0, G_OPTION_ARG_STRING, &(c->heartbeatLogLevelInput), "Log LEVEL at which to print node statistics ['message']", "LEVEL" },
-	  { "heartbeat-frequency", 'h', 0, G_OPTION_ARG_INT, &(c->heartbeatInterval), "Log node statistics every N seconds [60]", "N" },
+	  { "control-socket", 0, 0, G_OPTION_ARG_FILENAME, &(c->controlSocketPath), "Serve status requests and pause, resume and log level commands on a Unix socket at PATH", "PATH" },
+	  { "heartbeat-file", 0, 0, G_OPTION_ARG_FILENAME, &(c->heartbeatFilename), "Write node statistics as CSV rows to FILE instead of logging them", "FILE" },
+	  { "metrics-file", 0, 0, G_OPTION_ARG_FILENAME, &(c->metricsFilename), "Write the results plug-ins record as CSV rows to FILE", "FILE" },
+	  { "profile-file", 0, 0, G_OPTION_ARG_FILENAME, &(c->profileFilename), "Count events and their wall time per event type and node, and write them as CSV rows to FILE at shutdown", "FILE" },
+	  { "topology-cache", 0, 0, G_OPTION_ARG_FILENAME, &(c->topologyCacheDirectory), "Store compiled topologies in DIR and reuse them instead of parsing unchanged input files", "DIR" },
+	  { "profile-folded", 0, 0, G_OPTION_ARG_NONE, &(c->profileFolded), "Write the profile as folded stacks for flamegraph.pl instead of CSV rows", NULL },
+	  { "heartbeat-frequency", 'h', 0, G_OPTION_ARG_INT, &(c->heartbeatInterval), "Log node statistics every N seconds, 0 to disable [60]", "N" },
 	  { "seed", 's', 0, G_OPTION_ARG_INT, &(c->randomSeed), "Initialize randomness for each thread using seed N [1]", "N" },
 	  { "workers", 'w', 0, G_OPTION_ARG_INT, &(c->nWorkerThreads), "Use N worker threads [0]", "N" },
 	  { "version", 'v', 0, G_OPTION_ARG_NONE, &(c->printSoftwareVersion), "Print software version and exit", NULL },
@@ -72,11 +79,16 @@ Configuration* configuration_new(gint argc, gchar* argv[]) {
 	const GOptionEntry networkEntries[] =
 	{
 	  { "cpu-threshold", 0, 0, G_OPTION_ARG_INT, &(c->cpuThreshold), "TIME delay threshold after which the CPU becomes blocked, in microseconds (negative value to disable CPU delays) [1000]", "TIME" },
+	  { "cpu-delay-model", 0, 0, G_OPTION_ARG_STRING, &(c->cpuDelayModelInput), "Measure plug-in CPU usage with MODEL ('none', 'instructions', 'cycles', 'tsc', or 'wallclock') ['wallclock']", "MODEL" },
 	  { "cpu-precision", 0, 0, G_OPTION_ARG_INT, &(c->cpuPrecision), "round measured CPU delays to the nearest TIME, in microseconds (negative value to disable fuzzy CPU delays) [200]", "TIME" },
-	  { "interface-batch", 0, 0, G_OPTION_ARG_INT, &(c->interfaceBatchTime), "Batch TIME for network interface sends and receives, in milliseconds [10]", "TIME" },
-	  { "interface-buffer", 0, 0, G_OPTION_ARG_INT, &(c->interfaceBufferSize), "Size of the network interface receive buffer, in bytes [1024000]", "N" },
+	  { "crypto-costs", 0, 0, G_OPTION_ARG_STRING, &(c->cryptoCostsInput), "Charge intercepted public-key operations the CPU TIME in LIST, in microseconds (e.g. 'rsa-private-decrypt=400,dh-compute-key=300')", "LIST" },
+	  { "hibernate-horizon", 0, 0, G_OPTION_ARG_INT, &(c->hibernateHorizon), "Compress the plug-in state of nodes whose next event is more than TIME away, in milliseconds (0 to disable) [0]", "TIME" },
+	  { "interface-batch", 0, 0, G_OPTION_ARG_INT, &(c->interfaceBatchTime), "Unused, network interfaces wake up when each packet is done [10]", "TIME" },
+	  { "interface-buffer", 0, 0, G_OPTION_ARG_INT, &(c->interfaceBufferSize), "Size of the network interface receive buffer and send backlog, in bytes [1024000]", "N" },
 	  { "interface-qdisc", 0, 0, G_OPTION_ARG_STRING, &(c->interfaceQueuingDiscipline), "The interface queuing discipline QDISC used to select the next sendable socket ('fifo' or 'rr') ['fifo']", "QDISC" },
 	  { "runahead", 0, 0, G_OPTION_ARG_INT, &(c->minRunAhead), "Minimum allowed TIME workers may run ahead when sending events between nodes, in milliseconds [10]", "TIME" },
+	  { "tcp-congestion-control", 0, 0, G_OPTION_ARG_STRING, &(c->tcpCongestionControlInput), "Congestion control ALGORITHM for TCP sockets ('aimd', 'reno', or 'cubic') ['aimd']", "ALGORITHM" },
+	  { "tcp-sack", 0, 0, G_OPTION_ARG_NONE, &(c->tcpSelectiveAcks), "Recover from TCP losses with selective acks instead of one hole per partial ack (ignored by 'aimd')", NULL },
 	  { "tcp-windows", 0, 0, G_OPTION_ARG_INT, &(c->initialTCPWindow), "Initialize the TCP send, receive, and congestion windows to N packets [10]", "N" },
 	  { "socket-recv-buffer", 0, 0, G_OPTION_ARG_INT, &(c->initialSocketReceiveBufferSize), sockrecv->str, "N" },
 	  { "socket-send-buffer", 0, 0, G_OPTION_ARG_INT, &(c->initialSocketSendBufferSize), socksend->str, "N" },
@@ -129,9 +141,6 @@ Configuration* configuration_new(gint argc, gchar* argv[]) {
 	if(c->heartbeatLogLevelInput == NULL) {
 		c->heartbeatLogLevelInput = g_strdup("message");
 	}
-	if(c->heartbeatInterval < 1) {
-		c->heartbeatInterval = 1;
-	}
 	if(c->initialTCPWindow < 1) {
 		c->initialTCPWindow = 1;
 	}
@@ -143,9 +152,23 @@ Configuration* configuration_new(gint argc, gchar* argv[]) {
 		/* we require at least 1 nanosecond b/c of time granularity */
 		c->interfaceBatchTime = 1;
 	}
+	if(c->hibernateHorizon < 0) {
+		c->hibernateHorizon = 0;
+	}
 	if(c->interfaceQueuingDiscipline == NULL) {
 		c->interfaceQueuingDiscipline = g_strdup("fifo");
 	}
+	if(c->cpuDelayModelInput == NULL) {
+		c->cpuDelayModelInput = g_strdup("wallclock");
+	}
+	if(c->tcpCongestionControlInput == NULL) {
+		c->tcpCongestionControlInput = g_strdup("aimd");
+	}
+	if(tcpcongestion_typeFromString(c->tcpCongestionControlInput) == TCP_CC_UNKNOWN) {
+		g_printerr("** Unknown TCP congestion control '%s' **\n", c->tcpCongestionControlInput);
+		configuration_free(c);
+		return NULL;
+	}
 
 	c->inputXMLFilenames = g_queue_new();
 	for(gint i = 1; i < argc; i++) {
@@ -171,7 +194,15 @@ void configuration_free(Configuration* config) {
 	}
 	g_free(config->logLevelInput);
 	g_free(config->heartbeatLogLevelInput);
+	g_free(config->heartbeatFilename);
+	g_free(config->profileFilename);
+	g_free(config->metricsFilename);
+	g_free(config->topologyCacheDirectory);
+	g_free(config->controlSocketPath);
 	g_free(config->interfaceQueuingDiscipline);
+	g_free(config->cpuDelayModelInput);
+	g_free(config->cryptoCostsInput);
+	g_free(config->tcpCongestionControlInput);
 
 	/* groups are freed with the context */
 	g_option_context_free(config->context);
@@ -205,18 +236,82 @@ GLogLevelFlags configuration_getLogLevel(Configuration* config) {
 	return configuration_getLevel(config, l);
 }
 
+gboolean configuration_setLogLevel(Configuration* config, const gchar* input) {
+	MAGIC_ASSERT(config);
+
+	/* unknown names would silently become 'message' */
+	if(configuration_getLevel(config, input) == G_LOG_LEVEL_MESSAGE &&
+			g_ascii_strcasecmp(input, "message") != 0) {
+		return FALSE;
+	}
+
+	g_free(config->logLevelInput);
+	config->logLevelInput = g_strdup(input);
+	return TRUE;
+}
+
 GLogLevelFlags configuration_getHeartbeatLogLevel(Configuration* config) {
 	MAGIC_ASSERT(config);
 	const gchar* l = (const gchar*) config->heartbeatLogLevelInput;
 	return configuration_getLevel(config, l);
 }
 
+const gchar* configuration_getHeartbeatFilename(Configuration* config) {
+	MAGIC_ASSERT(config);
+	return config->heartbeatFilename;
+}
+
+const gchar* configuration_getMetricsFilename(Configuration* config) {
+	MAGIC_ASSERT(config);
+	return config->metricsFilename;
+}
+
+const gchar* configuration_getTopologyCacheDirectory(Configuration* config) {
+	MAGIC_ASSERT(config);
+	return config->topologyCacheDirectory;
+}
+
+const gchar* configuration_getProfileFilename(Configuration* config) {
+	MAGIC_ASSERT(config);
+	return config->profileFilename;
+}
+
+gboolean configuration_getProfileFolded(Configuration* config) {
+	MAGIC_ASSERT(config);
+	return config->profileFolded;
+}
+
+const gchar* configuration_getControlSocketPath(Configuration* config) {
+	MAGIC_ASSERT(config);
+	return config->controlSocketPath;
+}
+
 SimulationTime configuration_getHearbeatInterval(Configuration* config) {
 	MAGIC_ASSERT(config);
 	return config->heartbeatInterval * SIMTIME_ONE_SECOND;
 }
 
+SimulationTime configuration_getHibernateHorizon(Configuration* config) {
+	MAGIC_ASSERT(config);
+	return ((SimulationTime) config->hibernateHorizon) * SIMTIME_ONE_MILLISECOND;
+}
+
 gchar* configuration_getQueuingDiscipline(Configuration* config) {
 	MAGIC_ASSERT(config);
 	return config->interfaceQueuingDiscipline;
 }
+
+gchar* configuration_getCPUDelayModel(Configuration* config) {
+	MAGIC_ASSERT(config);
+	return config->cpuDelayModelInput;
+}
+
+gchar* configuration_getTCPCongestionControl(Configuration* config) {
+	MAGIC_ASSERT(config);
+	return config->tcpCongestionControlInput;
+}
+
+gchar* configuration_getCryptoCosts(Configuration* config) {
+	MAGIC_ASSERT(config);
+	return config->cryptoCostsInput;
+}
@@ -71,7 +71,7 @@ typedef guint64 SimulationTime;
  */
 #define SIMTIME_ONE_HOUR G_GUINT64_CONSTANT(3600000000000)
 
-#if 1
+#ifndef SHADOW_RELEASE
 /**
  * Memory magic for assertions that memory has not been freed. The idea behind
  * this approach is to declare a value in each struct using MAGIC_DECLARE,
@@ -79,12 +79,11 @@ typedef guint64 SimulationTime;
  * cleanup using MAGIC_CLEAR. Any time the object is referenced, we can check
  * the magic value using MAGIC_ASSERT. If the assert fails, there is a bug.
  *
- * In general, this should only be used in DEBUG mode. Once we are somewhat
- * convinced on Shadow's stability (for releases), these macros will do nothing.
+ * Release builds (cmake -DSHADOW_RELEASE=ON) define SHADOW_RELEASE, and
+ * these macros do nothing. Code must therefore never read or write the magic
+ * member directly, and MAGIC_VALUE may only end an initializer list.
  *
  * MAGIC_VALUE is an arbitrary value.
- *
- * @todo add #ifdef DEBUG
  */
 #define MAGIC_VALUE 0xAABBCCDD
 
@@ -113,7 +112,8 @@ typedef guint64 SimulationTime;
 #define MAGIC_VALUE
 #define MAGIC_DECLARE
 #define MAGIC_INIT(object)
-#define MAGIC_ASSERT(object)
+/* still use the object, so variables that are only checked are not unused */
+#define MAGIC_ASSERT(object) ((void)(object))
 #define MAGIC_CLEAR(object)
 #endif
 
@@ -218,6 +218,38 @@ typedef guint64 SimulationTime;
  */
 #define CONFIG_TCPCLOSETIMER_DELAY (60 * SIMTIME_ONE_SECOND)
 
+/**
+ * Width of the finest slots in each node's timer wheel. Timers still fire at
+ * their exact time, this only affects how timers are bucketed.
+ */
+#define CONFIG_TIMERWHEEL_GRANULARITY SIMTIME_ONE_MILLISECOND
+
+/**
+ * Default CPU cost of an RSA public key operation (encrypt or verify),
+ * charged to the node when public-key crypto is intercepted.
+ */
+#define CONFIG_CRYPTO_COST_RSA_PUBLIC (20 * SIMTIME_ONE_MICROSECOND)
+
+/**
+ * Default CPU cost of an RSA private key operation (decrypt or sign).
+ */
+#define CONFIG_CRYPTO_COST_RSA_PRIVATE (400 * SIMTIME_ONE_MICROSECOND)
+
+/**
+ * Default CPU cost of generating a DH key or computing a DH shared secret.
+ */
+#define CONFIG_CRYPTO_COST_DH (300 * SIMTIME_ONE_MICROSECOND)
+
+/**
+ * Default CPU cost of computing an ECDH shared secret.
+ */
+#define CONFIG_CRYPTO_COST_ECDH (100 * SIMTIME_ONE_MICROSECOND)
+
+/**
+ * Number of public-key results each worker remembers for reuse.
+ */
+#define CONFIG_CRYPTO_CACHE_SIZE 65536
+
 /**
  * Filename to find the CPU speed.
  */
@@ -235,17 +267,28 @@ struct _Configuration {
 	gboolean printSoftwareVersion;
 	guint heartbeatInterval;
 	gchar* heartbeatLogLevelInput;
+	gchar* heartbeatFilename;
+	gchar* controlSocketPath;
+	gchar* profileFilename;
+	gchar* metricsFilename;
+	gchar* topologyCacheDirectory;
+	gboolean profileFolded;
 
 	GOptionGroup* networkOptionGroup;
 	gint cpuThreshold;
 	gint cpuPrecision;
+	gchar* cpuDelayModelInput;
+	gchar* cryptoCostsInput;
 	gint minRunAhead;
 	gint initialTCPWindow;
+	gchar* tcpCongestionControlInput;
+	gboolean tcpSelectiveAcks;
 	gint interfaceBufferSize;
 	gint initialSocketReceiveBufferSize;
 	gint initialSocketSendBufferSize;
 	gchar* interfaceQueuingDiscipline;
 	SimulationTime interfaceBatchTime;
+	gint hibernateHorizon;
 
 	GOptionGroup* pluginsOptionGroup;
 	gboolean runEchoExample;
@@ -300,6 +343,17 @@ GLogLevelFlags configuration_getLevel(Configuration* config, const gchar* input)
  */
 GLogLevelFlags configuration_getLogLevel(Configuration* config);
 
+/**
+ * Change the global log level while the simulation runs. The caller must make
+ * sure no other thread is logging.
+ *
+ * @param config a #Configuration as returned by configuration_new()
+ * @param input the name of the new log level
+ *
+ * @returns TRUE if input names a log level, FALSE if nothing was changed
+ */
+gboolean configuration_setLogLevel(Configuration* config, const gchar* input);
+
 /**
  * Get the configured log level at which heartbeat messages are printed,
  * based on command line input.
@@ -310,6 +364,65 @@ GLogLevelFlags configuration_getLogLevel(Configuration* config);
  */
 GLogLevelFlags configuration_getHeartbeatLogLevel(Configuration* config);
 
+/**
+ * Get the file to which heartbeat statistics are written as CSV rows instead
+ * of being logged.
+ *
+ * @param config a #Configuration as returned by configuration_new()
+ *
+ * @returns the command line heartbeat file name, or NULL to log heartbeats
+ */
+const gchar* configuration_getHeartbeatFilename(Configuration* config);
+
+/**
+ * Get the file to which the results that plug-ins record are written as CSV
+ * rows, stamped with simulation time.
+ *
+ * @param config a #Configuration as returned by configuration_new()
+ *
+ * @returns the command line metrics file name, or NULL if metrics are dropped
+ */
+const gchar* configuration_getMetricsFilename(Configuration* config);
+
+/**
+ * Get the directory holding compiled topologies, keyed by a hash of the
+ * input file they were parsed from.
+ *
+ * @param config a #Configuration as returned by configuration_new()
+ *
+ * @returns the command line cache directory, or NULL to always parse
+ */
+const gchar* configuration_getTopologyCacheDirectory(Configuration* config);
+
+/**
+ * Get the file to which per-event-type and per-node execution times are
+ * written at shutdown.
+ *
+ * @param config a #Configuration as returned by configuration_new()
+ *
+ * @returns the command line profile file name, or NULL if not profiling
+ */
+const gchar* configuration_getProfileFilename(Configuration* config);
+
+/**
+ * Check if the profile is written as folded stacks rather than CSV rows.
+ *
+ * @param config a #Configuration as returned by configuration_new()
+ *
+ * @returns TRUE if folded stacks were requested on the command line
+ */
+gboolean configuration_getProfileFolded(Configuration* config);
+
+/**
+ * Get the path of the Unix-domain socket on which the running simulation can
+ * be queried and controlled.
+ *
+ * @param config a #Configuration as returned by configuration_new()
+ *
+ * @returns the command line control socket path, or NULL if disabled
+ */
+const gchar* configuration_getControlSocketPath(Configuration* config);
+
 /**
  * Get the configured heartbeat printing interval.
  * @param config a #Configuration object created with configuration_new()
@@ -317,6 +430,14 @@ GLogLevelFlags configuration_getHeartbeatLogLevel(Configuration* config);
  */
 SimulationTime configuration_getHearbeatInterval(Configuration* config);
 
+/**
+ * Get how far away a node's next event must be before its plug-in state is
+ * compressed while it waits.
+ * @param config a #Configuration object created with configuration_new()
+ * @return the hibernation horizon as SimulationTime, or 0 if disabled
+ */
+SimulationTime configuration_getHibernateHorizon(Configuration* config);
+
 /**
  * Get the string form that represents the queuing discipline the network
  * interface uses to select which of the sendable sockets should get priority.
@@ -325,6 +446,31 @@ SimulationTime configuration_getHearbeatInterval(Configuration* config);
  */
 gchar* configuration_getQueuingDiscipline(Configuration* config);
 
+/**
+ * Get the string form of the model used to measure and charge the CPU time
+ * consumed by plug-ins to their virtual nodes.
+ * @param config a #Configuration object created with configuration_new()
+ * @return the CPU delay model string. the caller does not own the string.
+ */
+gchar* configuration_getCPUDelayModel(Configuration* config);
+
+/**
+ * Get the name of the congestion control algorithm TCP sockets use unless
+ * their node chooses another.
+ * @param config a #Configuration object created with configuration_new()
+ * @return the algorithm name. the caller does not own the string.
+ */
+gchar* configuration_getTCPCongestionControl(Configuration* config);
+
+/**
+ * Get the list of CPU costs to charge for intercepted public-key operations,
+ * overriding the defaults.
+ * @param config a #Configuration object created with configuration_new()
+ * @return the cost list string, or NULL if none was given. the caller does
+ * not own the string.
+ */
+gchar* configuration_getCryptoCosts(Configuration* config);
+
 /** @} */
 
 #endif /* SHD_CONFIGURATION_H_ */
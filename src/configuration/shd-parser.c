@@ -19,8 +19,83 @@
  * along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdio.h>
+#include <string.h>
+#include <lzma.h>
+
 #include "shadow.h"
 
+/* input files are read, decompressed, and parsed in chunks of this size */
+#define PARSER_CHUNK_SIZE 65536
+
+/* compiled topologies start with this, followed by the format version */
+#define PARSER_CACHE_MAGIC "SHDTOPO"
+#define PARSER_CACHE_VERSION 1
+#define PARSER_CACHE_NONE G_MAXUINT32
+
+/*
+ * a compiled topology holds the cdf, cluster, and link elements of one input
+ * file as fixed-size records. strings are stored once in a block after the
+ * records and referenced by their offset into it. the records are written
+ * in host byte order, since a cache is only ever read on the machine that
+ * wrote it.
+ */
+
+typedef struct _ParserCacheHeader ParserCacheHeader;
+struct _ParserCacheHeader {
+	gchar magic[8];
+	guint32 version;
+	guint32 nCDFs;
+	guint32 nClusters;
+	guint32 nLinks;
+	guint32 stringsLength;
+	/* keeps the records after the header 8-byte aligned */
+	guint32 padding;
+};
+
+typedef struct _ParserCacheCDF ParserCacheCDF;
+struct _ParserCacheCDF {
+	guint32 id;
+	guint32 path;
+	guint64 center;
+	guint64 width;
+	guint64 tail;
+};
+
+typedef struct _ParserCacheCluster ParserCacheCluster;
+struct _ParserCacheCluster {
+	guint32 id;
+	guint64 bandwidthdown;
+	guint64 bandwidthup;
+	gdouble packetloss;
+};
+
+typedef struct _ParserCacheLink ParserCacheLink;
+struct _ParserCacheLink {
+	guint32 source;
+	guint32 destination;
+	guint64 latency;
+	guint64 jitter;
+	gdouble packetloss;
+	guint64 latencymin;
+	guint64 latencyQ1;
+	guint64 latencymean;
+	guint64 latencyQ3;
+	guint64 latencymax;
+};
+
+/* the records collected while parsing a file that may be compiled */
+typedef struct _ParserCache ParserCache;
+struct _ParserCache {
+	/* false once we see an element that is not part of a topology */
+	gboolean isCacheable;
+	GString* strings;
+	GHashTable* stringOffsets;
+	GArray* cdfs;
+	GArray* clusters;
+	GArray* links;
+};
+
 /*
  * each action is given a priority so they are created in the correct order.
  * that way when e.g. a node needs a link to its network, the network
@@ -37,13 +112,125 @@ struct _Parser {
 	gint nChildApplications;
 
 	GQueue* actions;
+
+	/* where compiled topologies are kept, NULL to always parse */
+	gchar* cacheDirectory;
+	/* records of the file being parsed, NULL unless we will compile it */
+	ParserCache* cache;
 	MAGIC_DECLARE;
 };
 
 static void _parser_addAction(Parser* parser, Action* action) {
 	MAGIC_ASSERT(parser);
 	MAGIC_ASSERT(action);
-	g_queue_insert_sorted(parser->actions, action, action_compare, NULL);
+	/* the queue is sorted once per file, since topologies have many
+	 * thousands of links. pushing to the head keeps the order that inserting
+	 * sorted gave actions of equal priority. */
+	g_queue_push_head(parser->actions, action);
+}
+
+static ParserCache* _parsercache_new() {
+	ParserCache* cache = g_new0(ParserCache, 1);
+	cache->isCacheable = TRUE;
+	cache->strings = g_string_new(NULL);
+	cache->stringOffsets = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	cache->cdfs = g_array_new(FALSE, FALSE, sizeof(ParserCacheCDF));
+	cache->clusters = g_array_new(FALSE, FALSE, sizeof(ParserCacheCluster));
+	cache->links = g_array_new(FALSE, FALSE, sizeof(ParserCacheLink));
+	return cache;
+}
+
+static void _parsercache_free(ParserCache* cache) {
+	g_string_free(cache->strings, TRUE);
+	g_hash_table_destroy(cache->stringOffsets);
+	g_array_free(cache->cdfs, TRUE);
+	g_array_free(cache->clusters, TRUE);
+	g_array_free(cache->links, TRUE);
+	g_free(cache);
+}
+
+static guint32 _parsercache_addString(ParserCache* cache, const gchar* string) {
+	/* cluster ids repeat in every link, so store each of them once */
+	gpointer offset = NULL;
+	if(g_hash_table_lookup_extended(cache->stringOffsets, string, NULL, &offset)) {
+		return GPOINTER_TO_UINT(offset);
+	}
+
+	guint32 newOffset = (guint32) cache->strings->len;
+	g_string_append_len(cache->strings, string, strlen(string) + 1);
+	g_hash_table_insert(cache->stringOffsets, g_strdup(string), GUINT_TO_POINTER(newOffset));
+	return newOffset;
+}
+
+static void _parser_addCDF(Parser* parser, GString* id, GString* path,
+		guint64 center, guint64 width, guint64 tail) {
+	MAGIC_ASSERT(parser);
+
+	/* if a path is given, we ignore the other attributes */
+	if(path) {
+		Action* a = (Action*) loadcdf_new(id, path);
+		a->priority = 1;
+		_parser_addAction(parser, a);
+	} else {
+		Action* a = (Action*) generatecdf_new(id, center, width, tail);
+		a->priority = 1;
+		_parser_addAction(parser, a);
+	}
+
+	if(parser->cache) {
+		ParserCacheCDF record = {0};
+		record.id = _parsercache_addString(parser->cache, id->str);
+		record.path = path ? _parsercache_addString(parser->cache, path->str) : PARSER_CACHE_NONE;
+		record.center = center;
+		record.width = width;
+		record.tail = tail;
+		g_array_append_val(parser->cache->cdfs, record);
+	}
+}
+
+static void _parser_addCluster(Parser* parser, GString* id,
+		guint64 bandwidthdown, guint64 bandwidthup, gdouble packetloss) {
+	MAGIC_ASSERT(parser);
+
+	Action* a = (Action*) createnetwork_new(id, bandwidthdown, bandwidthup, packetloss);
+	a->priority = 2;
+	_parser_addAction(parser, a);
+
+	if(parser->cache) {
+		ParserCacheCluster record = {0};
+		record.id = _parsercache_addString(parser->cache, id->str);
+		record.bandwidthdown = bandwidthdown;
+		record.bandwidthup = bandwidthup;
+		record.packetloss = packetloss;
+		g_array_append_val(parser->cache->clusters, record);
+	}
+}
+
+static void _parser_addLink(Parser* parser, GString* srcCluster, GString* destCluster,
+		guint64 latency, guint64 jitter, gdouble packetloss, guint64 latencymin,
+		guint64 latencyQ1, guint64 latencymean, guint64 latencyQ3, guint64 latencymax) {
+	MAGIC_ASSERT(parser);
+
+	Action*  a = (Action*) connectnetwork_new(srcCluster, destCluster,
+			latency, jitter, packetloss,
+			latencymin, latencyQ1, latencymean, latencyQ3, latencymax);
+	a->priority = 3;
+	_parser_addAction(parser, a);
+
+	if(parser->cache) {
+		ParserCacheLink record = {0};
+		record.source = _parsercache_addString(parser->cache, srcCluster->str);
+		record.destination = _parsercache_addString(parser->cache, destCluster->str);
+		record.latency = latency;
+		record.jitter = jitter;
+		record.packetloss = packetloss;
+		record.latencymin = latencymin;
+		record.latencyQ1 = latencyQ1;
+		record.latencymean = latencymean;
+		record.latencyQ3 = latencyQ3;
+		record.latencymax = latencymax;
+		g_array_append_val(parser->cache->links, record);
+	}
 }
 
 static GError* _parser_handleCDFAttributes(Parser* parser, const gchar** attributeNames, const gchar** attributeValues) {
@@ -91,18 +278,8 @@ static GError* _parser_handleCDFAttributes(Parser* parser, const gchar** attribu
 	}
 
 	if(!error) {
-		/* no error, either load or generate a cdf
-		 * if a path is given, we ignore the other attributes
-		 */
-		if(path) {
-			Action* a = (Action*) loadcdf_new(id, path);
-			a->priority = 1;
-			_parser_addAction(parser, a);
-		} else {
-			Action* a = (Action*) generatecdf_new(id, center, width, tail);
-			a->priority = 1;
-			_parser_addAction(parser, a);
-		}
+		/* no error, either load or generate a cdf */
+		_parser_addCDF(parser, id, path, center, width, tail);
 	}
 
 	/* clean up */
@@ -159,9 +336,7 @@ static GError* _parser_handleClusterAttributes(Parser* parser, const gchar** att
 
 	if(!error) {
 		/* no error, create the action */
-		Action* a = (Action*) createnetwork_new(id, bandwidthdown, bandwidthup, packetloss);
-		a->priority = 2;
-		_parser_addAction(parser, a);
+		_parser_addCluster(parser, id, bandwidthdown, bandwidthup, packetloss);
 	}
 
 	/* clean up */
@@ -233,6 +408,8 @@ static GError* _parser_handleNodeAttributes(Parser* parser, const gchar** attrib
 	GString* heartbeatloglevel = NULL;
 	GString* logpcap = NULL;
 	GString* pcapdir = NULL;
+	GString* tcpcongestion = NULL;
+	GString* tcpsack = NULL;
 	guint64 bandwidthdown = 0;
 	guint64 bandwidthup = 0;
 	guint64 heartbeatfrequency = 0;
@@ -270,6 +447,14 @@ static GError* _parser_handleNodeAttributes(Parser* parser, const gchar** attrib
 			logpcap = g_string_new(value);
 		} else if (!pcapdir && !g_ascii_strcasecmp(name, "pcapdir")) {
 			pcapdir = g_string_new(value);
+		} else if (!tcpcongestion && !g_ascii_strcasecmp(name, "tcpcongestion")) {
+			tcpcongestion = g_string_new(value);
+			if(tcpcongestion_typeFromString(value) == TCP_CC_UNKNOWN) {
+				error = g_error_new(G_MARKUP_ERROR, G_MARKUP_ERROR_INVALID_CONTENT,
+						"unknown 'node' tcpcongestion '%s'", value);
+			}
+		} else if (!tcpsack && !g_ascii_strcasecmp(name, "tcpsack")) {
+			tcpsack = g_string_new(value);
 		} else if (!quantityIsSet && !g_ascii_strcasecmp(name, "quantity")) {
 			quantity = g_ascii_strtoull(value, NULL, 10);
 			quantityIsSet = TRUE;
@@ -307,7 +492,7 @@ static GError* _parser_handleNodeAttributes(Parser* parser, const gchar** attrib
 		Action* a = (Action*) createnodes_new(id, cluster,
 				bandwidthdown, bandwidthup, quantity, cpufrequency,
 				heartbeatfrequency, heartbeatloglevel, loglevel, logpcap, pcapdir,
-				socketReceiveBufferSize, socketSendBufferSize, interfaceReceiveBufferLength);
+				tcpcongestion, tcpsack, socketReceiveBufferSize, socketSendBufferSize, interfaceReceiveBufferLength);
 		a->priority = 5;
 		_parser_addAction(parser, a);
 
@@ -338,6 +523,12 @@ static GError* _parser_handleNodeAttributes(Parser* parser, const gchar** attrib
 	if(pcapdir) {
 		g_string_free(pcapdir, TRUE);
 	}
+	if(tcpcongestion) {
+		g_string_free(tcpcongestion, TRUE);
+	}
+	if(tcpsack) {
+		g_string_free(tcpsack, TRUE);
+	}
 
 	return error;
 }
@@ -458,11 +649,8 @@ static GError* _parser_handleLinkAttributes(Parser* parser, const gchar** attrib
 		g_strfreev(tokens);
 
 		/* no error, create the action */
-		Action*  a = (Action*) connectnetwork_new(srcCluster, destCluster,
-				latency, jitter, packetloss,
+		_parser_addLink(parser, srcCluster, destCluster, latency, jitter, packetloss,
 				latencymin, latencyQ1, latencymean, latencyQ3, latencymax);
-		a->priority = 3;
-		_parser_addAction(parser, a);
 	}
 
 	/* clean up */
@@ -575,6 +763,15 @@ static void _parser_handleNodeChildEndElement(GMarkupParseContext* context,
 	}
 }
 
+/* hosts depend on paths and plug-ins outside of the file, so only files
+ * holding nothing but topology elements are compiled */
+static void _parser_rejectCache(Parser* parser) {
+	MAGIC_ASSERT(parser);
+	if(parser->cache) {
+		parser->cache->isCacheable = FALSE;
+	}
+}
+
 static void _parser_handleRootStartElement(GMarkupParseContext* context,
 		const gchar* elementName, const gchar** attributeNames,
 		const gchar** attributeValues, gpointer userData, GError** error) {
@@ -593,12 +790,15 @@ static void _parser_handleRootStartElement(GMarkupParseContext* context,
 		*error = _parser_handleLinkAttributes(parser, attributeNames, attributeValues);
 	} else if (!g_ascii_strcasecmp(elementName, "plugin")) {
 		*error = _parser_handlePluginAttributes(parser, attributeNames, attributeValues);
+		_parser_rejectCache(parser);
 	} else if (!g_ascii_strcasecmp(elementName, "node")) {
 		*error = _parser_handleNodeAttributes(parser, attributeNames, attributeValues);
 		/* handle internal elements in a sub parser */
 		g_markup_parse_context_push(context, &(parser->nodeSubParser), parser);
+		_parser_rejectCache(parser);
 	} else if (!g_ascii_strcasecmp(elementName, "kill")) {
 		*error = _parser_handleKillAttributes(parser, attributeNames, attributeValues);
+		_parser_rejectCache(parser);
 	} else if (!g_ascii_strcasecmp(elementName, "hosts") ||
 			!g_ascii_strcasecmp(elementName, "topology")) {
 		/* do nothing, this is a root element */
@@ -668,7 +868,14 @@ Parser* parser_new() {
 	return parser;
 }
 
-gboolean parser_parseContents(Parser* parser, gchar* contents, gsize length, GQueue* actions) {
+void parser_setCacheDirectory(Parser* parser, const gchar* directory) {
+	MAGIC_ASSERT(parser);
+	g_free(parser->cacheDirectory);
+	parser->cacheDirectory = g_strdup(directory);
+}
+
+static gboolean _parser_parseChunk(Parser* parser, gchar* contents, gsize length, GQueue* actions) {
+	MAGIC_ASSERT(parser);
 
 	/* parse the contents, collecting actions. we store a pointer
 	 * to it in parser so we have access while parsing elements. */
@@ -691,30 +898,276 @@ gboolean parser_parseContents(Parser* parser, gchar* contents, gsize length, GQu
 	}
 }
 
-gboolean parser_parseFile(Parser* parser, GString* filename, GQueue* actions) {
+gboolean parser_parseContents(Parser* parser, gchar* contents, gsize length, GQueue* actions) {
+	gboolean success = _parser_parseChunk(parser, contents, length, actions);
+	g_queue_sort(actions, action_compare, NULL);
+	return success;
+}
+
+/* streams the file through the markup parser, decompressing it if needed */
+static gboolean _parser_parseStream(Parser* parser, const gchar* filename, gboolean isCompressed, GQueue* actions) {
 	MAGIC_ASSERT(parser);
-	g_assert(filename && actions);
 
-	gchar* content;
-	gsize length;
-	GError *error = NULL;
+	FILE* file = fopen(filename, "rb");
+	if(!file) {
+		error("fopen: unable to open '%s' for reading: %s", filename, g_strerror(errno));
+		return FALSE;
+	}
 
-	/* get the xml file */
-	gboolean success = g_file_get_contents(filename->str, &content, &length, &error);
+	gchar* in = g_malloc(PARSER_CHUNK_SIZE);
+	gchar* out = g_malloc(PARSER_CHUNK_SIZE);
+	lzma_stream xz = LZMA_STREAM_INIT;
+	gboolean success = TRUE;
 
-	/* check for success */
-	if (!success) {
-		error("g_file_get_contents: %s", error->message);
-		g_error_free(error);
+	if(isCompressed) {
+		lzma_ret ret = lzma_stream_decoder(&xz, G_MAXUINT64, LZMA_CONCATENATED);
+		if(ret != LZMA_OK) {
+			error("lzma_stream_decoder: unable to decompress '%s', error %i", filename, ret);
+			success = FALSE;
+		}
+	}
+
+	while(success) {
+		gsize length = fread(in, 1, PARSER_CHUNK_SIZE, file);
+		if(ferror(file)) {
+			error("fread: error reading '%s'", filename);
+			success = FALSE;
+			break;
+		}
+
+		if(!isCompressed) {
+			if(length == 0) {
+				break;
+			}
+			success = _parser_parseChunk(parser, in, length, actions);
+			continue;
+		}
+
+		/* parse everything this chunk decompresses to before reading more */
+		xz.next_in = (const uint8_t*) in;
+		xz.avail_in = length;
+		lzma_action action = feof(file) ? LZMA_FINISH : LZMA_RUN;
+		lzma_ret ret = LZMA_OK;
+
+		do {
+			xz.next_out = (uint8_t*) out;
+			xz.avail_out = PARSER_CHUNK_SIZE;
+			ret = lzma_code(&xz, action);
+
+			if(ret != LZMA_OK && ret != LZMA_STREAM_END) {
+				error("lzma_code: error %i decompressing '%s'", ret, filename);
+				success = FALSE;
+			} else if(xz.avail_out < PARSER_CHUNK_SIZE) {
+				success = _parser_parseChunk(parser, out, PARSER_CHUNK_SIZE - xz.avail_out, actions);
+			}
+		} while(success && ret != LZMA_STREAM_END && (xz.avail_in > 0 || xz.avail_out == 0));
+
+		if(!success || ret == LZMA_STREAM_END) {
+			break;
+		}
+		if(feof(file)) {
+			error("lzma_code: '%s' is truncated", filename);
+			success = FALSE;
+		}
+	}
+
+	if(isCompressed) {
+		lzma_end(&xz);
+	}
+	g_free(in);
+	g_free(out);
+	fclose(file);
+
+	return success;
+}
+
+/* compiled topologies are named by a hash of the input file they came from */
+static gchar* _parser_getCachePath(Parser* parser, const gchar* filename) {
+	MAGIC_ASSERT(parser);
+
+	FILE* file = fopen(filename, "rb");
+	if(!file) {
+		return NULL;
+	}
+
+	GChecksum* checksum = g_checksum_new(G_CHECKSUM_SHA256);
+	guchar* buffer = g_malloc(PARSER_CHUNK_SIZE);
+	gsize length = 0;
+	while((length = fread(buffer, 1, PARSER_CHUNK_SIZE, file)) > 0) {
+		g_checksum_update(checksum, buffer, length);
+	}
+	gboolean failed = ferror(file);
+	g_free(buffer);
+	fclose(file);
+
+	gchar* path = NULL;
+	if(!failed) {
+		gchar* name = g_strdup_printf("%s.topology", g_checksum_get_string(checksum));
+		path = g_build_filename(parser->cacheDirectory, name, NULL);
+		g_free(name);
+	}
+	g_checksum_free(checksum);
+
+	return path;
+}
+
+static gboolean _parser_readCache(Parser* parser, const gchar* path, GQueue* actions) {
+	MAGIC_ASSERT(parser);
+
+	GMappedFile* mapped = g_mapped_file_new(path, FALSE, NULL);
+	if(!mapped) {
+		return FALSE;
+	}
+
+	const gchar* contents = g_mapped_file_get_contents(mapped);
+	gsize length = g_mapped_file_get_length(mapped);
+
+	/* validate everything before creating any action */
+	const ParserCacheHeader* header = (const ParserCacheHeader*) contents;
+	gsize expected = sizeof(ParserCacheHeader);
+	if(length >= expected) {
+		expected += (header->nCDFs * sizeof(ParserCacheCDF)) +
+				(header->nClusters * sizeof(ParserCacheCluster)) +
+				(header->nLinks * sizeof(ParserCacheLink)) + header->stringsLength;
+	}
+	if(length < sizeof(ParserCacheHeader) || length != expected ||
+			memcmp(header->magic, PARSER_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+			header->version != PARSER_CACHE_VERSION ||
+			(header->stringsLength > 0 && contents[length - 1] != '\0')) {
+		warning("ignoring invalid compiled topology '%s'", path);
+		g_mapped_file_unref(mapped);
+		return FALSE;
+	}
+
+	const ParserCacheCDF* cdfs = (const ParserCacheCDF*) (contents + sizeof(ParserCacheHeader));
+	const ParserCacheCluster* clusters = (const ParserCacheCluster*) (cdfs + header->nCDFs);
+	const ParserCacheLink* links = (const ParserCacheLink*) (clusters + header->nClusters);
+	const gchar* strings = (const gchar*) (links + header->nLinks);
+
+	/* string offsets come from the file, so check them too */
+	gboolean isValid = TRUE;
+	for(guint32 i = 0; isValid && i < header->nCDFs; i++) {
+		isValid = cdfs[i].id < header->stringsLength &&
+				(cdfs[i].path == PARSER_CACHE_NONE || cdfs[i].path < header->stringsLength);
+	}
+	for(guint32 i = 0; isValid && i < header->nClusters; i++) {
+		isValid = clusters[i].id < header->stringsLength;
+	}
+	for(guint32 i = 0; isValid && i < header->nLinks; i++) {
+		isValid = links[i].source < header->stringsLength && links[i].destination < header->stringsLength;
+	}
+	if(!isValid) {
+		warning("ignoring invalid compiled topology '%s'", path);
+		g_mapped_file_unref(mapped);
 		return FALSE;
 	}
 
+	/* replay the records through the same functions the XML handlers use */
+	parser->actions = actions;
+	GString* id = g_string_new(NULL);
+	GString* other = g_string_new(NULL);
+
+	for(guint32 i = 0; i < header->nCDFs; i++) {
+		g_string_assign(id, &strings[cdfs[i].id]);
+		GString* cdfPath = NULL;
+		if(cdfs[i].path != PARSER_CACHE_NONE) {
+			cdfPath = g_string_assign(other, &strings[cdfs[i].path]);
+		}
+		_parser_addCDF(parser, id, cdfPath, cdfs[i].center, cdfs[i].width, cdfs[i].tail);
+	}
+	for(guint32 i = 0; i < header->nClusters; i++) {
+		g_string_assign(id, &strings[clusters[i].id]);
+		_parser_addCluster(parser, id, clusters[i].bandwidthdown,
+				clusters[i].bandwidthup, clusters[i].packetloss);
+	}
+	for(guint32 i = 0; i < header->nLinks; i++) {
+		const ParserCacheLink* l = &links[i];
+		g_string_assign(id, &strings[l->source]);
+		g_string_assign(other, &strings[l->destination]);
+		_parser_addLink(parser, id, other, l->latency, l->jitter, l->packetloss,
+				l->latencymin, l->latencyQ1, l->latencymean, l->latencyQ3, l->latencymax);
+	}
+
+	g_string_free(id, TRUE);
+	g_string_free(other, TRUE);
+	parser->actions = NULL;
+	g_mapped_file_unref(mapped);
+
+	message("loaded %u clusters and %u links from compiled topology '%s'",
+			header->nClusters, header->nLinks, path);
+	return TRUE;
+}
+
+static void _parser_writeCache(Parser* parser, const gchar* path) {
+	MAGIC_ASSERT(parser);
+	ParserCache* cache = parser->cache;
+
+	ParserCacheHeader header;
+	memset(&header, 0, sizeof(ParserCacheHeader));
+	memcpy(header.magic, PARSER_CACHE_MAGIC, sizeof(header.magic));
+	header.version = PARSER_CACHE_VERSION;
+	header.nCDFs = cache->cdfs->len;
+	header.nClusters = cache->clusters->len;
+	header.nLinks = cache->links->len;
+	header.stringsLength = cache->strings->len;
+
+	GString* contents = g_string_sized_new(sizeof(ParserCacheHeader) +
+			(header.nLinks * sizeof(ParserCacheLink)) + header.stringsLength);
+	g_string_append_len(contents, (const gchar*) &header, sizeof(ParserCacheHeader));
+	g_string_append_len(contents, cache->cdfs->data, header.nCDFs * sizeof(ParserCacheCDF));
+	g_string_append_len(contents, cache->clusters->data, header.nClusters * sizeof(ParserCacheCluster));
+	g_string_append_len(contents, cache->links->data, header.nLinks * sizeof(ParserCacheLink));
+	g_string_append_len(contents, cache->strings->str, header.stringsLength);
+
+	/* g_file_set_contents writes a temporary file and renames it, so
+	 * experiments sharing a cache never read a partial topology */
+	GError* error = NULL;
+	if(g_mkdir_with_parents(parser->cacheDirectory, 0755) != 0) {
+		warning("unable to create topology cache directory '%s': %s",
+				parser->cacheDirectory, g_strerror(errno));
+	} else if(!g_file_set_contents(path, contents->str, (gssize) contents->len, &error)) {
+		warning("unable to write compiled topology '%s': %s", path, error->message);
+		g_error_free(error);
+	} else {
+		message("wrote compiled topology to '%s'", path);
+	}
+
+	g_string_free(contents, TRUE);
+}
+
+gboolean parser_parseFile(Parser* parser, GString* filename, GQueue* actions) {
+	MAGIC_ASSERT(parser);
+	g_assert(filename && actions);
+
+	/* skip parsing if we compiled this exact file before */
+	gchar* cachePath = NULL;
+	if(parser->cacheDirectory) {
+		cachePath = _parser_getCachePath(parser, filename->str);
+		if(cachePath && _parser_readCache(parser, cachePath, actions)) {
+			g_queue_sort(actions, action_compare, NULL);
+			g_free(cachePath);
+			return TRUE;
+		}
+		if(cachePath) {
+			parser->cache = _parsercache_new();
+		}
+	}
+
 	/* do the actual parsing */
 	debug("attempting to parse XML file '%s'", filename->str);
-	gboolean result = parser_parseContents(parser, content, length, actions);
+	gboolean isCompressed = g_str_has_suffix(filename->str, ".xz");
+	gboolean result = _parser_parseStream(parser, filename->str, isCompressed, actions);
+	g_queue_sort(actions, action_compare, NULL);
 	debug("finished parsing XML file '%s'", filename->str);
 
-	g_free(content);
+	if(parser->cache) {
+		if(result && parser->cache->isCacheable) {
+			_parser_writeCache(parser, cachePath);
+		}
+		_parsercache_free(parser->cache);
+		parser->cache = NULL;
+	}
+	g_free(cachePath);
 
 	return result;
 }
@@ -724,6 +1177,7 @@ void parser_free(Parser* parser) {
 
 	/* cleanup */
 	g_markup_parse_context_free(parser->context);
+	g_free(parser->cacheDirectory);
 
 	MAGIC_CLEAR(parser);
 	g_free(parser);
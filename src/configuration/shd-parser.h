@@ -54,8 +54,19 @@ Parser* parser_new();
 void parser_free(Parser* parser);
 
 /**
- * Convenience function that reads the contents from a file and parses it
- * by calling parser_parseContents().
+ * Keep compiled topologies in the given directory. Input files that only hold
+ * topology elements (cdfs, clusters, and links) are then compiled to a binary
+ * file named by a hash of their contents, and parser_parseFile() loads that
+ * instead of parsing the file again.
+ *
+ * @param parser a pointer to a #Parser allocated with parser_new()
+ * @param directory the path to the cache directory, created if needed
+ */
+void parser_setCacheDirectory(Parser* parser, const gchar* directory);
+
+/**
+ * Reads the given file in chunks and parses it as it goes, decompressing it
+ * first if its name ends in '.xz'.
  *
  * @param parser a pointer to a #Parser allocated with parser_new()
  * @param filename a #GString holding the path to an XML file formated for
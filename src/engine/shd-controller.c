@@ -0,0 +1,271 @@
+/**
+ * The Shadow Simulator
+ *
+ * Copyright (c) 2010-2012 Rob Jansen <jansen@cs.umn.edu>
+ *
+ * This file is part of Shadow.
+ *
+ * Shadow is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shadow is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "shadow.h"
+
+/* how long a paused simulation waits for requests at a time */
+#define CONTROLLER_POLL_MILLISECONDS 100
+/* clients sending longer lines than this are disconnected */
+#define CONTROLLER_MAX_LINE_LENGTH 1024
+
+typedef struct _ControllerClient ControllerClient;
+struct _ControllerClient {
+	gint fd;
+	GString* input;
+};
+
+struct _Controller {
+	Engine* engine;
+	gchar* path;
+	gint listenFD;
+	GList* clients;
+	gboolean isPaused;
+	MAGIC_DECLARE;
+};
+
+static void _controller_setNonBlocking(gint fd) {
+	gint flags = fcntl(fd, F_GETFL, 0);
+	fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+Controller* controller_new(Engine* engine, const gchar* path) {
+	g_assert(engine && path);
+
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(struct sockaddr_un));
+	if(strlen(path) >= sizeof(address.sun_path)) {
+		warning("control socket path '%s' is too long", path);
+		return NULL;
+	}
+	address.sun_family = AF_UNIX;
+	g_strlcpy(address.sun_path, path, sizeof(address.sun_path));
+
+	gint fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0) {
+		warning("unable to create control socket: %s", g_strerror(errno));
+		return NULL;
+	}
+
+	/* a socket left over from an earlier run would make bind fail, but we
+	 * never remove anything that is not a socket */
+	struct stat status;
+	if(stat(path, &status) == 0 && S_ISSOCK(status.st_mode)) {
+		unlink(path);
+	}
+
+	if(bind(fd, (struct sockaddr*) &address, sizeof(struct sockaddr_un)) < 0 ||
+			listen(fd, 8) < 0) {
+		warning("unable to serve control socket at '%s': %s", path, g_strerror(errno));
+		close(fd);
+		return NULL;
+	}
+	_controller_setNonBlocking(fd);
+
+	Controller* controller = g_new0(Controller, 1);
+	MAGIC_INIT(controller);
+
+	controller->engine = engine;
+	controller->path = g_strdup(path);
+	controller->listenFD = fd;
+
+	message("serving control socket at '%s'", path);
+
+	return controller;
+}
+
+static void _controller_closeClient(ControllerClient* client) {
+	close(client->fd);
+	g_string_free(client->input, TRUE);
+	g_free(client);
+}
+
+void controller_free(Controller* controller) {
+	MAGIC_ASSERT(controller);
+
+	g_list_free_full(controller->clients, (GDestroyNotify) _controller_closeClient);
+	close(controller->listenFD);
+	unlink(controller->path);
+	g_free(controller->path);
+
+	MAGIC_CLEAR(controller);
+	g_free(controller);
+}
+
+gboolean controller_isPaused(Controller* controller) {
+	MAGIC_ASSERT(controller);
+	return controller->isPaused;
+}
+
+static void _controller_acceptClients(Controller* controller) {
+	gint fd = 0;
+	while((fd = accept(controller->listenFD, NULL, NULL)) >= 0) {
+		_controller_setNonBlocking(fd);
+
+		ControllerClient* client = g_new0(ControllerClient, 1);
+		client->fd = fd;
+		client->input = g_string_new(NULL);
+		controller->clients = g_list_append(controller->clients, client);
+	}
+}
+
+static void _controller_reply(ControllerClient* client, GString* reply) {
+	g_string_append_c(reply, '\n');
+
+	/* replies are small, a client that does not read them loses the rest */
+	gsize offset = 0;
+	while(offset < reply->len) {
+		gssize n = send(client->fd, reply->str + offset, reply->len - offset, MSG_NOSIGNAL);
+		if(n <= 0) {
+			break;
+		}
+		offset += (gsize) n;
+	}
+}
+
+static void _controller_handleRequest(Controller* controller, ControllerClient* client, gchar* line) {
+	gchar** words = g_strsplit(g_strstrip(line), " ", 2);
+	gchar* command = words[0];
+	gchar* argument = command ? words[1] : NULL;
+
+	GString* reply = g_string_new(NULL);
+
+	if(!command || command[0] == '\0') {
+		/* ignore empty lines */
+		g_string_free(reply, TRUE);
+		g_strfreev(words);
+		return;
+	} else if(!g_ascii_strcasecmp(command, "status")) {
+		engine_appendStatus(controller->engine, reply);
+	} else if(!g_ascii_strcasecmp(command, "pause")) {
+		if(!controller->isPaused) {
+			message("simulation paused from control socket");
+		}
+		controller->isPaused = TRUE;
+		g_string_append(reply, "{\"ok\":true}");
+	} else if(!g_ascii_strcasecmp(command, "resume")) {
+		if(controller->isPaused) {
+			message("simulation resumed from control socket");
+		}
+		controller->isPaused = FALSE;
+		g_string_append(reply, "{\"ok\":true}");
+	} else if(!g_ascii_strcasecmp(command, "loglevel")) {
+		Configuration* config = engine_getConfig(controller->engine);
+		if(argument && configuration_setLogLevel(config, g_strstrip(argument))) {
+			message("log level changed to '%s' from control socket", argument);
+			g_string_append(reply, "{\"ok\":true}");
+		} else {
+			g_string_append(reply, "{\"ok\":false,\"error\":\"unknown log level\"}");
+		}
+	} else {
+		g_string_append(reply, "{\"ok\":false,\"error\":\"unknown command\"}");
+	}
+
+	_controller_reply(client, reply);
+
+	g_string_free(reply, TRUE);
+	g_strfreev(words);
+}
+
+static gboolean _controller_readClient(Controller* controller, ControllerClient* client) {
+	/* take everything that is available now */
+	gchar buffer[CONTROLLER_MAX_LINE_LENGTH];
+	gboolean isOpen = TRUE;
+	while(TRUE) {
+		gssize n = recv(client->fd, buffer, sizeof(buffer), 0);
+		if(n > 0) {
+			g_string_append_len(client->input, buffer, n);
+		} else if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			break;
+		} else {
+			/* closed, or broken. the peer may only have shut down its side after
+			 * writing, so still answer what it sent before we close. */
+			isOpen = FALSE;
+			break;
+		}
+	}
+
+	/* handle each complete line */
+	gchar* newline = NULL;
+	while((newline = strchr(client->input->str, '\n')) != NULL) {
+		*newline = '\0';
+		_controller_handleRequest(controller, client, client->input->str);
+		g_string_erase(client->input, 0, (newline - client->input->str) + 1);
+	}
+
+	/* no newline will follow a last request */
+	if(!isOpen && client->input->len > 0 && client->input->len <= CONTROLLER_MAX_LINE_LENGTH) {
+		_controller_handleRequest(controller, client, client->input->str);
+		g_string_truncate(client->input, 0);
+	}
+
+	return (isOpen && client->input->len <= CONTROLLER_MAX_LINE_LENGTH) ? TRUE : FALSE;
+}
+
+static void _controller_readClients(Controller* controller) {
+	GList* item = controller->clients;
+	while(item) {
+		GList* next = g_list_next(item);
+		ControllerClient* client = item->data;
+		if(!_controller_readClient(controller, client)) {
+			_controller_closeClient(client);
+			controller->clients = g_list_delete_link(controller->clients, item);
+		}
+		item = next;
+	}
+}
+
+static void _controller_wait(Controller* controller) {
+	guint numFDs = 1 + g_list_length(controller->clients);
+	struct pollfd* fds = g_new0(struct pollfd, numFDs);
+
+	fds[0].fd = controller->listenFD;
+	fds[0].events = POLLIN;
+	guint i = 1;
+	for(GList* item = controller->clients; item; item = g_list_next(item)) {
+		ControllerClient* client = item->data;
+		fds[i].fd = client->fd;
+		fds[i].events = POLLIN;
+		i++;
+	}
+
+	poll(fds, numFDs, CONTROLLER_POLL_MILLISECONDS);
+	g_free(fds);
+}
+
+void controller_serve(Controller* controller) {
+	MAGIC_ASSERT(controller);
+
+	/* answer whatever is pending. while paused, we keep answering and the
+	 * simulation does not advance until someone resumes it. */
+	do {
+		_controller_acceptClients(controller);
+		_controller_readClients(controller);
+		if(controller->isPaused) {
+			_controller_wait(controller);
+		}
+	} while(controller->isPaused);
+}
@@ -0,0 +1,48 @@
+/**
+ * The Shadow Simulator
+ *
+ * Copyright (c) 2010-2012 Rob Jansen <jansen@cs.umn.edu>
+ *
+ * This file is part of Shadow.
+ *
+ * Shadow is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shadow is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHD_CONTROLLER_H_
+#define SHD_CONTROLLER_H_
+
+#include "shadow.h"
+
+/**
+ * Serves a Unix-domain socket on which operators can query a running
+ * simulation and control it. Each request is one line, and each reply is one
+ * line holding a JSON object. The requests are:
+ *
+ * - 'status': timing, event rates, worker load, queue depths and memory
+ * - 'pause': stop advancing simulation time, while still serving requests
+ * - 'resume': continue a paused simulation
+ * - 'loglevel LEVEL': change the global log level
+ *
+ * The controller is only ever used from the main thread, while no worker is
+ * running events.
+ */
+typedef struct _Controller Controller;
+
+Controller* controller_new(Engine* engine, const gchar* path);
+void controller_free(Controller* controller);
+
+void controller_serve(Controller* controller);
+gboolean controller_isPaused(Controller* controller);
+
+#endif /* SHD_CONTROLLER_H_ */
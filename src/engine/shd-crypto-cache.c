@@ -0,0 +1,209 @@
+/**
+ * The Shadow Simulator
+ *
+ * Copyright (c) 2010-2012 Rob Jansen <jansen@cs.umn.edu>
+ *
+ * This file is part of Shadow.
+ *
+ * Shadow is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shadow is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shadow.h"
+
+/* names used to configure the cost of each operation */
+static const gchar* cryptoOperationNames[CRYPTO_OPERATION_COUNT] = {
+	"rsa-public-encrypt",
+	"rsa-private-decrypt",
+	"rsa-private-encrypt",
+	"rsa-public-decrypt",
+	"dh-generate-key",
+	"dh-compute-key",
+	"ecdh-compute-key",
+};
+
+typedef struct _CryptoResult CryptoResult;
+struct _CryptoResult {
+	gint result;
+	GBytes* output;
+};
+
+struct _CryptoCache {
+	SimulationTime costs[CRYPTO_OPERATION_COUNT];
+
+	/* digest of the operation and its inputs, to a CryptoResult */
+	GHashTable* results;
+	/* digests in the order they were stored, so we can evict the oldest */
+	GQueue* digests;
+	guint capacity;
+
+	/* digest from the last missed lookup, waiting for its result */
+	GBytes* pendingDigest;
+
+	MAGIC_DECLARE;
+};
+
+static void _cryptocache_freeResult(CryptoResult* result) {
+	if(result->output) {
+		g_bytes_unref(result->output);
+	}
+	g_free(result);
+}
+
+static void _cryptocache_parseCosts(CryptoCache* cache, const gchar* costs) {
+	cache->costs[CRYPTO_RSA_PUBLIC_ENCRYPT] = CONFIG_CRYPTO_COST_RSA_PUBLIC;
+	cache->costs[CRYPTO_RSA_PRIVATE_DECRYPT] = CONFIG_CRYPTO_COST_RSA_PRIVATE;
+	cache->costs[CRYPTO_RSA_PRIVATE_ENCRYPT] = CONFIG_CRYPTO_COST_RSA_PRIVATE;
+	cache->costs[CRYPTO_RSA_PUBLIC_DECRYPT] = CONFIG_CRYPTO_COST_RSA_PUBLIC;
+	cache->costs[CRYPTO_DH_GENERATE_KEY] = CONFIG_CRYPTO_COST_DH;
+	cache->costs[CRYPTO_DH_COMPUTE_KEY] = CONFIG_CRYPTO_COST_DH;
+	cache->costs[CRYPTO_ECDH_COMPUTE_KEY] = CONFIG_CRYPTO_COST_ECDH;
+
+	if(!costs) {
+		return;
+	}
+
+	/* override defaults with a list like "dh-compute-key=400,rsa-private-decrypt=900" */
+	gchar** entries = g_strsplit(costs, ",", 0);
+	for(gint i = 0; entries[i] != NULL; i++) {
+		gchar** pair = g_strsplit(entries[i], "=", 2);
+		gboolean found = FALSE;
+
+		if(pair[0] && pair[1]) {
+			gchar* name = g_strstrip(pair[0]);
+			for(gint op = 0; op < CRYPTO_OPERATION_COUNT; op++) {
+				if(g_ascii_strcasecmp(name, cryptoOperationNames[op]) == 0) {
+					guint64 micros = g_ascii_strtoull(g_strstrip(pair[1]), NULL, 10);
+					cache->costs[op] = (SimulationTime) (micros * SIMTIME_ONE_MICROSECOND);
+					found = TRUE;
+					break;
+				}
+			}
+		}
+
+		if(!found && *(g_strstrip(entries[i])) != '\0') {
+			warning("ignoring invalid crypto cost entry '%s'", entries[i]);
+		}
+		g_strfreev(pair);
+	}
+	g_strfreev(entries);
+}
+
+CryptoCache* cryptocache_new(const gchar* costs, guint capacity) {
+	CryptoCache* cache = g_new0(CryptoCache, 1);
+	MAGIC_INIT(cache);
+
+	_cryptocache_parseCosts(cache, costs);
+
+	cache->results = g_hash_table_new_full(g_bytes_hash, g_bytes_equal,
+			(GDestroyNotify)g_bytes_unref, (GDestroyNotify)_cryptocache_freeResult);
+	cache->digests = g_queue_new();
+	cache->capacity = MAX(capacity, 1);
+
+	return cache;
+}
+
+void cryptocache_free(CryptoCache* cache) {
+	MAGIC_ASSERT(cache);
+
+	if(cache->pendingDigest) {
+		g_bytes_unref(cache->pendingDigest);
+	}
+	/* the queue holds no references of its own */
+	g_queue_free(cache->digests);
+	g_hash_table_destroy(cache->results);
+
+	MAGIC_CLEAR(cache);
+	g_free(cache);
+}
+
+SimulationTime cryptocache_getCost(CryptoCache* cache, CryptoOperation operation) {
+	MAGIC_ASSERT(cache);
+	g_assert(operation < CRYPTO_OPERATION_COUNT);
+	return cache->costs[operation];
+}
+
+static GBytes* _cryptocache_digest(CryptoOperation operation, gconstpointer key,
+		gsize keyLength, gconstpointer input, gsize inputLength) {
+	guint32 op = (guint32) operation;
+	guint64 length = (guint64) keyLength;
+
+	/* the key length separates the key from the input */
+	GChecksum* checksum = g_checksum_new(G_CHECKSUM_SHA256);
+	g_checksum_update(checksum, (const guchar*)&op, sizeof(guint32));
+	g_checksum_update(checksum, (const guchar*)&length, sizeof(guint64));
+	if(key && keyLength > 0) {
+		g_checksum_update(checksum, key, keyLength);
+	}
+	if(input && inputLength > 0) {
+		g_checksum_update(checksum, input, inputLength);
+	}
+
+	guint8 buffer[32];
+	gsize bufferLength = sizeof(buffer);
+	g_checksum_get_digest(checksum, buffer, &bufferLength);
+	g_checksum_free(checksum);
+
+	return g_bytes_new(buffer, bufferLength);
+}
+
+gboolean cryptocache_lookup(CryptoCache* cache, CryptoOperation operation,
+		gconstpointer key, gsize keyLength, gconstpointer input, gsize inputLength,
+		gpointer output, gint* result) {
+	MAGIC_ASSERT(cache);
+	g_assert(!cache->pendingDigest);
+
+	GBytes* digest = _cryptocache_digest(operation, key, keyLength, input, inputLength);
+	CryptoResult* cached = g_hash_table_lookup(cache->results, digest);
+
+	if(cached) {
+		if(cached->output) {
+			gsize outputLength = 0;
+			gconstpointer data = g_bytes_get_data(cached->output, &outputLength);
+			g_memmove(output, data, outputLength);
+		}
+		*result = cached->result;
+		g_bytes_unref(digest);
+		return TRUE;
+	}
+
+	/* remember what we looked for so the caller can store the real result */
+	cache->pendingDigest = digest;
+	return FALSE;
+}
+
+void cryptocache_store(CryptoCache* cache, gconstpointer output, gsize outputLength,
+		gint result) {
+	MAGIC_ASSERT(cache);
+
+	GBytes* digest = cache->pendingDigest;
+	if(!digest) {
+		return;
+	}
+	cache->pendingDigest = NULL;
+
+	/* make room by evicting the oldest results */
+	while(g_queue_get_length(cache->digests) >= cache->capacity) {
+		GBytes* oldest = g_queue_pop_head(cache->digests);
+		g_hash_table_remove(cache->results, oldest);
+	}
+
+	CryptoResult* stored = g_new0(CryptoResult, 1);
+	stored->result = result;
+	if(output && outputLength > 0) {
+		stored->output = g_bytes_new(output, outputLength);
+	}
+
+	g_hash_table_replace(cache->results, digest, stored);
+	g_queue_push_tail(cache->digests, digest);
+}
@@ -0,0 +1,55 @@
+/**
+ * The Shadow Simulator
+ *
+ * Copyright (c) 2010-2012 Rob Jansen <jansen@cs.umn.edu>
+ *
+ * This file is part of Shadow.
+ *
+ * Shadow is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shadow is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHD_CRYPTO_CACHE_H_
+#define SHD_CRYPTO_CACHE_H_
+
+#include "shadow.h"
+
+/**
+ * The public-key operations we intercept from plug-ins.
+ */
+typedef enum _CryptoOperation CryptoOperation;
+enum _CryptoOperation {
+	CRYPTO_RSA_PUBLIC_ENCRYPT,
+	CRYPTO_RSA_PRIVATE_DECRYPT,
+	CRYPTO_RSA_PRIVATE_ENCRYPT,
+	CRYPTO_RSA_PUBLIC_DECRYPT,
+	CRYPTO_DH_GENERATE_KEY,
+	CRYPTO_DH_COMPUTE_KEY,
+	CRYPTO_ECDH_COMPUTE_KEY,
+	CRYPTO_OPERATION_COUNT,
+};
+
+typedef struct _CryptoCache CryptoCache;
+
+CryptoCache* cryptocache_new(const gchar* costs, guint capacity);
+void cryptocache_free(CryptoCache* cache);
+
+SimulationTime cryptocache_getCost(CryptoCache* cache, CryptoOperation operation);
+
+gboolean cryptocache_lookup(CryptoCache* cache, CryptoOperation operation,
+		gconstpointer key, gsize keyLength, gconstpointer input, gsize inputLength,
+		gpointer output, gint* result);
+void cryptocache_store(CryptoCache* cache, gconstpointer output, gsize outputLength,
+		gint result);
+
+#endif /* SHD_CRYPTO_CACHE_H_ */
@@ -19,8 +19,21 @@
  * along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <unistd.h>
+
 #include "shadow.h"
 
+/* how much of its time a worker spent running events, and waiting for others */
+typedef struct _EngineWorkerLoad EngineWorkerLoad;
+struct _EngineWorkerLoad {
+	guint64 numEvents;
+	gdouble busySeconds;
+	gdouble idleSeconds;
+};
+
+/* the single-threaded engine serves the control socket after this many events */
+#define ENGINE_CONTROL_EVENTS 1024
+
 struct _Engine {
 	/* general configuration options for the simulation */
 	Configuration* config;
@@ -71,11 +84,32 @@ struct _Engine {
 	Random* random;
 
 	GMutex lock;
+	/* serializes the first instance of each plug-in, see engine_beginPluginInit */
 	GMutex pluginInitLock;
+	GHashTable* initializedPlugins;
 
 	gint rawFrequencyKHz;
 	guint numEventsCurrentInterval;
 	guint numNodesWithEventsCurrentInterval;
+	guint64 numEventsTotal;
+	/* loop iterations since operators last looked in, whether or not events completed */
+	guint numControlIterations;
+
+	/* metric rows that plug-ins recorded, as workers flush them */
+	FILE* metricsFile;
+
+	/* heartbeat rows from all workers, and their network-wide sums */
+	FILE* heartbeatFile;
+	TrackerCounters heartbeatTotals;
+	SimulationTime heartbeatTotalsTime;
+	SimulationTime lastHeartbeatTotalsTime;
+
+	/* optional socket for querying and controlling the running simulation */
+	Controller* controller;
+	/* worker profiles are merged here as the workers exit */
+	Profiler* profiler;
+	/* indexed by worker ID, where the main thread is 0 */
+	EngineWorkerLoad* workerLoad;
 
 	/* id generation counters, must be protected for thread safety */
 	volatile gint workerIDCounter;
@@ -102,6 +136,10 @@ Engine* engine_new(Configuration* config) {
 	engine->config = config;
 	engine->random = random_new(config->randomSeed);
 	engine->runTimer = g_timer_new();
+	engine->workerLoad = g_new0(EngineWorkerLoad, config->nWorkerThreads + 1);
+	if(config->profileFilename) {
+		engine->profiler = profiler_new();
+	}
 
 	/* holds all events if single-threaded, and non-node events otherwise. */
 	engine->masterEventQueue =
@@ -118,6 +156,7 @@ Engine* engine_new(Configuration* config) {
 
 	g_mutex_init(&(engine->lock));
 	g_mutex_init(&(engine->pluginInitLock));
+	engine->initializedPlugins = g_hash_table_new(g_direct_hash, g_direct_equal);
 
 	/* get the raw speed of the experiment machine */
 	gchar* contents = NULL;
@@ -143,6 +182,13 @@ void engine_free(Engine* engine) {
 	 */
 	internetwork_free(engine->internet);
 
+	/* plug-ins may have recorded results while being freed */
+	if(engine->metricsFile) {
+		worker_flushMetrics(worker_getPrivate());
+		fclose(engine->metricsFile);
+		engine->metricsFile = NULL;
+	}
+
 	/* we will never execute inside the plugin again */
 	engine->forceShadowContext = TRUE;
 
@@ -152,8 +198,20 @@ void engine_free(Engine* engine) {
 
 	registry_free(engine->registry);
 
+	if(engine->heartbeatFile) {
+		fclose(engine->heartbeatFile);
+	}
+	if(engine->controller) {
+		controller_free(engine->controller);
+	}
+	if(engine->profiler) {
+		profiler_free(engine->profiler);
+	}
+	g_free(engine->workerLoad);
+
 	GDateTime* dt_now = g_date_time_new_now_local();
     gchar* dt_format = g_date_time_format(dt_now, "%F %H:%M:%S");
+    message("processed %"G_GUINT64_FORMAT" events in total", engine->numEventsTotal);
     message("Shadow v%s shut down cleanly at %s", SHADOW_VERSION, dt_format);
     g_date_time_unref(dt_now);
     g_free(dt_format);
@@ -165,12 +223,92 @@ void engine_free(Engine* engine) {
 	random_free(engine->random);
 	g_mutex_clear(&(engine->lock));
 	g_mutex_clear(&(engine->pluginInitLock));
+	g_hash_table_destroy(engine->initializedPlugins);
 
 	MAGIC_CLEAR(engine);
 	shadow_engine = NULL;
 	g_free(engine);
 }
 
+static void _engine_writeHeartbeatTotals(Engine* engine) {
+	MAGIC_ASSERT(engine);
+
+	/* only the main thread calls this, while no worker is collecting */
+	if(engine->heartbeatTotals.numNodes == 0) {
+		return;
+	}
+
+	if(engine->heartbeatFile) {
+		GString* rows = g_string_new(NULL);
+		SimulationTime interval = engine->heartbeatTotalsTime - engine->lastHeartbeatTotalsTime;
+		tracker_appendHeartbeatRow(rows, engine->heartbeatTotalsTime, "*", interval, &(engine->heartbeatTotals));
+		fwrite(rows->str, 1, rows->len, engine->heartbeatFile);
+		g_string_free(rows, TRUE);
+	}
+
+	engine->lastHeartbeatTotalsTime = engine->heartbeatTotalsTime;
+	memset(&(engine->heartbeatTotals), 0, sizeof(TrackerCounters));
+}
+
+static void _engine_openHeartbeatFile(Engine* engine) {
+	MAGIC_ASSERT(engine);
+
+	const gchar* filename = configuration_getHeartbeatFilename(engine->config);
+	if(!filename) {
+		return;
+	}
+
+	engine->heartbeatFile = fopen(filename, "w");
+	if(!engine->heartbeatFile) {
+		warning("error trying to open heartbeat file '%s' for writing", filename);
+		return;
+	}
+
+	GString* header = g_string_new(NULL);
+	tracker_appendHeartbeatHeader(header);
+	fwrite(header->str, 1, header->len, engine->heartbeatFile);
+	g_string_free(header, TRUE);
+
+	message("writing node heartbeats to '%s'", filename);
+}
+
+static void _engine_openMetricsFile(Engine* engine) {
+	MAGIC_ASSERT(engine);
+
+	const gchar* filename = configuration_getMetricsFilename(engine->config);
+	if(!filename) {
+		return;
+	}
+
+	engine->metricsFile = fopen(filename, "w");
+	if(!engine->metricsFile) {
+		warning("error trying to open metrics file '%s' for writing", filename);
+		return;
+	}
+
+	fprintf(engine->metricsFile, "time,wall,node,plugin,name,value,tags\n");
+	message("writing plug-in metrics to '%s'", filename);
+}
+
+static void _engine_writeProfile(Engine* engine) {
+	MAGIC_ASSERT(engine);
+
+	if(!engine->profiler) {
+		return;
+	}
+
+	/* the workers have exited and added theirs, so add our own */
+	Worker* worker = worker_getPrivate();
+	if(worker->profiler) {
+		profiler_merge(engine->profiler, worker->profiler);
+	}
+
+	const gchar* filename = configuration_getProfileFilename(engine->config);
+	if(profiler_write(engine->profiler, filename, configuration_getProfileFolded(engine->config))) {
+		message("wrote event profile to '%s'", filename);
+	}
+}
+
 static gint _engine_processEvents(Engine* engine) {
 	MAGIC_ASSERT(engine);
 
@@ -181,10 +319,30 @@ static gint _engine_processEvents(Engine* engine) {
 		worker->clock_last = 0;
 		worker->cached_engine = engine;
 
+		/* we collect heartbeats for all nodes */
+		GList* nodeList = internetwork_getAllNodes(engine->internet);
+		GSList* nodes = NULL;
+		for(GList* item = nodeList; item; item = g_list_next(item)) {
+			nodes = g_slist_prepend(nodes, item->data);
+		}
+		g_list_free(nodeList);
+
 		/* process all events in the priority queue */
 		while(next_event && (next_event->time < engine->executeWindowEnd) &&
 				(next_event->time < engine->endTime))
 		{
+			/* let operators look in now and then */
+			if(engine->controller && ++engine->numControlIterations >= ENGINE_CONTROL_EVENTS) {
+				engine->numControlIterations = 0;
+				controller_serve(engine->controller);
+			}
+
+			/* every event before the heartbeat time has run */
+			if(next_event->time >= worker->nextHeartbeat) {
+				worker_heartbeat(worker, nodes, worker->nextHeartbeat);
+				_engine_writeHeartbeatTotals(engine);
+			}
+
 			/* get next event */
 			next_event = asyncpriorityqueue_pop(engine->masterEventQueue);
 			worker->cached_event = next_event;
@@ -199,6 +357,7 @@ static gint _engine_processEvents(Engine* engine) {
 			gboolean complete = shadowevent_run(worker->cached_event);
 			if(complete) {
 				shadowevent_free(worker->cached_event);
+				engine->numEventsTotal++;
 			}
 			worker->cached_event = NULL;
 			worker->cached_node = NULL;
@@ -207,6 +366,8 @@ static gint _engine_processEvents(Engine* engine) {
 
 			next_event = asyncpriorityqueue_peek(engine->masterEventQueue);
 		}
+
+		g_slist_free(nodes);
 	}
 
 	return 0;
@@ -255,6 +416,12 @@ static gint _engine_distributeEvents(Engine* engine) {
 		countdownlatch_countDownAwait(engine->processingLatch);
 
 		/* we are in control now, the workers are waiting at barrierLatch */
+		_engine_writeHeartbeatTotals(engine);
+
+		/* the workers are idle, so this is a safe time to look in */
+		if(engine->controller) {
+			controller_serve(engine->controller);
+		}
 		message("execution window [%lu--%lu] ran %u events from %u active nodes",
 				engine->executeWindowStart, engine->executeWindowEnd,
 				engine->numEventsCurrentInterval,
@@ -337,18 +504,30 @@ gint engine_run(Engine* engine) {
 	/* dont modify internet during simulation, since its not locked for threads */
 	internetwork_setReadOnly(engine->internet);
 
+	_engine_openHeartbeatFile(engine);
+	_engine_openMetricsFile(engine);
+
+	const gchar* controlSocketPath = configuration_getControlSocketPath(engine->config);
+	if(controlSocketPath) {
+		engine->controller = controller_new(engine, controlSocketPath);
+	}
+
 	/* simulation mode depends on configured number of workers */
+	gint retval = 0;
 	if(engine->config->nWorkerThreads > 0) {
 		/* multi threaded, manage the other workers */
 		engine->executeWindowStart = 0;
 		engine->executeWindowEnd = engine->minTimeJump;
-		return _engine_distributeEvents(engine);
+		retval = _engine_distributeEvents(engine);
 	} else {
 		/* single threaded, we are the only worker */
 		engine->executeWindowStart = 0;
 		engine->executeWindowEnd = G_MAXUINT64;
-		return _engine_processEvents(engine);
+		retval = _engine_processEvents(engine);
 	}
+
+	_engine_writeProfile(engine);
+	return retval;
 }
 
 void engine_pushEvent(Engine* engine, Event* event) {
@@ -436,13 +615,25 @@ gboolean engine_isForced(Engine* engine) {
 	return engine->forceShadowContext;
 }
 
-void engine_lockPluginInit(Engine* engine) {
+gboolean engine_beginPluginInit(Engine* engine, GQuark pluginID) {
 	MAGIC_ASSERT(engine);
+
+	/* waits here while the first instance of any plug-in initializes */
 	g_mutex_lock(&(engine->pluginInitLock));
+
+	if(g_hash_table_lookup_extended(engine->initializedPlugins, GUINT_TO_POINTER(pluginID), NULL, NULL)) {
+		/* shared libraries are set up, other instances may run concurrently */
+		g_mutex_unlock(&(engine->pluginInitLock));
+		return FALSE;
+	}
+
+	/* the caller is the first instance and holds the lock until its done */
+	return TRUE;
 }
 
-void engine_unlockPluginInit(Engine* engine) {
+void engine_endPluginInit(Engine* engine, GQuark pluginID) {
 	MAGIC_ASSERT(engine);
+	g_hash_table_replace(engine->initializedPlugins, GUINT_TO_POINTER(pluginID), GUINT_TO_POINTER(pluginID));
 	g_mutex_unlock(&(engine->pluginInitLock));
 }
 
@@ -478,14 +669,126 @@ gboolean engine_handleInterruptSignal(gpointer user_data) {
 	return FALSE;
 }
 
-void engine_notifyProcessed(Engine* engine, guint numberEventsProcessed, guint numberNodesWithEvents) {
+void engine_notifyProcessed(Engine* engine, gint workerID, guint numberEventsProcessed,
+		guint numberNodesWithEvents, gdouble busySeconds) {
 	MAGIC_ASSERT(engine);
+	g_assert(workerID >= 0 && workerID <= engine->config->nWorkerThreads);
+	EngineWorkerLoad* load = &(engine->workerLoad[workerID]);
+
 	_engine_lock(engine);
 	engine->numEventsCurrentInterval += numberEventsProcessed;
+	engine->numEventsTotal += numberEventsProcessed;
 	engine->numNodesWithEventsCurrentInterval += numberNodesWithEvents;
+	load->numEvents += numberEventsProcessed;
+	load->busySeconds += busySeconds;
 	_engine_unlock(engine);
+
+	gint64 waitStart = g_get_monotonic_time();
 	countdownlatch_countDownAwait(engine->processingLatch);
 	countdownlatch_countDownAwait(engine->barrierLatch);
+
+	/* only this worker writes its idle time */
+	load->idleSeconds += ((gdouble)(g_get_monotonic_time() - waitStart)) / G_USEC_PER_SEC;
+}
+
+static gsize _engine_getResidentBytes() {
+	/* the second field of statm is the resident set, in pages */
+	gchar* contents = NULL;
+	gsize residentPages = 0;
+	if(g_file_get_contents("/proc/self/statm", &contents, NULL, NULL)) {
+		gchar** fields = g_strsplit(contents, " ", 3);
+		if(fields[0] && fields[1]) {
+			residentPages = (gsize) g_ascii_strtoull(fields[1], NULL, 10);
+		}
+		g_strfreev(fields);
+		g_free(contents);
+	}
+	return residentPages * (gsize) sysconf(_SC_PAGESIZE);
+}
+
+void engine_appendStatus(Engine* engine, GString* status) {
+	MAGIC_ASSERT(engine);
+
+	/* called by the main thread while no worker runs, so nothing changes */
+	gdouble wallSeconds = g_timer_elapsed(engine->runTimer, NULL);
+	gboolean isMultiThreaded = engine->config->nWorkerThreads > 0 ? TRUE : FALSE;
+	SimulationTime simTime = isMultiThreaded ? engine->executeWindowEnd : engine->clock;
+
+	/* how full the queues are, and how evenly */
+	gsize numQueued = asyncpriorityqueue_getLength(engine->masterEventQueue);
+	gsize maxNodeQueued = 0;
+	GList* nodeList = internetwork_getAllNodes(engine->internet);
+	guint numNodes = g_list_length(nodeList);
+	for(GList* item = nodeList; item; item = g_list_next(item)) {
+		gsize length = eventqueue_getLength(node_getEvents((Node*) item->data));
+		numQueued += length;
+		maxNodeQueued = MAX(maxNodeQueued, length);
+	}
+	g_list_free(nodeList);
+
+	g_string_append_printf(status, "{\"paused\":%s,\"simtime\":%"G_GUINT64_FORMAT",\"walltime\":%f,"
+			"\"simSecondsPerWallSecond\":%f,\"events\":%"G_GUINT64_FORMAT",\"eventsPerSecond\":%f,"
+			"\"nodes\":%u,\"queuedEvents\":%"G_GSIZE_FORMAT",\"maxNodeQueuedEvents\":%"G_GSIZE_FORMAT",",
+			(engine->controller && controller_isPaused(engine->controller)) ? "true" : "false",
+			simTime, wallSeconds,
+			wallSeconds > 0 ? (((gdouble)simTime) / SIMTIME_ONE_SECOND) / wallSeconds : 0.0,
+			engine->numEventsTotal,
+			wallSeconds > 0 ? ((gdouble)engine->numEventsTotal) / wallSeconds : 0.0,
+			numNodes, numQueued, maxNodeQueued);
+
+	if(isMultiThreaded) {
+		/* the window that just ended */
+		g_string_append_printf(status, "\"window\":{\"start\":%"G_GUINT64_FORMAT",\"end\":%"G_GUINT64_FORMAT","
+				"\"events\":%u,\"activeNodes\":%u,\"utilisation\":%f},",
+				engine->executeWindowStart, engine->executeWindowEnd,
+				engine->numEventsCurrentInterval, engine->numNodesWithEventsCurrentInterval,
+				numNodes > 0 ? ((gdouble)engine->numNodesWithEventsCurrentInterval) / numNodes : 0.0);
+
+		g_string_append(status, "\"workers\":[");
+		for(gint i = 1; i <= engine->config->nWorkerThreads; i++) {
+			EngineWorkerLoad* load = &(engine->workerLoad[i]);
+			g_string_append_printf(status, "%s{\"id\":%i,\"events\":%"G_GUINT64_FORMAT",\"busy\":%f,\"idle\":%f}",
+					i > 1 ? "," : "", i, load->numEvents, load->busySeconds, load->idleSeconds);
+		}
+		g_string_append(status, "],");
+	}
+
+	g_string_append_printf(status, "\"memory\":{\"resident\":%"G_GSIZE_FORMAT"}}", _engine_getResidentBytes());
+}
+
+void engine_writeHeartbeats(Engine* engine, SimulationTime now, GString* rows, TrackerCounters* totals) {
+	MAGIC_ASSERT(engine);
+	_engine_lock(engine);
+	if(engine->heartbeatFile) {
+		fwrite(rows->str, 1, rows->len, engine->heartbeatFile);
+	}
+	tracker_addCounters(&(engine->heartbeatTotals), totals);
+	engine->heartbeatTotalsTime = now;
+	_engine_unlock(engine);
+}
+
+gboolean engine_isRecordingMetrics(Engine* engine) {
+	MAGIC_ASSERT(engine);
+	/* only changes before the workers start and after they exit */
+	return engine->metricsFile != NULL;
+}
+
+void engine_writeMetrics(Engine* engine, GString* rows) {
+	MAGIC_ASSERT(engine);
+	_engine_lock(engine);
+	if(engine->metricsFile) {
+		fwrite(rows->str, 1, rows->len, engine->metricsFile);
+	}
+	_engine_unlock(engine);
+}
+
+void engine_addProfile(Engine* engine, Profiler* profiler) {
+	MAGIC_ASSERT(engine);
+	_engine_lock(engine);
+	if(engine->profiler) {
+		profiler_merge(engine->profiler, profiler);
+	}
+	_engine_unlock(engine);
 }
 
 gint engine_nextRandomInt(Engine* engine) {
@@ -504,6 +807,23 @@ gdouble engine_nextRandomDouble(Engine* engine) {
 	return r;
 }
 
+guint engine_getNodeSeed(Engine* engine, const gchar* nodeName) {
+	MAGIC_ASSERT(engine);
+	g_assert(nodeName);
+
+	/* mix the global seed with the name, so seeds do not depend on the order
+	 * or thread in which nodes are created. the config is read-only here. */
+	guint64 x = ((guint64)engine->config->randomSeed << 32) ^ (guint64)g_str_hash(nodeName);
+
+	/* splitmix64 finalizer */
+	x += G_GUINT64_CONSTANT(0x9E3779B97F4A7C15);
+	x = (x ^ (x >> 30)) * G_GUINT64_CONSTANT(0xBF58476D1CE4E5B9);
+	x = (x ^ (x >> 27)) * G_GUINT64_CONSTANT(0x94D049BB133111EB);
+	x = x ^ (x >> 31);
+
+	return (guint) x;
+}
+
 guint engine_getRawCPUFrequency(Engine* engine) {
 	MAGIC_ASSERT(engine);
 	_engine_lock(engine);
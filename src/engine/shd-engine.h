@@ -46,7 +46,14 @@ gint engine_generateWorkerID(Engine* engine);
 gint engine_getNumThreads(Engine* engine);
 SimulationTime engine_getMinTimeJump(Engine* engine);
 SimulationTime engine_getExecutionBarrier(Engine* engine);
-void engine_notifyProcessed(Engine* engine, guint numberEventsProcessed, guint numberNodesWithEvents);
+void engine_notifyProcessed(Engine* engine, gint workerID, guint numberEventsProcessed,
+		guint numberNodesWithEvents, gdouble busySeconds);
+void engine_writeHeartbeats(Engine* engine, SimulationTime now, GString* rows, TrackerCounters* totals);
+void engine_addProfile(Engine* engine, Profiler* profiler);
+gboolean engine_isRecordingMetrics(Engine* engine);
+void engine_writeMetrics(Engine* engine, GString* rows);
+
+void engine_appendStatus(Engine* engine, GString* status);
 
 Configuration* engine_getConfig(Engine* engine);
 GTimer* engine_getRunTimer(Engine* engine);
@@ -58,14 +65,15 @@ void engine_setKillTime(Engine* engine, SimulationTime endTime);
 gboolean engine_isKilled(Engine* engine);
 gboolean engine_isForced(Engine* engine);
 
-void engine_lockPluginInit(Engine* engine);
-void engine_unlockPluginInit(Engine* engine);
+gboolean engine_beginPluginInit(Engine* engine, GQuark pluginID);
+void engine_endPluginInit(Engine* engine, GQuark pluginID);
 
 /* thread-safe */
 
 void engine_pushEvent(Engine* engine, Event* event);
 gint engine_nextRandomInt(Engine* engine);
 gdouble engine_nextRandomDouble(Engine* engine);
+guint engine_getNodeSeed(Engine* engine, const gchar* nodeName);
 guint engine_getRawCPUFrequency(Engine* engine);
 
 gboolean engine_cryptoSetup(Engine* engine, gint numLocks);
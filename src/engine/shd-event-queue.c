@@ -68,3 +68,15 @@ Event* eventqueue_pop(EventQueue* eventq) {
 Event* eventqueue_peek(EventQueue* eventq) {
 	return (Event*) asyncpriorityqueue_peek(eventq->events);
 }
+
+gsize eventqueue_getLength(EventQueue* eventq) {
+	MAGIC_ASSERT(eventq);
+	return asyncpriorityqueue_getLength(eventq->events);
+}
+
+gsize eventqueue_getMemoryUsage(EventQueue* eventq) {
+	MAGIC_ASSERT(eventq);
+	/* the events themselves belong to whoever scheduled them */
+	return sizeof(EventQueue) + asyncpriorityqueue_getLength(eventq->events) *
+			(sizeof(gpointer) + UTILITY_HASH_ENTRY_SIZE);
+}
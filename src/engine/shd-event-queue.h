@@ -30,6 +30,8 @@ void eventqueue_free(EventQueue* eventq);
 void eventqueue_push(EventQueue* eventq, Event* event);
 Event* eventqueue_peek(EventQueue* eventq);
 Event* eventqueue_pop(EventQueue* eventq);
+gsize eventqueue_getLength(EventQueue* eventq);
+gsize eventqueue_getMemoryUsage(EventQueue* eventq);
 
 
 #endif /* SHD_EVENT_QUEUE_H_ */
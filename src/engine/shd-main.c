@@ -94,6 +94,9 @@ gint shadow_main(gint argc, gchar* argv[]) {
 	/* store parsed actions from each user-configured simulation script  */
 	GQueue* actions = g_queue_new();
 	Parser* xmlParser = parser_new();
+	if(configuration_getTopologyCacheDirectory(config)) {
+		parser_setCacheDirectory(xmlParser, configuration_getTopologyCacheDirectory(config));
+	}
 
 	/* parse built-in examples, or input files */
 	gboolean success = TRUE;
@@ -20,15 +20,28 @@
  */
 
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 #include <glib/gstdio.h>
 
 #include "shadow.h"
 
+/* memfd_create is a GNU extension, but we dont build with _GNU_SOURCE */
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
 struct _Plugin {
 	GQuark id;
 	GString* path;
+	/* our private copy of the library, path is its name in /proc/self/fd */
+	gint file;
 	GModule* handle;
-	GTimer* delayTimer;
+	CPUTimer* delayTimer;
 
 	ShadowPluginInitializeFunc init;
 
@@ -41,6 +54,29 @@ struct _Plugin {
 	gpointer residentState;
 	PluginState defaultState;
 
+	/*
+	 * Every state is a private mapping of one unlinked file holding the
+	 * default state, so pages a node never writes stay shared by all nodes.
+	 * stateMapSize is residentStateSize rounded up to whole pages.
+	 */
+	gint defaultStateFile;
+	gsize stateMapSize;
+	gsize pageSize;
+	/* the state whose contents are currently in residentState, if any */
+	PluginState residentOwner;
+
+	/*
+	 * States of idle nodes, compressed as their differences from the default
+	 * state. Maps PluginState to a GByteArray; the state's own pages are
+	 * dropped while it is in here.
+	 */
+	GHashTable* hibernatedStates;
+	guint numHibernations;
+	guint numWakeups;
+	gsize hibernatedBytesIn;
+	gsize hibernatedBytesOut;
+	gint64 hibernationMicros;
+
 	gboolean isRegisterred;
 	/*
 	 * TRUE from when we've called into plug-in code until the call completes.
@@ -89,55 +125,167 @@ static GString* _plugin_getTemporaryFilePath(gchar* originalPath) {
 	return templatePath;
 }
 
-static gboolean _plugin_copyFile(gchar* fromPath, gchar* toPath) {
-	gchar* contents = NULL;
-	gsize length = 0;
-	GError* error = NULL;
+/*
+ * returns a descriptor to a file with no name in any directory, so it goes
+ * away with its last reference no matter how we exit.
+ */
+static gint _plugin_openAnonymousFile(gchar* name) {
+	gint fd = -1;
+
+#ifdef __NR_memfd_create
+	/* in memory, never touches the disk */
+	fd = (gint) syscall(__NR_memfd_create, name, MFD_CLOEXEC);
+	if(fd >= 0) {
+		return fd;
+	}
+#endif
+
+	/* kernel is too old, use a temporary file and unlink it right away */
+	GString* path = _plugin_getTemporaryFilePath(name);
+	fd = g_open(path->str, O_RDWR, 0);
+	g_unlink(path->str);
+	g_string_free(path, TRUE);
 
-	/* get the original file */
-	if(!g_file_get_contents(fromPath, &contents, &length, &error)) {
-		error("unable to read '%s' for copying: %s", fromPath, error->message);
+	return fd;
+}
+
+static gboolean _plugin_copyFile(gchar* fromPath, gint toFile) {
+	gint fromFile = g_open(fromPath, O_RDONLY, 0);
+	struct stat fromStat;
+	if(fromFile < 0 || fstat(fromFile, &fromStat) < 0) {
+		error("unable to read '%s' for copying: %s", fromPath, g_strerror(errno));
 		return FALSE;
 	}
-	error = NULL;
 
-	/* copy to the new file */
-	if(!g_file_set_contents(toPath, contents, (gssize)length, &error)) {
-		error("unable to write private copy of '%s' to '%s': %s",
-				fromPath, toPath, error->message);
-		return FALSE;
+	/* let the kernel copy, so the library never passes through our heap */
+	off_t offset = 0;
+	while(offset < fromStat.st_size) {
+		ssize_t n = sendfile(toFile, fromFile, &offset, (size_t)(fromStat.st_size - offset));
+		if(n <= 0) {
+			error("unable to write private copy of '%s': %s", fromPath,
+					n < 0 ? g_strerror(errno) : "unexpected end of file");
+			close(fromFile);
+			return FALSE;
+		}
 	}
 
-	/* ok, our private copy was created, cleanup */
-	g_free(contents);
+	close(fromFile);
 	return TRUE;
 }
 
+/* zero bytes in a row that are worth ending a literal run for */
+#define PLUGIN_HIBERNATE_MIN_RUN 8
+
+static void _plugin_appendWord(GByteArray* out, guint32 word) {
+	g_byte_array_append(out, (const guint8*) &word, sizeof(guint32));
+}
+
+static guint32 _plugin_readWord(const guint8* in) {
+	guint32 word;
+	memcpy(&word, in, sizeof(guint32));
+	return word;
+}
+
+/*
+ * Writes the differences between page and base as a series of
+ * (zeros, literals, literal bytes...) tokens, where literal bytes are the xor
+ * of the two. Pages are mostly unchanged from their defaults, so this is
+ * both fast and small.
+ */
+static void _plugin_encodePage(GByteArray* out, const guint8* page, const guint8* base, gsize length) {
+	gsize i = 0;
+	while(i < length) {
+		gsize start = i;
+		while(start < length && page[start] == base[start]) {
+			start++;
+		}
+
+		/* extend the literal until a long enough zero run or the end */
+		gsize end = start;
+		while(end < length) {
+			gsize run = 0;
+			while(end + run < length && run < PLUGIN_HIBERNATE_MIN_RUN &&
+					page[end + run] == base[end + run]) {
+				run++;
+			}
+			if(run >= PLUGIN_HIBERNATE_MIN_RUN || end + run == length) {
+				break;
+			}
+			end += run + 1;
+		}
+
+		_plugin_appendWord(out, (guint32) (start - i));
+		_plugin_appendWord(out, (guint32) (end - start));
+		for(gsize j = start; j < end; j++) {
+			guint8 delta = page[j] ^ base[j];
+			g_byte_array_append(out, &delta, 1);
+		}
+
+		i = end;
+	}
+}
+
+/* returns the number of encoded bytes consumed */
+static gsize _plugin_decodePage(const guint8* in, guint8* page, const guint8* base, gsize length) {
+	const guint8* start = in;
+	gsize i = 0;
+	while(i < length) {
+		i += _plugin_readWord(in);
+		guint32 literals = _plugin_readWord(in + sizeof(guint32));
+		in += 2 * sizeof(guint32);
+
+		/* only changed bytes are written, so only changed pages get copied */
+		for(guint32 j = 0; j < literals; j++) {
+			page[i + j] = base[i + j] ^ in[j];
+		}
+		in += literals;
+		i += literals;
+	}
+	return (gsize) (in - start);
+}
+
+static void _plugin_freeHibernatedState(GByteArray* compressed) {
+	g_byte_array_free(compressed, TRUE);
+}
+
 Plugin* plugin_new(GQuark id, GString* filename) {
 	g_assert(filename);
 	Plugin* plugin = g_new0(Plugin, 1);
 	MAGIC_INIT(plugin);
 
 	plugin->id = id;
+	plugin->defaultStateFile = -1;
+	plugin->hibernatedStates = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+			NULL, (GDestroyNotify) _plugin_freeHibernatedState);
 
 	/* timer for CPU delay measurements */
-	plugin->delayTimer = g_timer_new();
+	Configuration* config = engine_getConfig(worker_getPrivate()->cached_engine);
+	plugin->delayTimer = cputimer_new(cpu_getDelayModel(configuration_getCPUDelayModel(config)));
 
-	/* do not open the path directly, but rather copy to tmp directory first
-	 * to avoid multiple threads using the same memory space.
+	/* do not open the path directly, but rather load a private copy so each
+	 * worker gets its own globals. the copy is an anonymous file that is
+	 * released when we close it or exit, even if we crash.
 	 * TODO: this should eventually be replaced when we have thread-local
 	 * storage working correctly in the LLVM module-pass code
 	 */
-	plugin->path = _plugin_getTemporaryFilePath(filename->str);
-//	plugin->path = g_string_new(filename->str);
+	gchar* basename = g_path_get_basename(filename->str);
+	plugin->file = _plugin_openAnonymousFile(basename);
+	g_free(basename);
 
 	/* now we need to copy the actual contents to our new file */
-	if(!_plugin_copyFile(filename->str, plugin->path->str)) {
-		g_string_free(plugin->path, TRUE);
+	if(plugin->file < 0 || !_plugin_copyFile(filename->str, plugin->file)) {
+		if(plugin->file >= 0) {
+			close(plugin->file);
+		}
+		cputimer_free(plugin->delayTimer);
 		g_free(plugin);
 		return NULL;
 	}
 
+	/* the loader needs a path. it stays unique while we hold the descriptor */
+	plugin->path = g_string_new(NULL);
+	g_string_printf(plugin->path, "/proc/self/fd/%i", plugin->file);
+
 	/*
 	 * now get the plugin handle from our private copy of the library.
 	 *
@@ -152,7 +300,7 @@ Plugin* plugin_new(GQuark id, GString* filename) {
 	 */
 	plugin->handle = g_module_open(plugin->path->str, G_MODULE_BIND_LAZY|G_MODULE_BIND_LOCAL);
 	if(plugin->handle) {
-		message("successfully loaded private plug-in '%s' at %p", plugin->path->str, plugin);
+		message("successfully loaded private copy of plug-in '%s' as '%s' at %p", filename->str, plugin->path->str, plugin);
 	} else {
 		const gchar* errorMessage = g_module_error();
 		critical("g_module_open() failed: %s", errorMessage);
@@ -244,14 +392,28 @@ void plugin_free(gpointer data) {
 		}
 	}
 
-	/* TODO: this unlink should be removed when we no longer copy plugins
-	 * before loading them. see the other TODO above in this file.
-	 */
-	g_unlink(plugin->path->str);
+	if(plugin->numHibernations > 0) {
+		message("plug-in '%s' hibernated %u states and woke %u, compressing %"G_GSIZE_FORMAT
+				" bytes to %"G_GSIZE_FORMAT" bytes in %f seconds",
+				g_quark_to_string(plugin->id), plugin->numHibernations, plugin->numWakeups,
+				plugin->hibernatedBytesIn, plugin->hibernatedBytesOut,
+				((gdouble) plugin->hibernationMicros) / G_USEC_PER_SEC);
+	}
+	g_hash_table_destroy(plugin->hibernatedStates);
+
+	/* our private copy has no name, closing it is all the cleanup it needs */
+	close(plugin->file);
+
+	if(plugin->delayTimer) {
+		cputimer_free(plugin->delayTimer);
+	}
 	g_string_free(plugin->path, TRUE);
 
 	if(plugin->defaultState) {
-		plugin_freeState(plugin, plugin->defaultState);
+		munmap(plugin->defaultState, plugin->stateMapSize);
+	}
+	if(plugin->defaultStateFile >= 0) {
+		close(plugin->defaultStateFile);
 	}
 
 	MAGIC_CLEAR(plugin);
@@ -263,6 +425,35 @@ void plugin_setShadowContext(Plugin* plugin, gboolean isShadowContext) {
 	plugin->isShadowContext = isShadowContext;
 }
 
+static void _plugin_createDefaultState(Plugin* plugin) {
+	plugin->pageSize = (gsize) sysconf(_SC_PAGESIZE);
+	plugin->stateMapSize = ((plugin->residentStateSize + plugin->pageSize - 1) /
+			plugin->pageSize) * plugin->pageSize;
+
+	/* the file only needs to live as long as our descriptor and mappings */
+	gchar* name = g_strdup_printf("%s-state", g_quark_to_string(plugin->id));
+	plugin->defaultStateFile = _plugin_openAnonymousFile(name);
+	g_free(name);
+
+	if(plugin->defaultStateFile < 0 ||
+			ftruncate(plugin->defaultStateFile, (off_t)plugin->stateMapSize) < 0) {
+		error("unable to create default state file for plug-in '%s': %s",
+				plugin->path->str, g_strerror(errno));
+	}
+
+	plugin->defaultState = mmap(NULL, plugin->stateMapSize, PROT_READ|PROT_WRITE,
+			MAP_SHARED, plugin->defaultStateFile, 0);
+	if(plugin->defaultState == MAP_FAILED) {
+		error("unable to map default state for plug-in '%s': %s",
+				plugin->path->str, g_strerror(errno));
+	}
+
+	g_memmove(plugin->defaultState, plugin->residentState, plugin->residentStateSize);
+
+	/* nobody writes the defaults again */
+	mprotect(plugin->defaultState, plugin->stateMapSize, PROT_READ);
+}
+
 void plugin_registerResidentState(Plugin* plugin, PluginNewInstanceFunc new, PluginNotifyFunc free, PluginNotifyFunc notify) {
 	MAGIC_ASSERT(plugin);
 	if(plugin->isRegisterred) {
@@ -280,31 +471,123 @@ void plugin_registerResidentState(Plugin* plugin, PluginNewInstanceFunc new, Plu
 	/* also store a copy of the defaults as they exist now */
 	debug("copying resident plugin memory contents at %p-%p (%lu bytes) as default start state",
 			plugin->residentState, plugin->residentState+plugin->residentStateSize, plugin->residentStateSize);
-	plugin->defaultState = g_slice_copy(plugin->residentStateSize, plugin->residentState);
+	_plugin_createDefaultState(plugin);
 	debug("stored default state at %p", plugin->defaultState);
 
 	/* dont change our resident state or defaults */
 	plugin->isRegisterred = TRUE;
 }
 
+static void _plugin_saveResidentState(Plugin* plugin) {
+	PluginState state = plugin->residentOwner;
+	if(!state) {
+		return;
+	}
+
+	/* only write pages that changed, so the rest stay shared with the
+	 * default state instead of being copied on write */
+	for(gsize offset = 0; offset < plugin->residentStateSize; offset += plugin->pageSize) {
+		gsize length = MIN(plugin->pageSize, plugin->residentStateSize - offset);
+		gpointer saved = state + offset;
+		gpointer resident = plugin->residentState + offset;
+		if(memcmp(saved, resident, length) != 0) {
+			/* destination, source, size */
+			g_memmove(saved, resident, length);
+		}
+	}
+
+	plugin->residentOwner = NULL;
+}
+
+void plugin_hibernateState(Plugin* plugin, PluginState state) {
+	MAGIC_ASSERT(plugin);
+	g_assert(!plugin->isExecuting);
+
+	if(g_hash_table_lookup(plugin->hibernatedStates, state)) {
+		return;
+	}
+
+	gint64 startMicros = g_get_monotonic_time();
+
+	/* the state must be current before we read it */
+	if(plugin->residentOwner == state) {
+		_plugin_saveResidentState(plugin);
+	}
+
+	GByteArray* compressed = g_byte_array_new();
+	for(gsize offset = 0; offset < plugin->residentStateSize; offset += plugin->pageSize) {
+		gsize length = MIN(plugin->pageSize, plugin->residentStateSize - offset);
+		const guint8* page = state + offset;
+		const guint8* base = plugin->defaultState + offset;
+		if(memcmp(page, base, length) != 0) {
+			_plugin_appendWord(compressed, (guint32) (offset / plugin->pageSize));
+			_plugin_encodePage(compressed, page, base, length);
+		}
+	}
+
+	/* give our private pages back, the mapping falls back to the defaults */
+	if(madvise(state, plugin->stateMapSize, MADV_DONTNEED) < 0) {
+		warning("unable to release hibernated state of plug-in '%s': %s",
+				plugin->path->str, g_strerror(errno));
+	}
+
+	g_hash_table_replace(plugin->hibernatedStates, state, compressed);
+
+	plugin->numHibernations++;
+	plugin->hibernatedBytesIn += plugin->residentStateSize;
+	plugin->hibernatedBytesOut += compressed->len;
+	plugin->hibernationMicros += g_get_monotonic_time() - startMicros;
+}
+
+static void _plugin_wakeState(Plugin* plugin, PluginState state) {
+	GByteArray* compressed = g_hash_table_lookup(plugin->hibernatedStates, state);
+	if(!compressed) {
+		return;
+	}
+
+	gint64 startMicros = g_get_monotonic_time();
+
+	gsize position = 0;
+	while(position < compressed->len) {
+		gsize offset = _plugin_readWord(compressed->data + position) * plugin->pageSize;
+		position += sizeof(guint32);
+
+		gsize length = MIN(plugin->pageSize, plugin->residentStateSize - offset);
+		position += _plugin_decodePage(compressed->data + position,
+				state + offset, plugin->defaultState + offset, length);
+	}
+
+	g_hash_table_remove(plugin->hibernatedStates, state);
+
+	plugin->numWakeups++;
+	plugin->hibernationMicros += g_get_monotonic_time() - startMicros;
+}
+
 static void _plugin_startExecuting(Plugin* plugin, PluginState state) {
 	MAGIC_ASSERT(plugin);
 	g_assert(!plugin->isExecuting);
 
 	Worker* worker = worker_getPrivate();
 
-	/* context switch from shadow to plug-in library
-	 *
-	 * TODO: we can be smarter here - save a pointer to the last plugin that
-	 * was loaded... if the physical memory locations still has our state,
-	 * there is no need to copy it in again. similarly for stopExecuting()
-	 */
-	/* destination, source, size */
-	g_memmove(plugin->residentState, state, plugin->residentStateSize);
+	/* the node may have been idle long enough to be compressed */
+	_plugin_wakeState(plugin, state);
+
+	/* context switch from shadow to plug-in library. if the resident memory
+	 * still holds our state from last time, there is nothing to copy. */
+	if(plugin->residentOwner != state) {
+		_plugin_saveResidentState(plugin);
+
+		/* destination, source, size */
+		g_memmove(plugin->residentState, state, plugin->residentStateSize);
+		plugin->residentOwner = state;
+	}
 
 	plugin->isExecuting = TRUE;
 	worker->cached_plugin = plugin;
-	g_timer_start(plugin->delayTimer);
+	if(worker->profiler) {
+		profiler_startPlugin(worker->profiler);
+	}
+	cputimer_start(plugin->delayTimer);
 	plugin_setShadowContext(plugin, FALSE);
 }
 
@@ -316,15 +599,14 @@ static void _plugin_stopExecuting(Plugin* plugin, PluginState state) {
 	/* context switch back to shadow from plug-in library */
 	plugin_setShadowContext(plugin, TRUE);
 	plugin->isExecuting = FALSE;
-	/* no need to call stop */
-	gdouble elapsed = g_timer_elapsed(plugin->delayTimer, NULL);
-
-	SimulationTime delay = (SimulationTime) (elapsed * SIMTIME_ONE_SECOND);
-	cpu_addDelay(node_getCPU(worker->cached_node), delay);
+	SimulationTime delay = cputimer_stop(plugin->delayTimer, node_getCPU(worker->cached_node));
+	if(worker->profiler) {
+		profiler_stopPlugin(worker->profiler);
+	}
 	tracker_addProcessingTime(node_getTracker(worker->cached_node), delay);
 
-	/* destination, source, size */
-	g_memmove(state, plugin->residentState, plugin->residentStateSize);
+	/* our state stays resident until another state needs the memory */
+	g_assert(plugin->residentOwner == state);
 	worker->cached_plugin = NULL;
 }
 
@@ -332,16 +614,17 @@ void plugin_executeNew(Plugin* plugin, PluginState state, gint argcParam, gchar*
 	MAGIC_ASSERT(plugin);
 	_plugin_startExecuting(plugin, state);
 
-	/* FIXME:
-	 * this quick lock hack was thrown in because tor was segfaulting during its
-	 * global crypto initialization in OPENSSL_add_all_algorithms_noconf().
-	 * we should instead have a better way of globally initializing openssl once
-	 * instead of every time a virtual node is created.
+	/* the first instance of a plug-in may lazily set up libraries that all
+	 * instances share, so it runs alone. after that, instances start in
+	 * parallel. the Openssl global init that used to crash tor here is made
+	 * to run only once by our interposition library.
 	 */
 	Worker* worker = worker_getPrivate();
-	engine_lockPluginInit(worker->cached_engine);
+	gboolean isFirstInstance = engine_beginPluginInit(worker->cached_engine, plugin->id);
 	plugin->new(argcParam, argvParam);
-	engine_unlockPluginInit(worker->cached_engine);
+	if(isFirstInstance) {
+		engine_endPluginInit(worker->cached_engine, plugin->id);
+	}
 
 	_plugin_stopExecuting(plugin, state);
 }
@@ -369,12 +652,40 @@ void plugin_executeGeneric(Plugin* plugin, PluginState state, CallbackFunc callb
 
 PluginState plugin_newDefaultState(Plugin* plugin) {
 	MAGIC_ASSERT(plugin);
-	return g_slice_copy(plugin->residentStateSize, plugin->defaultState);
+
+	/* starts out sharing every page with the default state */
+	PluginState state = mmap(NULL, plugin->stateMapSize, PROT_READ|PROT_WRITE,
+			MAP_PRIVATE, plugin->defaultStateFile, 0);
+	if(state == MAP_FAILED) {
+		error("unable to map new state for plug-in '%s': %s",
+				plugin->path->str, g_strerror(errno));
+	}
+
+	return state;
 }
 
 void plugin_freeState(Plugin* plugin, gpointer state) {
 	MAGIC_ASSERT(plugin);
-	g_slice_free1(plugin->residentStateSize, state);
+
+	g_hash_table_remove(plugin->hibernatedStates, state);
+
+	/* whatever is resident belongs to nobody now */
+	if(plugin->residentOwner == state) {
+		plugin->residentOwner = NULL;
+	}
+
+	munmap(state, plugin->stateMapSize);
+}
+
+gpointer plugin_getSymbol(Plugin* plugin, const gchar* symbolName) {
+	MAGIC_ASSERT(plugin);
+
+	/* also searches the libraries the plug-in depends on */
+	gpointer symbol = NULL;
+	if(!g_module_symbol(plugin->handle, symbolName, &symbol)) {
+		return NULL;
+	}
+	return symbol;
 }
 
 GQuark* plugin_getID(Plugin* plugin) {
@@ -386,3 +697,15 @@ gboolean plugin_isShadowContext(Plugin* plugin) {
 	MAGIC_ASSERT(plugin);
 	return plugin->isShadowContext;
 }
+
+void plugin_pauseDelayTimer(Plugin* plugin) {
+	MAGIC_ASSERT(plugin);
+	g_assert(plugin->isExecuting);
+	cputimer_pause(plugin->delayTimer);
+}
+
+void plugin_resumeDelayTimer(Plugin* plugin) {
+	MAGIC_ASSERT(plugin);
+	g_assert(plugin->isExecuting);
+	cputimer_resume(plugin->delayTimer);
+}
@@ -32,10 +32,14 @@ void plugin_free(gpointer data);
 
 PluginState plugin_newDefaultState(Plugin* plugin);
 void plugin_freeState(Plugin* plugin, PluginState state);
+void plugin_hibernateState(Plugin* plugin, PluginState state);
 
 void plugin_setShadowContext(Plugin* plugin, gboolean isShadowContext);
 gboolean plugin_isShadowContext(Plugin* plugin);
 GQuark* plugin_getID(Plugin* plugin);
+gpointer plugin_getSymbol(Plugin* plugin, const gchar* symbolName);
+void plugin_pauseDelayTimer(Plugin* plugin);
+void plugin_resumeDelayTimer(Plugin* plugin);
 
 void plugin_registerResidentState(Plugin* plugin, PluginNewInstanceFunc new, PluginNotifyFunc free, PluginNotifyFunc notify);
 void plugin_executeNew(Plugin* plugin, PluginState state, gint argcParam, gchar* argvParam[]);
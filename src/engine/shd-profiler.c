@@ -0,0 +1,267 @@
+/**
+ * The Shadow Simulator
+ *
+ * Copyright (c) 2010-2012 Rob Jansen <jansen@cs.umn.edu>
+ *
+ * This file is part of Shadow.
+ *
+ * Shadow is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shadow is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shadow.h"
+
+typedef struct _ProfilerEntry ProfilerEntry;
+struct _ProfilerEntry {
+	guint64 count;
+	guint64 ticks;
+	guint64 pluginTicks;
+};
+
+struct _Profiler {
+	/* node ID -> (event name -> ProfilerEntry). event names are the static
+	 * strings from each event function table, so they hash by pointer. */
+	GHashTable* nodes;
+
+	/* the events table of the node we recorded last, since a worker runs
+	 * all of a node's events in a row */
+	GQuark lastNodeID;
+	GHashTable* lastNodeEvents;
+
+	/* plug-in time spent during the event that is running now */
+	guint64 pluginStartTicks;
+	guint64 pluginTicks;
+
+	/* used to convert ticks to seconds */
+	gint64 startMicros;
+	guint64 startTicks;
+
+	MAGIC_DECLARE;
+};
+
+guint64 profiler_getTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+	return (guint64) __builtin_ia32_rdtsc();
+#else
+	return ((guint64) g_get_monotonic_time()) * 1000;
+#endif
+}
+
+Profiler* profiler_new() {
+	Profiler* profiler = g_new0(Profiler, 1);
+	MAGIC_INIT(profiler);
+
+	profiler->nodes = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+			NULL, (GDestroyNotify) g_hash_table_destroy);
+	profiler->startMicros = g_get_monotonic_time();
+	profiler->startTicks = profiler_getTicks();
+
+	return profiler;
+}
+
+void profiler_free(Profiler* profiler) {
+	MAGIC_ASSERT(profiler);
+
+	g_hash_table_destroy(profiler->nodes);
+
+	MAGIC_CLEAR(profiler);
+	g_free(profiler);
+}
+
+void profiler_startPlugin(Profiler* profiler) {
+	MAGIC_ASSERT(profiler);
+	profiler->pluginStartTicks = profiler_getTicks();
+}
+
+void profiler_stopPlugin(Profiler* profiler) {
+	MAGIC_ASSERT(profiler);
+	profiler->pluginTicks += profiler_getTicks() - profiler->pluginStartTicks;
+}
+
+static ProfilerEntry* _profiler_getEntry(Profiler* profiler, GQuark nodeID, const gchar* eventName) {
+	if(!profiler->lastNodeEvents || profiler->lastNodeID != nodeID) {
+		GHashTable* events = g_hash_table_lookup(profiler->nodes, GUINT_TO_POINTER(nodeID));
+		if(!events) {
+			events = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+			g_hash_table_replace(profiler->nodes, GUINT_TO_POINTER(nodeID), events);
+		}
+		profiler->lastNodeID = nodeID;
+		profiler->lastNodeEvents = events;
+	}
+
+	ProfilerEntry* entry = g_hash_table_lookup(profiler->lastNodeEvents, eventName);
+	if(!entry) {
+		entry = g_new0(ProfilerEntry, 1);
+		g_hash_table_replace(profiler->lastNodeEvents, (gpointer) eventName, entry);
+	}
+	return entry;
+}
+
+void profiler_addEvent(Profiler* profiler, GQuark nodeID, const gchar* eventName, guint64 ticks) {
+	MAGIC_ASSERT(profiler);
+
+	ProfilerEntry* entry = _profiler_getEntry(profiler, nodeID, eventName);
+	entry->count++;
+	entry->ticks += ticks;
+
+	/* the plug-in ran inside this event, so never longer than it */
+	entry->pluginTicks += MIN(profiler->pluginTicks, ticks);
+	profiler->pluginTicks = 0;
+}
+
+void profiler_merge(Profiler* profiler, Profiler* other) {
+	MAGIC_ASSERT(profiler);
+	MAGIC_ASSERT(other);
+
+	GHashTableIter nodeIter;
+	gpointer nodeKey, nodeValue;
+	g_hash_table_iter_init(&nodeIter, other->nodes);
+	while(g_hash_table_iter_next(&nodeIter, &nodeKey, &nodeValue)) {
+		GHashTableIter eventIter;
+		gpointer eventKey, eventValue;
+		g_hash_table_iter_init(&eventIter, nodeValue);
+		while(g_hash_table_iter_next(&eventIter, &eventKey, &eventValue)) {
+			ProfilerEntry* from = eventValue;
+			ProfilerEntry* to = _profiler_getEntry(profiler, GPOINTER_TO_UINT(nodeKey), eventKey);
+			to->count += from->count;
+			to->ticks += from->ticks;
+			to->pluginTicks += from->pluginTicks;
+		}
+	}
+}
+
+static gint _profiler_compareNames(gconstpointer a, gconstpointer b) {
+	return g_strcmp0(*(const gchar**)a, *(const gchar**)b);
+}
+
+static void _profiler_appendCSVRow(GString* out, const gchar* nodeName, const gchar* eventName,
+		ProfilerEntry* entry, gdouble ticksPerSecond) {
+	gdouble seconds = entry->ticks / ticksPerSecond;
+	gdouble pluginSeconds = entry->pluginTicks / ticksPerSecond;
+	g_string_append_printf(out, "%s,%s,%"G_GUINT64_FORMAT",%f,%f,%f\n", nodeName, eventName,
+			entry->count, seconds, pluginSeconds, seconds - pluginSeconds);
+}
+
+gboolean profiler_write(Profiler* profiler, const gchar* filename, gboolean folded) {
+	MAGIC_ASSERT(profiler);
+
+	/* the tick rate is measured over our whole lifetime */
+	gdouble elapsedSeconds = ((gdouble)(g_get_monotonic_time() - profiler->startMicros)) / G_USEC_PER_SEC;
+	guint64 elapsedTicks = profiler_getTicks() - profiler->startTicks;
+	gdouble ticksPerSecond = (elapsedSeconds > 0 && elapsedTicks > 0) ? elapsedTicks / elapsedSeconds : 1;
+
+	/* sort by name so the output of repeated runs can be compared */
+	GArray* nodeNames = g_array_new(FALSE, FALSE, sizeof(const gchar*));
+	GHashTable* nodeByName = g_hash_table_new(g_str_hash, g_str_equal);
+	GHashTable* totals = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_free);
+	GArray* eventNames = g_array_new(FALSE, FALSE, sizeof(const gchar*));
+
+	GHashTableIter nodeIter;
+	gpointer nodeKey, nodeValue;
+	g_hash_table_iter_init(&nodeIter, profiler->nodes);
+	while(g_hash_table_iter_next(&nodeIter, &nodeKey, &nodeValue)) {
+		const gchar* nodeName = g_quark_to_string(GPOINTER_TO_UINT(nodeKey));
+		g_array_append_val(nodeNames, nodeName);
+		g_hash_table_replace(nodeByName, (gpointer) nodeName, nodeValue);
+	}
+	g_array_sort(nodeNames, _profiler_compareNames);
+
+	GString* out = g_string_new(NULL);
+	if(!folded) {
+		g_string_append(out, "node,event,count,seconds,plugin,shadow\n");
+	}
+
+	for(guint i = 0; i < nodeNames->len; i++) {
+		const gchar* nodeName = g_array_index(nodeNames, const gchar*, i);
+		GHashTable* events = g_hash_table_lookup(nodeByName, nodeName);
+
+		GArray* names = g_array_new(FALSE, FALSE, sizeof(const gchar*));
+		GHashTableIter eventIter;
+		gpointer eventKey, eventValue;
+		g_hash_table_iter_init(&eventIter, events);
+		while(g_hash_table_iter_next(&eventIter, &eventKey, &eventValue)) {
+			g_array_append_val(names, eventKey);
+		}
+		g_array_sort(names, _profiler_compareNames);
+
+		ProfilerEntry nodeTotal;
+		memset(&nodeTotal, 0, sizeof(ProfilerEntry));
+
+		for(guint j = 0; j < names->len; j++) {
+			const gchar* eventName = g_array_index(names, const gchar*, j);
+			ProfilerEntry* entry = g_hash_table_lookup(events, eventName);
+
+			if(folded) {
+				/* stack frames are node;event;where, weighted in nanoseconds */
+				guint64 pluginNanos = (guint64)((entry->pluginTicks / ticksPerSecond) * 1000000000.0);
+				guint64 shadowNanos = (guint64)(((entry->ticks - entry->pluginTicks) / ticksPerSecond) * 1000000000.0);
+				g_string_append_printf(out, "%s;%s;shadow %"G_GUINT64_FORMAT"\n", nodeName, eventName, shadowNanos);
+				if(pluginNanos > 0) {
+					g_string_append_printf(out, "%s;%s;plugin %"G_GUINT64_FORMAT"\n", nodeName, eventName, pluginNanos);
+				}
+			} else {
+				_profiler_appendCSVRow(out, nodeName, eventName, entry, ticksPerSecond);
+			}
+
+			nodeTotal.count += entry->count;
+			nodeTotal.ticks += entry->ticks;
+			nodeTotal.pluginTicks += entry->pluginTicks;
+
+			ProfilerEntry* eventTotal = g_hash_table_lookup(totals, eventName);
+			if(!eventTotal) {
+				eventTotal = g_new0(ProfilerEntry, 1);
+				g_hash_table_replace(totals, (gpointer) eventName, eventTotal);
+				g_array_append_val(eventNames, eventName);
+			}
+			eventTotal->count += entry->count;
+			eventTotal->ticks += entry->ticks;
+			eventTotal->pluginTicks += entry->pluginTicks;
+		}
+
+		/* '*' rows hold the sums over all event types or all nodes */
+		if(!folded) {
+			_profiler_appendCSVRow(out, nodeName, "*", &nodeTotal, ticksPerSecond);
+		}
+		g_array_free(names, TRUE);
+	}
+
+	if(!folded) {
+		g_array_sort(eventNames, _profiler_compareNames);
+		ProfilerEntry total;
+		memset(&total, 0, sizeof(ProfilerEntry));
+		for(guint i = 0; i < eventNames->len; i++) {
+			const gchar* eventName = g_array_index(eventNames, const gchar*, i);
+			ProfilerEntry* entry = g_hash_table_lookup(totals, eventName);
+			_profiler_appendCSVRow(out, "*", eventName, entry, ticksPerSecond);
+			total.count += entry->count;
+			total.ticks += entry->ticks;
+			total.pluginTicks += entry->pluginTicks;
+		}
+		_profiler_appendCSVRow(out, "*", "*", &total, ticksPerSecond);
+	}
+
+	GError* error = NULL;
+	gboolean success = g_file_set_contents(filename, out->str, out->len, &error);
+	if(!success) {
+		warning("error writing profile to '%s': %s", filename, error->message);
+		g_error_free(error);
+	}
+
+	g_string_free(out, TRUE);
+	g_array_free(eventNames, TRUE);
+	g_hash_table_destroy(totals);
+	g_hash_table_destroy(nodeByName);
+	g_array_free(nodeNames, TRUE);
+
+	return success;
+}
@@ -0,0 +1,48 @@
+/**
+ * The Shadow Simulator
+ *
+ * Copyright (c) 2010-2012 Rob Jansen <jansen@cs.umn.edu>
+ *
+ * This file is part of Shadow.
+ *
+ * Shadow is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shadow is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHD_PROFILER_H_
+#define SHD_PROFILER_H_
+
+#include "shadow.h"
+
+/**
+ * Counts how many events of each type every node runs and how much wall time
+ * they take, split into time spent inside plug-ins and time spent in Shadow.
+ * Each worker keeps its own profiler so recording never takes a lock; the
+ * engine merges them at shutdown and writes the result as CSV rows or as
+ * folded stacks that flamegraph.pl reads directly.
+ */
+typedef struct _Profiler Profiler;
+
+Profiler* profiler_new();
+void profiler_free(Profiler* profiler);
+
+guint64 profiler_getTicks();
+
+void profiler_startPlugin(Profiler* profiler);
+void profiler_stopPlugin(Profiler* profiler);
+void profiler_addEvent(Profiler* profiler, GQuark nodeID, const gchar* eventName, guint64 ticks);
+
+void profiler_merge(Profiler* profiler, Profiler* other);
+gboolean profiler_write(Profiler* profiler, const gchar* filename, gboolean folded);
+
+#endif /* SHD_PROFILER_H_ */
@@ -24,6 +24,8 @@
 #include <stddef.h>
 #include <sys/socket.h>
 #include <sys/time.h>
+#include <sys/uio.h>
+#include <limits.h>
 #include <netdb.h>
 #include <string.h>
 #include <fcntl.h>
@@ -42,6 +44,9 @@
 #ifndef SOCK_NONBLOCK
 #define SOCK_NONBLOCK 04000
 #endif
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
 
 enum SystemCallType {
 	SCT_BIND, SCT_CONNECT, SCT_GETSOCKNAME, SCT_GETPEERNAME,
@@ -403,15 +408,14 @@ gint system_getSockName(gint fd, struct sockaddr* addr, socklen_t* len) {
 	return _system_addressHelper(fd, addr, len, SCT_GETSOCKNAME);
 }
 
-gssize system_sendTo(gint fd, const gpointer buf, gsize n, gint flags,
-		const struct sockaddr* addr, socklen_t len) {
-	/* TODO flags are ignored */
-	/* check if this is a socket */
-	if(fd < MIN_DESCRIPTOR){
-		errno = EBADF;
-		return -1;
-	}
-
+/*
+ * The vector helpers hand the whole vector to the node as one transfer, so the
+ * transport (and the descriptor status) is only updated once per system call
+ * no matter how many segments the user passed in. Must be called in shadow
+ * context. Returns 0 or an errno value.
+ */
+static gint _system_sendVector(Node* node, gint fd, const struct iovec* iov,
+		gsize iovlen, const struct sockaddr* addr, socklen_t len, gsize* bytes) {
 	in_addr_t ip = 0;
 	in_port_t port = 0;
 
@@ -422,9 +426,93 @@ gssize system_sendTo(gint fd, const gpointer buf, gsize n, gint flags,
 		port = si->sin_port;
 	}
 
+	if(iovlen <= 1) {
+		/* nothing to gather */
+		gpointer buf = iovlen == 1 ? iov[0].iov_base : NULL;
+		gsize n = iovlen == 1 ? iov[0].iov_len : 0;
+		return node_sendUserData(node, fd, buf, n, ip, port, bytes);
+	}
+
+	gsize total = 0;
+	for(gsize i = 0; i < iovlen; i++) {
+		total += iov[i].iov_len;
+	}
+
+	/* gather into a single buffer so the transport only sees one write */
+	guchar* gathered = g_malloc(total);
+	gsize offset = 0;
+	for(gsize i = 0; i < iovlen; i++) {
+		memcpy(gathered + offset, iov[i].iov_base, iov[i].iov_len);
+		offset += iov[i].iov_len;
+	}
+
+	gint result = node_sendUserData(node, fd, gathered, total, ip, port, bytes);
+	g_free(gathered);
+
+	return result;
+}
+
+static gint _system_receiveVector(Node* node, gint fd, const struct iovec* iov,
+		gsize iovlen, struct sockaddr* addr, socklen_t* len, gsize* bytes) {
+	in_addr_t ip = 0;
+	in_port_t port = 0;
+	gint result = 0;
+
+	if(iovlen <= 1) {
+		/* nothing to scatter */
+		gpointer buf = iovlen == 1 ? iov[0].iov_base : NULL;
+		gsize n = iovlen == 1 ? iov[0].iov_len : 0;
+		result = node_receiveUserData(node, fd, buf, n, &ip, &port, bytes);
+	} else {
+		gsize total = 0;
+		for(gsize i = 0; i < iovlen; i++) {
+			total += iov[i].iov_len;
+		}
+
+		/* read everything at once, then scatter to the user's segments */
+		guchar* gathered = g_malloc(total);
+		result = node_receiveUserData(node, fd, gathered, total, &ip, &port, bytes);
+
+		if(result == 0) {
+			gsize offset = 0;
+			for(gsize i = 0; i < iovlen && offset < *bytes; i++) {
+				gsize copyLength = MIN(iov[i].iov_len, *bytes - offset);
+				memcpy(iov[i].iov_base, gathered + offset, copyLength);
+				offset += copyLength;
+			}
+		}
+
+		g_free(gathered);
+	}
+
+	/* check if they wanted to know where we got the data from */
+	if(result == 0 && addr != NULL && len != NULL && *len >= sizeof(struct sockaddr_in)) {
+		struct sockaddr_in* si = (struct sockaddr_in*) addr;
+		si->sin_addr.s_addr = ip;
+		si->sin_port = port;
+		si->sin_family = AF_INET;
+		*len = sizeof(struct sockaddr_in);
+	}
+
+	return result;
+}
+
+gssize system_sendTo(gint fd, const gpointer buf, gsize n, gint flags,
+		const struct sockaddr* addr, socklen_t len) {
+	/* TODO flags are ignored */
+	/* check if this is a socket */
+	if(fd < MIN_DESCRIPTOR){
+		errno = EBADF;
+		return -1;
+	}
+
+	struct iovec iov;
+	iov.iov_base = buf;
+	iov.iov_len = n;
+
 	Node* node = _system_switchInShadowContext();
 	gsize bytes = 0;
-	gint result = node_sendUserData(node, fd, buf, n, ip, port, &bytes);
+	gint result = _system_sendVector(node, fd, &iov, 1, addr, len, &bytes);
 	_system_switchOutShadowContext(node);
 
 	if(result != 0) {
@@ -439,16 +527,105 @@ gssize system_send(gint fd, const gpointer buf, gsize n, gint flags) {
 }
 
 gssize system_sendMsg(gint fd, const struct msghdr* message, gint flags) {
-	/* TODO implement */
-	warning("sendmsg not implemented");
-	errno = ENOSYS;
-	return -1;
+	/* TODO flags and control messages are ignored */
+	/* check if this is a socket */
+	if(fd < MIN_DESCRIPTOR){
+		errno = EBADF;
+		return -1;
+	}
+	if(message == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	Node* node = _system_switchInShadowContext();
+	gsize bytes = 0;
+	gint result = _system_sendVector(node, fd, message->msg_iov, message->msg_iovlen,
+			message->msg_name, message->msg_namelen, &bytes);
+	_system_switchOutShadowContext(node);
+
+	if(result != 0) {
+		errno = result;
+		return -1;
+	}
+	return (gssize) bytes;
+}
+
+gint system_sendMMsg(gint fd, struct mmsghdr* messages, guint numMessages, gint flags) {
+	/* TODO flags and control messages are ignored */
+	/* check if this is a socket */
+	if(fd < MIN_DESCRIPTOR){
+		errno = EBADF;
+		return -1;
+	}
+	if(messages == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	/* one context switch for the whole batch */
+	Node* node = _system_switchInShadowContext();
+	gint result = 0;
+	guint numSent = 0;
+	for(; numSent < numMessages; numSent++) {
+		struct msghdr* message = &(messages[numSent].msg_hdr);
+		gsize bytes = 0;
+		result = _system_sendVector(node, fd, message->msg_iov, message->msg_iovlen,
+				message->msg_name, message->msg_namelen, &bytes);
+		if(result != 0) {
+			break;
+		}
+		messages[numSent].msg_len = (guint) bytes;
+
+		/* a full TCP buffer cuts a message short. its bytes are already in the
+		 * stream, so like the kernel we count it, and msg_len tells the caller
+		 * where to resume before any later message goes out. */
+		gsize length = 0;
+		for(gsize i = 0; i < message->msg_iovlen; i++) {
+			length += message->msg_iov[i].iov_len;
+		}
+		if(bytes < length) {
+			numSent++;
+			break;
+		}
+	}
+	_system_switchOutShadowContext(node);
+
+	/* like the kernel, only report an error if nothing was sent */
+	if(numSent == 0 && result != 0) {
+		errno = result;
+		return -1;
+	}
+	return (gint) numSent;
 }
 
 gssize system_write(gint fd, const gpointer buf, gint n) {
 	return system_sendTo(fd, buf, n, 0, NULL, 0);
 }
 
+gssize system_writeV(gint fd, const struct iovec* iov, gint iovcnt) {
+	/* check if this is a socket */
+	if(fd < MIN_DESCRIPTOR){
+		errno = EBADF;
+		return -1;
+	}
+	if(iovcnt < 0 || iovcnt > IOV_MAX) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	Node* node = _system_switchInShadowContext();
+	gsize bytes = 0;
+	gint result = _system_sendVector(node, fd, iov, (gsize) iovcnt, NULL, 0, &bytes);
+	_system_switchOutShadowContext(node);
+
+	if(result != 0) {
+		errno = result;
+		return -1;
+	}
+	return (gssize) bytes;
+}
+
 gssize system_recvFrom(gint fd, gpointer buf, size_t n, gint flags,
 		struct sockaddr* addr, socklen_t* len) {
 	/* TODO flags are ignored */
@@ -458,28 +635,19 @@ gssize system_recvFrom(gint fd, gpointer buf, size_t n, gint flags,
 		return -1;
 	}
 
-	in_addr_t ip = 0;
-	in_port_t port = 0;
+	struct iovec iov;
+	iov.iov_base = buf;
+	iov.iov_len = n;
 
 	Node* node = _system_switchInShadowContext();
 	gsize bytes = 0;
-	gint result = node_receiveUserData(node, fd, buf, n, &ip, &port, &bytes);
+	gint result = _system_receiveVector(node, fd, &iov, 1, addr, len, &bytes);
 	_system_switchOutShadowContext(node);
 
 	if(result != 0) {
 		errno = result;
 		return -1;
 	}
-
-	/* check if they wanted to know where we got the data from */
-	if(addr != NULL && len != NULL && *len >= sizeof(struct sockaddr_in)) {
-		struct sockaddr_in* si = (struct sockaddr_in*) addr;
-		si->sin_addr.s_addr = ip;
-		si->sin_port = port;
-		si->sin_family = AF_INET;
-		*len = sizeof(struct sockaddr_in);
-	}
-
 	return (gssize) bytes;
 }
 
@@ -488,16 +656,101 @@ gssize system_recv(gint fd, gpointer buf, gsize n, gint flags) {
 }
 
 gssize system_recvMsg(gint fd, struct msghdr* message, gint flags) {
-	/* TODO implement */
-	warning("recvmsg not implemented");
-	errno = ENOSYS;
-	return -1;
+	/* TODO flags are ignored */
+	/* check if this is a socket */
+	if(fd < MIN_DESCRIPTOR){
+		errno = EBADF;
+		return -1;
+	}
+	if(message == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	Node* node = _system_switchInShadowContext();
+	gsize bytes = 0;
+	gint result = _system_receiveVector(node, fd, message->msg_iov, message->msg_iovlen,
+			message->msg_name, &(message->msg_namelen), &bytes);
+	_system_switchOutShadowContext(node);
+
+	if(result != 0) {
+		errno = result;
+		return -1;
+	}
+
+	/* we never have control messages or truncation to report */
+	message->msg_controllen = 0;
+	message->msg_flags = 0;
+
+	return (gssize) bytes;
+}
+
+gint system_recvMMsg(gint fd, struct mmsghdr* messages, guint numMessages,
+		gint flags, struct timespec* timeout) {
+	/* TODO flags are ignored. the timeout is irrelevant because we never block. */
+	/* check if this is a socket */
+	if(fd < MIN_DESCRIPTOR){
+		errno = EBADF;
+		return -1;
+	}
+	if(messages == NULL) {
+		errno = EFAULT;
+		return -1;
+	}
+
+	/* one context switch for the whole batch */
+	Node* node = _system_switchInShadowContext();
+	gint result = 0;
+	guint numReceived = 0;
+	for(; numReceived < numMessages; numReceived++) {
+		struct msghdr* message = &(messages[numReceived].msg_hdr);
+		gsize bytes = 0;
+		result = _system_receiveVector(node, fd, message->msg_iov, message->msg_iovlen,
+				message->msg_name, &(message->msg_namelen), &bytes);
+		if(result != 0) {
+			break;
+		}
+		message->msg_controllen = 0;
+		message->msg_flags = 0;
+		messages[numReceived].msg_len = (guint) bytes;
+	}
+	_system_switchOutShadowContext(node);
+
+	/* like the kernel, only report an error if nothing was received */
+	if(numReceived == 0 && result != 0) {
+		errno = result;
+		return -1;
+	}
+	return (gint) numReceived;
 }
 
 gssize system_read(gint fd, gpointer buf, gint n) {
 	return system_recvFrom(fd, buf, n, 0, NULL, 0);
 }
 
+gssize system_readV(gint fd, const struct iovec* iov, gint iovcnt) {
+	/* check if this is a socket */
+	if(fd < MIN_DESCRIPTOR){
+		errno = EBADF;
+		return -1;
+	}
+	if(iovcnt < 0 || iovcnt > IOV_MAX) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	Node* node = _system_switchInShadowContext();
+	gsize bytes = 0;
+	gint result = _system_receiveVector(node, fd, iov, (gsize) iovcnt, NULL, NULL, &bytes);
+	_system_switchOutShadowContext(node);
+
+	if(result != 0) {
+		errno = result;
+		return -1;
+	}
+	return (gssize) bytes;
+}
+
 gint system_getSockOpt(gint fd, gint level, gint optname, gpointer optval,
 		socklen_t* optlen) {
 	/* @todo: implement socket options */
@@ -897,3 +1150,55 @@ unsigned long system_cryptoIdFunc() {
 	Worker* worker = worker_getPrivate();
 	return ((unsigned long) (worker->thread_id));
 }
+
+gpointer system_cryptoGetFunction(const gchar* functionName) {
+	Node* node = _system_switchInShadowContext();
+	Worker* worker = worker_getPrivate();
+
+	/* the plug-in links Openssl, but it is loaded locally so only its own
+	 * handle can see the library */
+	gpointer function = plugin_getSymbol(worker->cached_plugin, functionName);
+	if(!function) {
+		critical("unable to find Openssl function '%s' in plug-in '%s'", functionName,
+				g_quark_to_string(*plugin_getID(worker->cached_plugin)));
+	}
+
+	_system_switchOutShadowContext(node);
+	return function;
+}
+
+gboolean system_cryptoBegin(CryptoOperation operation, gconstpointer key, gsize keyLength,
+		gconstpointer input, gsize inputLength, gpointer output, gint* result) {
+	Node* node = _system_switchInShadowContext();
+	Worker* worker = worker_getPrivate();
+
+	/* the node pays the configured cost whether or not we have the result */
+	SimulationTime cost = cryptocache_getCost(worker->cryptoCache, operation);
+	cpu_addDelay(node_getCPU(node), cost);
+	tracker_addProcessingTime(node_getTracker(node), cost);
+
+	gboolean isCached = FALSE;
+	if(key) {
+		isCached = cryptocache_lookup(worker->cryptoCache, operation, key, keyLength,
+				input, inputLength, output, result);
+	}
+
+	/* the real operation should not be measured on top of its cost */
+	if(!isCached) {
+		plugin_pauseDelayTimer(worker->cached_plugin);
+	}
+
+	_system_switchOutShadowContext(node);
+	return isCached;
+}
+
+void system_cryptoEnd(gconstpointer output, gsize outputLength, gint result) {
+	Node* node = _system_switchInShadowContext();
+	Worker* worker = worker_getPrivate();
+
+	/* no-op unless the matching begin missed in the cache */
+	cryptocache_store(worker->cryptoCache, output, outputLength, result);
+	plugin_resumeDelayTimer(worker->cached_plugin);
+
+	_system_switchOutShadowContext(node);
+}
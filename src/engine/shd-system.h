@@ -27,9 +27,19 @@
 #include <stddef.h>
 #include <sys/socket.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <netdb.h>
 #include <string.h>
 
+/* sendmmsg and recvmmsg are GNU extensions, but we dont build with _GNU_SOURCE.
+ * this matches the layout of the kernel and glibc definition. */
+#ifndef __USE_GNU
+struct mmsghdr {
+	struct msghdr msg_hdr;
+	unsigned int msg_len;
+};
+#endif
+
 gint system_epollCreate(gint size);
 gint system_epollCreate1(gint flags);
 gint system_epollCtl(gint epollDescriptor, gint operation, gint fileDescriptor,
@@ -55,6 +65,9 @@ gssize system_recvFrom(gint fd, gpointer buf, size_t n, gint flags,
 		struct sockaddr* addr, socklen_t* len);
 gssize system_sendMsg(gint fd, const struct msghdr* message, gint flags);
 gssize system_recvMsg(gint fd, struct msghdr* message, gint flags);
+gint system_sendMMsg(gint fd, struct mmsghdr* messages, guint numMessages, gint flags);
+gint system_recvMMsg(gint fd, struct mmsghdr* messages, guint numMessages,
+		gint flags, struct timespec* timeout);
 gint system_getSockOpt(gint fd, gint level, gint optname, gpointer optval,
 		socklen_t* optlen);
 gint system_setSockOpt(gint fd, gint level, gint optname, const gpointer optval,
@@ -63,6 +76,8 @@ gint system_listen(gint fd, gint backlog);
 gint system_shutdown(gint fd, gint how);
 gssize system_read(gint fd, gpointer buf, gint n);
 gssize system_write(gint fd, const gpointer buf, gint n);
+gssize system_readV(gint fd, const struct iovec* iov, gint iovcnt);
+gssize system_writeV(gint fd, const struct iovec* iov, gint iovcnt);
 gint system_close(gint fd);
 gint system_fcntl(int fd, int cmd, va_list farg);
 
@@ -95,6 +110,10 @@ gint system_randomBytes(guchar* buf, gint numBytes);
 gint system_getRandom();
 void system_cryptoLockingFunc(int mode, int n, const char *file, int line);
 unsigned long system_cryptoIdFunc();
+gpointer system_cryptoGetFunction(const gchar* functionName);
+gboolean system_cryptoBegin(CryptoOperation operation, gconstpointer key, gsize keyLength,
+		gconstpointer input, gsize inputLength, gpointer output, gint* result);
+void system_cryptoEnd(gconstpointer output, gsize outputLength, gint result);
 
 gpointer system_malloc(gsize size);
 void system_free(gpointer ptr);
@@ -21,6 +21,9 @@
 
 #include "shadow.h"
 
+/* metric rows are handed to the engine once a worker buffered this many bytes */
+#define WORKER_METRICS_FLUSH_BYTES 65536
+
 static Worker* _worker_new(Engine* engine) {
 	Worker* worker = g_new0(Worker, 1);
 	MAGIC_INIT(worker);
@@ -30,10 +33,19 @@ static Worker* _worker_new(Engine* engine) {
 	worker->clock_now = SIMTIME_INVALID;
 	worker->clock_last = SIMTIME_INVALID;
 	worker->clock_barrier = SIMTIME_INVALID;
+	worker->nextHeartbeat = 0;
 
 	/* each worker needs a private copy of each plug-in library */
 	worker->plugins = g_hash_table_new_full(g_int_hash, g_int_equal, NULL, plugin_free);
 
+	/* public-key results are shared by all nodes run by this worker */
+	worker->cryptoCache = cryptocache_new(configuration_getCryptoCosts(engine_getConfig(engine)),
+			CONFIG_CRYPTO_CACHE_SIZE);
+
+	if(configuration_getProfileFilename(engine_getConfig(engine))) {
+		worker->profiler = profiler_new();
+	}
+
 	return worker;
 }
 
@@ -43,6 +55,16 @@ void worker_free(gpointer data) {
 
 	/* calls the destroy functions we specified in g_hash_table_new_full */
 	g_hash_table_destroy(worker->plugins);
+	cryptocache_free(worker->cryptoCache);
+	if(worker->profiler) {
+		profiler_free(worker->profiler);
+	}
+	if(worker->heartbeatRows) {
+		g_string_free(worker->heartbeatRows, TRUE);
+	}
+	if(worker->metricRows) {
+		g_string_free(worker->metricRows, TRUE);
+	}
 
 	MAGIC_CLEAR(worker);
 	g_free(worker);
@@ -143,6 +165,14 @@ static guint _worker_processNode(Worker* worker, Node* node, SimulationTime barr
 		nextEvent = eventqueue_peek(eventq);
 	}
 
+	/* a node that just ran and then waits a long time need not keep its
+	 * plug-in state uncompressed. nodes that did not run are unchanged. */
+	SimulationTime horizon = configuration_getHibernateHorizon(engine_getConfig(worker->cached_engine));
+	if(nEventsProcessed > 0 && horizon > 0 &&
+			(!nextEvent || nextEvent->time - worker->clock_barrier > horizon)) {
+		node_hibernate(worker->cached_node);
+	}
+
 	/* unlock, clear cache */
 	node_unlock(worker->cached_node);
 	worker->cached_node = NULL;
@@ -151,13 +181,108 @@ static guint _worker_processNode(Worker* worker, Node* node, SimulationTime barr
 	return nEventsProcessed;
 }
 
+void worker_heartbeat(Worker* worker, GSList* nodes, SimulationTime now) {
+	MAGIC_ASSERT(worker);
+
+	/* rows go to the heartbeat file if there is one, otherwise each node logs */
+	GString* rows = NULL;
+	if(configuration_getHeartbeatFilename(engine_getConfig(worker->cached_engine))) {
+		if(!worker->heartbeatRows) {
+			worker->heartbeatRows = g_string_sized_new(4096);
+		}
+		rows = worker->heartbeatRows;
+	}
+
+	TrackerCounters totals;
+	memset(&totals, 0, sizeof(TrackerCounters));
+
+	/* walk the counters of all nodes that are due, and find the next due time */
+	worker->nextHeartbeat = SIMTIME_INVALID;
+	for(GSList* item = nodes; item; item = g_slist_next(item)) {
+		Node* node = item->data;
+		Tracker* tracker = node_getTracker(node);
+		if(!tracker) {
+			continue;
+		}
+
+		if(tracker_getNextHeartbeat(tracker) <= now) {
+			/* log messages need to know the node and time */
+			worker->cached_node = node;
+			worker->clock_now = now;
+
+			tracker_heartbeat(tracker, node_getName(node), now, rows, &totals);
+			if(!rows) {
+				node_logMemoryUsage(node);
+			}
+
+			worker->cached_node = NULL;
+			worker->clock_now = SIMTIME_INVALID;
+		}
+
+		worker->nextHeartbeat = MIN(worker->nextHeartbeat, tracker_getNextHeartbeat(tracker));
+	}
+
+	if(rows && totals.numNodes > 0) {
+		engine_writeHeartbeats(worker->cached_engine, now, rows, &totals);
+		g_string_truncate(rows, 0);
+	}
+}
+
+/* metric names and tags come from plug-ins, so keep them from breaking rows */
+static void _worker_appendMetricField(GString* rows, const gchar* field) {
+	for(const gchar* c = field; c && *c; c++) {
+		g_string_append_c(rows, (*c == ',' || *c == '\n' || *c == '\r') ? '_' : *c);
+	}
+}
+
+void worker_recordMetric(Worker* worker, const gchar* name, gdouble value, const gchar* tags) {
+	MAGIC_ASSERT(worker);
+
+	if(!name || !engine_isRecordingMetrics(worker->cached_engine)) {
+		return;
+	}
+
+	if(!worker->metricRows) {
+		worker->metricRows = g_string_new(NULL);
+	}
+
+	/* plug-ins freed at shutdown run outside of any event */
+	SimulationTime now = worker->clock_now != SIMTIME_INVALID ? worker->clock_now : worker->clock_last;
+
+	/* time,wall,node,plugin,name,value,tags */
+	GString* rows = worker->metricRows;
+	g_string_append_printf(rows, "%"G_GUINT64_FORMAT",%f,%s,%s,", now,
+			g_timer_elapsed(engine_getRunTimer(worker->cached_engine), NULL),
+			worker->cached_node ? node_getName(worker->cached_node) : "n/a",
+			worker->cached_plugin ? g_quark_to_string(*plugin_getID(worker->cached_plugin)) : "n/a");
+	_worker_appendMetricField(rows, name);
+	g_string_append_printf(rows, ",%f,", value);
+	_worker_appendMetricField(rows, tags);
+	g_string_append_c(rows, '\n');
+
+	if(rows->len >= WORKER_METRICS_FLUSH_BYTES) {
+		worker_flushMetrics(worker);
+	}
+}
+
+void worker_flushMetrics(Worker* worker) {
+	MAGIC_ASSERT(worker);
+
+	if(worker->metricRows && worker->metricRows->len > 0) {
+		engine_writeMetrics(worker->cached_engine, worker->metricRows);
+		g_string_truncate(worker->metricRows, 0);
+	}
+}
+
 gpointer worker_run(GSList* nodes) {
 	/* get current thread's private worker object */
 	Worker* worker = worker_getPrivate();
 
 	/* continuously run all events for this worker's assigned nodes.
 	 * the simulation is done when the engine is killed. */
+	GTimer* busyTimer = g_timer_new();
 	while(!engine_isKilled(worker->cached_engine)) {
+		g_timer_start(busyTimer);
 		SimulationTime barrier = engine_getExecutionBarrier(worker->cached_engine);
 		guint nEventsProcessed = 0;
 		guint nNodesWithEvents = 0;
@@ -173,8 +298,15 @@ gpointer worker_run(GSList* nodes) {
 			item = g_slist_next(item);
 		}
 
-		engine_notifyProcessed(worker->cached_engine, nEventsProcessed, nNodesWithEvents);
+		/* all events before the barrier are done, so the counters are final */
+		if(barrier >= worker->nextHeartbeat) {
+			worker_heartbeat(worker, nodes, barrier);
+		}
+
+		engine_notifyProcessed(worker->cached_engine, worker->thread_id, nEventsProcessed,
+				nNodesWithEvents, g_timer_elapsed(busyTimer, NULL));
 	}
+	g_timer_destroy(busyTimer);
 
 	/* free all applications before freeing any of the nodes since freeing
 	 * applications may cause close() to get called on sockets which needs
@@ -183,6 +315,11 @@ gpointer worker_run(GSList* nodes) {
 	g_slist_foreach(nodes, (GFunc) node_freeAllApplications, NULL);
 	g_slist_foreach(nodes, (GFunc) node_free, NULL);
 
+	if(worker->profiler) {
+		engine_addProfile(worker->cached_engine, worker->profiler);
+	}
+	worker_flushMetrics(worker);
+
 	g_thread_exit(NULL);
 	return NULL;
 }
@@ -34,6 +34,13 @@ struct _Worker {
 	SimulationTime clock_last;
 	SimulationTime clock_barrier;
 
+	/* heartbeats of our nodes are collected together once this time passes */
+	SimulationTime nextHeartbeat;
+	GString* heartbeatRows;
+
+	/* plug-in metrics wait here until there are enough to write */
+	GString* metricRows;
+
 	Random* random;
 
 	Engine* cached_engine;
@@ -43,6 +50,10 @@ struct _Worker {
 	Event* cached_event;
 
 	GHashTable* plugins;
+	CryptoCache* cryptoCache;
+
+	/* counts event and plug-in time when profiling, otherwise NULL */
+	Profiler* profiler;
 
 	MAGIC_DECLARE;
 };
@@ -52,6 +63,9 @@ Worker* worker_getPrivate();
 void worker_free(gpointer data);
 
 gpointer worker_run(GSList* nodes);
+void worker_heartbeat(Worker* worker, GSList* nodes, SimulationTime now);
+void worker_recordMetric(Worker* worker, const gchar* name, gdouble value, const gchar* tags);
+void worker_flushMetrics(Worker* worker);
 
 void worker_setKillTime(SimulationTime endTime);
 Plugin* worker_getPlugin(GQuark pluginID, GString* pluginPath);
@@ -22,6 +22,7 @@
 #include <glib.h>
 #include <sys/socket.h>
 #include <sys/epoll.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <stddef.h>
 #include <stdlib.h>
@@ -126,6 +127,229 @@ const void* intercept_RAND_get_rand_method(void) {
 	return (const void *)(&intercept_customRandMethod);
 }
 
+/*
+ * Public-key crypto. The RSA, DH, and EC_KEY parameters have been voided to
+ * avoid requiring Openssl headers. Each operation charges its configured cost
+ * to the node instead of being measured.
+ *
+ * Every peer in the simulation goes through these same functions, so RSA
+ * encryption and signing only need to carry the message to the matching
+ * decryption or verification, the same way we no-op AES. Anything that was
+ * not produced that way, like certificates generated before the simulation,
+ * goes to Openssl and the result is memoized for all nodes on this worker.
+ *
+ * This means the wrapped RSA_public_decrypt accepts any "signature" made by
+ * the wrapped RSA_private_encrypt, whichever key made it: verification only
+ * checks that the peer ran the signing operation, not that it held the key.
+ * Plug-ins simulate honest peers, so this is what lets signing be free.
+ *
+ * DH and ECDH always use fresh keys, so their results are never reused and
+ * we only replace their measured cost with the configured one.
+ */
+
+#define INTERCEPT_RSA_MAGIC "SHDWRSA"
+#define INTERCEPT_RSA_MAGIC_LENGTH 8
+#define INTERCEPT_RSA_HEADER_LENGTH (INTERCEPT_RSA_MAGIC_LENGTH + 2)
+
+typedef int (*RSA_size_fp)(const void *rsa);
+typedef int (*i2d_RSAPublicKey_fp)(const void *rsa, unsigned char **out);
+typedef int (*RSA_crypt_fp)(int flen, const unsigned char *from, unsigned char *to, void *rsa, int padding);
+typedef int (*DH_generate_key_fp)(void *dh);
+typedef int (*DH_compute_key_fp)(unsigned char *key, const void *pub_key, void *dh);
+typedef void* (*ECDH_KDF_fp)(const void *in, size_t inlen, void *out, size_t *outlen);
+typedef int (*ECDH_compute_key_fp)(void *out, size_t outlen, const void *pub_key, void *ecdh, ECDH_KDF_fp KDF);
+
+/* find the real Openssl function through the handle of the plug-in that is
+ * running, since it loads Openssl locally and each worker may run its own
+ * copy. we never keep the result, for the same reasons. */
+static gpointer _intercept_lookupCrypto(const gchar* name) {
+	return system_cryptoGetFunction(name);
+}
+
+static gint _intercept_wrapRSA(gint flen, const guchar *from, guchar *to, void *rsa) {
+	RSA_size_fp sizeFunc = _intercept_lookupCrypto("RSA_size");
+	if(!sizeFunc) {
+		return -1;
+	}
+	gint size = sizeFunc(rsa);
+
+	if(flen < 0 || flen > G_MAXUINT16 || flen + INTERCEPT_RSA_HEADER_LENGTH > size) {
+		return -1;
+	}
+
+	/* the output has the same length as a real one */
+	memmove(to + INTERCEPT_RSA_HEADER_LENGTH, from, (size_t)flen);
+	memcpy(to, INTERCEPT_RSA_MAGIC, INTERCEPT_RSA_MAGIC_LENGTH);
+	to[INTERCEPT_RSA_MAGIC_LENGTH] = (guchar)((flen >> 8) & 0xFF);
+	to[INTERCEPT_RSA_MAGIC_LENGTH + 1] = (guchar)(flen & 0xFF);
+	memset(to + INTERCEPT_RSA_HEADER_LENGTH + flen, 0, (size_t)(size - INTERCEPT_RSA_HEADER_LENGTH - flen));
+
+	return size;
+}
+
+static gint _intercept_unwrapRSA(gint flen, const guchar *from, guchar *to) {
+	if(flen < INTERCEPT_RSA_HEADER_LENGTH ||
+			memcmp(from, INTERCEPT_RSA_MAGIC, INTERCEPT_RSA_MAGIC_LENGTH) != 0) {
+		return -1;
+	}
+
+	gint length = (from[INTERCEPT_RSA_MAGIC_LENGTH] << 8) | from[INTERCEPT_RSA_MAGIC_LENGTH + 1];
+	if(length > flen - INTERCEPT_RSA_HEADER_LENGTH) {
+		return -1;
+	}
+
+	memmove(to, from + INTERCEPT_RSA_HEADER_LENGTH, (size_t)length);
+	return length;
+}
+
+static gint _intercept_memoizeRSA(CryptoOperation operation, RSA_crypt_fp realFunc,
+		gint flen, const guchar *from, guchar *to, void *rsa, gint padding) {
+	if(!realFunc) {
+		return -1;
+	}
+	i2d_RSAPublicKey_fp encodeFunc = _intercept_lookupCrypto("i2d_RSAPublicKey");
+
+	/* the public key and padding identify the key pair and the operation */
+	gint encodedLength = encodeFunc ? encodeFunc(rsa, NULL) : -1;
+	if(encodedLength <= 0 || flen < 0) {
+		system_cryptoBegin(operation, NULL, 0, NULL, 0, NULL, NULL);
+		gint result = realFunc(flen, from, to, rsa, padding);
+		system_cryptoEnd(NULL, 0, result);
+		return result;
+	}
+
+	gsize keyLength = (gsize)encodedLength + sizeof(gint);
+	guchar* key = g_malloc(keyLength);
+	guchar* keyPosition = key;
+	encodeFunc(rsa, &keyPosition);
+	memcpy(key + encodedLength, &padding, sizeof(gint));
+
+	gint result = -1;
+	if(!system_cryptoBegin(operation, key, keyLength, from, (gsize)flen, to, &result)) {
+		result = realFunc(flen, from, to, rsa, padding);
+		system_cryptoEnd(to, result > 0 ? (gsize)result : 0, result);
+	}
+
+	g_free(key);
+	return result;
+}
+
+int intercept_RSA_public_encrypt(int flen, const unsigned char *from, unsigned char *to, void *rsa, int padding) {
+	system_cryptoBegin(CRYPTO_RSA_PUBLIC_ENCRYPT, NULL, 0, NULL, 0, NULL, NULL);
+	gint result = _intercept_wrapRSA(flen, from, to, rsa);
+	if(result < 0) {
+		RSA_crypt_fp realFunc = _intercept_lookupCrypto("RSA_public_encrypt");
+		result = realFunc ? realFunc(flen, from, to, rsa, padding) : -1;
+	}
+	system_cryptoEnd(NULL, 0, result);
+	return result;
+}
+
+int intercept_RSA_private_decrypt(int flen, const unsigned char *from, unsigned char *to, void *rsa, int padding) {
+	gint result = _intercept_unwrapRSA(flen, from, to);
+	if(result >= 0) {
+		system_cryptoBegin(CRYPTO_RSA_PRIVATE_DECRYPT, NULL, 0, NULL, 0, NULL, NULL);
+		system_cryptoEnd(NULL, 0, result);
+		return result;
+	}
+	RSA_crypt_fp realFunc = _intercept_lookupCrypto("RSA_private_decrypt");
+	return _intercept_memoizeRSA(CRYPTO_RSA_PRIVATE_DECRYPT, realFunc, flen, from, to, rsa, padding);
+}
+
+int intercept_RSA_private_encrypt(int flen, const unsigned char *from, unsigned char *to, void *rsa, int padding) {
+	system_cryptoBegin(CRYPTO_RSA_PRIVATE_ENCRYPT, NULL, 0, NULL, 0, NULL, NULL);
+	gint result = _intercept_wrapRSA(flen, from, to, rsa);
+	if(result < 0) {
+		RSA_crypt_fp realFunc = _intercept_lookupCrypto("RSA_private_encrypt");
+		result = realFunc ? realFunc(flen, from, to, rsa, padding) : -1;
+	}
+	system_cryptoEnd(NULL, 0, result);
+	return result;
+}
+
+int intercept_RSA_public_decrypt(int flen, const unsigned char *from, unsigned char *to, void *rsa, int padding) {
+	gint result = _intercept_unwrapRSA(flen, from, to);
+	if(result >= 0) {
+		system_cryptoBegin(CRYPTO_RSA_PUBLIC_DECRYPT, NULL, 0, NULL, 0, NULL, NULL);
+		system_cryptoEnd(NULL, 0, result);
+		return result;
+	}
+	RSA_crypt_fp realFunc = _intercept_lookupCrypto("RSA_public_decrypt");
+	return _intercept_memoizeRSA(CRYPTO_RSA_PUBLIC_DECRYPT, realFunc, flen, from, to, rsa, padding);
+}
+
+int intercept_DH_generate_key(void *dh) {
+	DH_generate_key_fp realFunc = _intercept_lookupCrypto("DH_generate_key");
+	system_cryptoBegin(CRYPTO_DH_GENERATE_KEY, NULL, 0, NULL, 0, NULL, NULL);
+	gint result = realFunc ? realFunc(dh) : 0;
+	system_cryptoEnd(NULL, 0, result);
+	return result;
+}
+
+int intercept_DH_compute_key(unsigned char *key, const void *pub_key, void *dh) {
+	DH_compute_key_fp realFunc = _intercept_lookupCrypto("DH_compute_key");
+	system_cryptoBegin(CRYPTO_DH_COMPUTE_KEY, NULL, 0, NULL, 0, NULL, NULL);
+	gint result = realFunc ? realFunc(key, pub_key, dh) : -1;
+	system_cryptoEnd(NULL, 0, result);
+	return result;
+}
+
+int intercept_ECDH_compute_key(void *out, size_t outlen, const void *pub_key, void *ecdh, ECDH_KDF_fp KDF) {
+	ECDH_compute_key_fp realFunc = _intercept_lookupCrypto("ECDH_compute_key");
+	system_cryptoBegin(CRYPTO_ECDH_COMPUTE_KEY, NULL, 0, NULL, 0, NULL, NULL);
+	gint result = realFunc ? realFunc(out, outlen, pub_key, ecdh, KDF) : -1;
+	system_cryptoEnd(NULL, 0, result);
+	return result;
+}
+
+/*
+ * Openssl keeps its algorithm and error string tables in globals that every
+ * node and worker share, but plug-ins initialize them once per node. Adding to
+ * those tables while other workers use them is not safe, so the real
+ * functions run exactly once and later calls do nothing.
+ */
+typedef void (*CryptoInit_fp)(void);
+typedef int (*SSL_library_init_fp)(void);
+
+static gpointer _intercept_runCryptoInit(gpointer functionName) {
+	CryptoInit_fp realFunc = system_cryptoGetFunction(functionName);
+	if(realFunc) {
+		realFunc();
+	}
+	return NULL;
+}
+
+void intercept_OPENSSL_add_all_algorithms_noconf() {
+	static GOnce once = G_ONCE_INIT;
+	g_once(&once, _intercept_runCryptoInit, "OPENSSL_add_all_algorithms_noconf");
+}
+
+void intercept_OPENSSL_add_all_algorithms_conf() {
+	static GOnce once = G_ONCE_INIT;
+	g_once(&once, _intercept_runCryptoInit, "OPENSSL_add_all_algorithms_conf");
+}
+
+void intercept_ERR_load_crypto_strings() {
+	static GOnce once = G_ONCE_INIT;
+	g_once(&once, _intercept_runCryptoInit, "ERR_load_crypto_strings");
+}
+
+void intercept_SSL_load_error_strings() {
+	static GOnce once = G_ONCE_INIT;
+	g_once(&once, _intercept_runCryptoInit, "SSL_load_error_strings");
+}
+
+static gpointer _intercept_runSSLLibraryInit(gpointer functionName) {
+	SSL_library_init_fp realFunc = system_cryptoGetFunction(functionName);
+	/* it always returns 1 */
+	return GINT_TO_POINTER(realFunc ? realFunc() : 1);
+}
+
+int intercept_SSL_library_init() {
+	static GOnce once = G_ONCE_INIT;
+	return GPOINTER_TO_INT(g_once(&once, _intercept_runSSLLibraryInit, "SSL_library_init"));
+}
+
 static void _intercept_cryptoLockingFunc(int mode, int n, const char *file, int line) {
 	return system_cryptoLockingFunc(mode, n, file, line);
 }
@@ -292,6 +516,15 @@ ssize_t intercept_recvmsg(gint fd, struct msghdr* message, gint flags) {
 	return system_recvMsg(fd, message, flags);
 }
 
+gint intercept_sendmmsg(gint fd, struct mmsghdr* messages, guint numMessages, gint flags) {
+	return system_sendMMsg(fd, messages, numMessages, flags);
+}
+
+gint intercept_recvmmsg(gint fd, struct mmsghdr* messages, guint numMessages,
+		gint flags, struct timespec* timeout) {
+	return system_recvMMsg(fd, messages, numMessages, flags, timeout);
+}
+
 gint intercept_getsockopt(gint fd, gint level, gint optname, gpointer optval,
 		socklen_t* optlen) {
 	return system_getSockOpt(fd, level, optname, optval, optlen);
@@ -333,6 +566,14 @@ ssize_t intercept_write(gint fd, const gpointer buf, gint n) {
 	return system_write(fd, buf, n);
 }
 
+ssize_t intercept_readv(gint fd, const struct iovec* iov, gint iovcnt) {
+	return system_readV(fd, iov, iovcnt);
+}
+
+ssize_t intercept_writev(gint fd, const struct iovec* iov, gint iovcnt) {
+	return system_writeV(fd, iov, iovcnt);
+}
+
 gint intercept_close(gint fd) {
 	return system_close(fd);
 }
@@ -23,6 +23,7 @@
 #include <sys/socket.h>
 #include <sys/epoll.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <netdb.h>
 #include <stdarg.h>
@@ -248,6 +249,29 @@ ssize_t recvmsg(int fd, struct msghdr *message, int flags) {
 	return (*func)(fd, message, flags);
 }
 
+typedef int (*sendmmsg_fp)(int, struct mmsghdr*, unsigned int, int);
+static sendmmsg_fp _sendmmsg = NULL;
+static sendmmsg_fp _vsocket_sendmmsg = NULL;
+int sendmmsg(int fd, struct mmsghdr *vmessages, unsigned int vlen, int flags) {
+	sendmmsg_fp* func;
+	char* funcName;
+	PRELOAD_DECIDE(func, funcName, "sendmmsg", _sendmmsg, INTERCEPT_PREFIX, _vsocket_sendmmsg, fd >= MIN_DESCRIPTOR);
+	PRELOAD_LOOKUP(func, funcName, -1);
+	return (*func)(fd, vmessages, vlen, flags);
+}
+
+typedef int (*recvmmsg_fp)(int, struct mmsghdr*, unsigned int, int, struct timespec*);
+static recvmmsg_fp _recvmmsg = NULL;
+static recvmmsg_fp _vsocket_recvmmsg = NULL;
+int recvmmsg(int fd, struct mmsghdr *vmessages, unsigned int vlen, int flags,
+		struct timespec *tmo) {
+	recvmmsg_fp* func;
+	char* funcName;
+	PRELOAD_DECIDE(func, funcName, "recvmmsg", _recvmmsg, INTERCEPT_PREFIX, _vsocket_recvmmsg, fd >= MIN_DESCRIPTOR);
+	PRELOAD_LOOKUP(func, funcName, -1);
+	return (*func)(fd, vmessages, vlen, flags, tmo);
+}
+
 typedef int (*getsockopt_fp)(int, int, int, void*, socklen_t*);
 static getsockopt_fp _getsockopt = NULL;
 static getsockopt_fp _vsocket_getsockopt = NULL;
@@ -360,6 +384,28 @@ ssize_t write(int fd, const void *buff, int n) {
 	return (*func)(fd, buff, n);
 }
 
+typedef ssize_t (*readv_fp)(int, const struct iovec*, int);
+static readv_fp _readv = NULL;
+static readv_fp _vsocket_readv = NULL;
+ssize_t readv(int fd, const struct iovec *iov, int iovcnt) {
+	readv_fp* func;
+	char* funcName;
+	PRELOAD_DECIDE(func, funcName, "readv", _readv, INTERCEPT_PREFIX, _vsocket_readv, fd >= MIN_DESCRIPTOR);
+	PRELOAD_LOOKUP(func, funcName, -1);
+	return (*func)(fd, iov, iovcnt);
+}
+
+typedef ssize_t (*writev_fp)(int, const struct iovec*, int);
+static writev_fp _writev = NULL;
+static writev_fp _vsocket_writev = NULL;
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt) {
+	writev_fp* func;
+	char* funcName;
+	PRELOAD_DECIDE(func, funcName, "writev", _writev, INTERCEPT_PREFIX, _vsocket_writev, fd >= MIN_DESCRIPTOR);
+	PRELOAD_LOOKUP(func, funcName, -1);
+	return (*func)(fd, iov, iovcnt);
+}
+
 typedef int (*close_fp)(int);
 static close_fp _close = NULL;
 static close_fp _vsocket_close = NULL;
@@ -638,6 +684,143 @@ int EVP_Cipher(void *ctx, unsigned char *out, const unsigned char *in, unsigned
 }
 #endif
 
+/*
+ * Public-key operations are memoized or replaced with cheap equivalents by
+ * Shadow, but only when enabled since all nodes must agree on the format.
+ * RSA *rsa, DH *dh, EC_KEY *ecdh, BIGNUM *pub_key, and EC_POINT *pub_key
+ * parameters have been voided to avoid requiring Openssl headers.
+ */
+#ifdef SHADOW_ENABLE_PKCRYPTO
+typedef int (*RSA_crypt_fp)(int flen, const unsigned char *from, unsigned char *to, void *rsa, int padding);
+
+static RSA_crypt_fp _RSA_public_encrypt = NULL;
+static RSA_crypt_fp _intercept_RSA_public_encrypt = NULL;
+int RSA_public_encrypt(int flen, const unsigned char *from, unsigned char *to, void *rsa, int padding) {
+	RSA_crypt_fp* func;
+	char* funcName;
+	PRELOAD_DECIDE(func, funcName, "RSA_public_encrypt", _RSA_public_encrypt, INTERCEPT_PREFIX, _intercept_RSA_public_encrypt, 1);
+	PRELOAD_LOOKUP(func, funcName, -1);
+	return (*func)(flen, from, to, rsa, padding);
+}
+
+static RSA_crypt_fp _RSA_private_decrypt = NULL;
+static RSA_crypt_fp _intercept_RSA_private_decrypt = NULL;
+int RSA_private_decrypt(int flen, const unsigned char *from, unsigned char *to, void *rsa, int padding) {
+	RSA_crypt_fp* func;
+	char* funcName;
+	PRELOAD_DECIDE(func, funcName, "RSA_private_decrypt", _RSA_private_decrypt, INTERCEPT_PREFIX, _intercept_RSA_private_decrypt, 1);
+	PRELOAD_LOOKUP(func, funcName, -1);
+	return (*func)(flen, from, to, rsa, padding);
+}
+
+static RSA_crypt_fp _RSA_private_encrypt = NULL;
+static RSA_crypt_fp _intercept_RSA_private_encrypt = NULL;
+int RSA_private_encrypt(int flen, const unsigned char *from, unsigned char *to, void *rsa, int padding) {
+	RSA_crypt_fp* func;
+	char* funcName;
+	PRELOAD_DECIDE(func, funcName, "RSA_private_encrypt", _RSA_private_encrypt, INTERCEPT_PREFIX, _intercept_RSA_private_encrypt, 1);
+	PRELOAD_LOOKUP(func, funcName, -1);
+	return (*func)(flen, from, to, rsa, padding);
+}
+
+static RSA_crypt_fp _RSA_public_decrypt = NULL;
+static RSA_crypt_fp _intercept_RSA_public_decrypt = NULL;
+int RSA_public_decrypt(int flen, const unsigned char *from, unsigned char *to, void *rsa, int padding) {
+	RSA_crypt_fp* func;
+	char* funcName;
+	PRELOAD_DECIDE(func, funcName, "RSA_public_decrypt", _RSA_public_decrypt, INTERCEPT_PREFIX, _intercept_RSA_public_decrypt, 1);
+	PRELOAD_LOOKUP(func, funcName, -1);
+	return (*func)(flen, from, to, rsa, padding);
+}
+
+typedef int (*DH_generate_key_fp)(void *dh);
+static DH_generate_key_fp _DH_generate_key = NULL;
+static DH_generate_key_fp _intercept_DH_generate_key = NULL;
+int DH_generate_key(void *dh) {
+	DH_generate_key_fp* func;
+	char* funcName;
+	PRELOAD_DECIDE(func, funcName, "DH_generate_key", _DH_generate_key, INTERCEPT_PREFIX, _intercept_DH_generate_key, 1);
+	PRELOAD_LOOKUP(func, funcName, 0);
+	return (*func)(dh);
+}
+
+typedef int (*DH_compute_key_fp)(unsigned char *key, const void *pub_key, void *dh);
+static DH_compute_key_fp _DH_compute_key = NULL;
+static DH_compute_key_fp _intercept_DH_compute_key = NULL;
+int DH_compute_key(unsigned char *key, const void *pub_key, void *dh) {
+	DH_compute_key_fp* func;
+	char* funcName;
+	PRELOAD_DECIDE(func, funcName, "DH_compute_key", _DH_compute_key, INTERCEPT_PREFIX, _intercept_DH_compute_key, 1);
+	PRELOAD_LOOKUP(func, funcName, -1);
+	return (*func)(key, pub_key, dh);
+}
+
+typedef void* (*ECDH_KDF_fp)(const void *in, size_t inlen, void *out, size_t *outlen);
+typedef int (*ECDH_compute_key_fp)(void *out, size_t outlen, const void *pub_key, void *ecdh, ECDH_KDF_fp KDF);
+static ECDH_compute_key_fp _ECDH_compute_key = NULL;
+static ECDH_compute_key_fp _intercept_ECDH_compute_key = NULL;
+int ECDH_compute_key(void *out, size_t outlen, const void *pub_key, void *ecdh, ECDH_KDF_fp KDF) {
+	ECDH_compute_key_fp* func;
+	char* funcName;
+	PRELOAD_DECIDE(func, funcName, "ECDH_compute_key", _ECDH_compute_key, INTERCEPT_PREFIX, _intercept_ECDH_compute_key, 1);
+	PRELOAD_LOOKUP(func, funcName, -1);
+	return (*func)(out, outlen, pub_key, ecdh, KDF);
+}
+#endif
+
+typedef void (*CryptoInit_fp)(void);
+
+static CryptoInit_fp _OPENSSL_add_all_algorithms_noconf = NULL;
+static CryptoInit_fp _intercept_OPENSSL_add_all_algorithms_noconf = NULL;
+void OPENSSL_add_all_algorithms_noconf(void) {
+	CryptoInit_fp* func;
+	char* funcName;
+	PRELOAD_DECIDE(func, funcName, "OPENSSL_add_all_algorithms_noconf", _OPENSSL_add_all_algorithms_noconf, INTERCEPT_PREFIX, _intercept_OPENSSL_add_all_algorithms_noconf, 1);
+	PRELOAD_LOOKUP(func, funcName,);
+	(*func)();
+}
+
+static CryptoInit_fp _OPENSSL_add_all_algorithms_conf = NULL;
+static CryptoInit_fp _intercept_OPENSSL_add_all_algorithms_conf = NULL;
+void OPENSSL_add_all_algorithms_conf(void) {
+	CryptoInit_fp* func;
+	char* funcName;
+	PRELOAD_DECIDE(func, funcName, "OPENSSL_add_all_algorithms_conf", _OPENSSL_add_all_algorithms_conf, INTERCEPT_PREFIX, _intercept_OPENSSL_add_all_algorithms_conf, 1);
+	PRELOAD_LOOKUP(func, funcName,);
+	(*func)();
+}
+
+static CryptoInit_fp _ERR_load_crypto_strings = NULL;
+static CryptoInit_fp _intercept_ERR_load_crypto_strings = NULL;
+void ERR_load_crypto_strings(void) {
+	CryptoInit_fp* func;
+	char* funcName;
+	PRELOAD_DECIDE(func, funcName, "ERR_load_crypto_strings", _ERR_load_crypto_strings, INTERCEPT_PREFIX, _intercept_ERR_load_crypto_strings, 1);
+	PRELOAD_LOOKUP(func, funcName,);
+	(*func)();
+}
+
+static CryptoInit_fp _SSL_load_error_strings = NULL;
+static CryptoInit_fp _intercept_SSL_load_error_strings = NULL;
+void SSL_load_error_strings(void) {
+	CryptoInit_fp* func;
+	char* funcName;
+	PRELOAD_DECIDE(func, funcName, "SSL_load_error_strings", _SSL_load_error_strings, INTERCEPT_PREFIX, _intercept_SSL_load_error_strings, 1);
+	PRELOAD_LOOKUP(func, funcName,);
+	(*func)();
+}
+
+typedef int (*SSL_library_init_fp)(void);
+static SSL_library_init_fp _SSL_library_init = NULL;
+static SSL_library_init_fp _intercept_SSL_library_init = NULL;
+int SSL_library_init(void) {
+	SSL_library_init_fp* func;
+	char* funcName;
+	PRELOAD_DECIDE(func, funcName, "SSL_library_init", _SSL_library_init, INTERCEPT_PREFIX, _intercept_SSL_library_init, 1);
+	PRELOAD_LOOKUP(func, funcName, 0);
+	return (*func)();
+}
+
 typedef void (*RAND_seed_fp)(const void *buf,int num);
 static RAND_seed_fp _RAND_seed = NULL;
 static RAND_seed_fp _intercept_RAND_seed = NULL;
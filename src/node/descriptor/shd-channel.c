@@ -67,7 +67,7 @@ static gssize channel_linkedWrite(Channel* channel, gconstpointer buffer, gsize
 	channel->bufferLength += copyLength;
 
 	/* we just got some data in our buffer */
-	descriptor_adjustStatus((Descriptor*)channel, DS_READABLE, TRUE);
+	descriptor_signalStatus((Descriptor*)channel, DS_READABLE);
 
 	return copyLength;
 }
@@ -93,48 +93,44 @@ static void _descriptor_notifyListener(gpointer data, gpointer user_data) {
 	listener_notify(listener);
 }
 
+static void _descriptor_handleStatusChange(Descriptor* descriptor, enum DescriptorStatus changedStatus) {
+	/* only wake up our listeners on real transitions. listeners that are
+	 * interested in edges can query the bits that changed. */
+	if(changedStatus == DS_NONE) {
+		return;
+	}
+
+	descriptor->changedStatus = changedStatus;
+
+	/* tell our listeners their was some activity on this descriptor */
+	g_slist_foreach(descriptor->readyListeners, _descriptor_notifyListener, NULL);
+
+	descriptor->changedStatus = DS_NONE;
+}
+
 void descriptor_adjustStatus(Descriptor* descriptor, enum DescriptorStatus status, gboolean doSetBits){
 	MAGIC_ASSERT(descriptor);
 
+	enum DescriptorStatus oldStatus = descriptor->status;
+
 	/* adjust our status as requested */
 	if(doSetBits) {
-		if((status & DS_ACTIVE) && !(descriptor->status & DS_ACTIVE)) {
-			/* status changed - is now active */
-			descriptor->status |= DS_ACTIVE;
-		}
-		if((status & DS_READABLE) && !(descriptor->status & DS_READABLE)) {
-			/* status changed - is now readable */
-			descriptor->status |= DS_READABLE;
-		}
-		if((status & DS_WRITABLE) && !(descriptor->status & DS_WRITABLE)) {
-			/* status changed - is now writable */
-			descriptor->status |= DS_WRITABLE;
-		}
-		if((status & DS_CLOSED) && !(descriptor->status & DS_CLOSED)) {
-			/* status changed - is now closed to user */
-			descriptor->status |= DS_CLOSED;
-		}
+		descriptor->status |= status;
 	} else {
-		if((status & DS_ACTIVE) && (descriptor->status & DS_ACTIVE)) {
-			/* status changed - no longer active */
-			descriptor->status &= ~DS_ACTIVE;
-		}
-		if((status & DS_READABLE) && (descriptor->status & DS_READABLE)) {
-			/* status changed - no longer readable */
-			descriptor->status &= ~DS_READABLE;
-		}
-		if((status & DS_WRITABLE) && (descriptor->status & DS_WRITABLE)) {
-			/* status changed - no longer writable */
-			descriptor->status &= ~DS_WRITABLE;
-		}
-		if((status & DS_CLOSED) && (descriptor->status & DS_CLOSED)) {
-			/* status changed - no longer closed to user */
-			descriptor->status &= ~DS_CLOSED;
-		}
+		descriptor->status &= ~status;
 	}
 
-	/* tell our listeners their was some activity on this descriptor */
-	g_slist_foreach(descriptor->readyListeners, _descriptor_notifyListener, NULL);
+	/* XOR leaves us with only the bits that actually flipped */
+	_descriptor_handleStatusChange(descriptor, oldStatus ^ descriptor->status);
+}
+
+void descriptor_signalStatus(Descriptor* descriptor, enum DescriptorStatus status) {
+	MAGIC_ASSERT(descriptor);
+
+	/* set the bits, but report them as changed even if they were already set so
+	 * that edge-triggered listeners get a fresh edge */
+	descriptor->status |= status;
+	_descriptor_handleStatusChange(descriptor, status);
 }
 
 enum DescriptorStatus descriptor_getStatus(Descriptor* descriptor) {
@@ -155,6 +151,11 @@ enum DescriptorStatus descriptor_getStatus(Descriptor* descriptor) {
 	return status;
 }
 
+enum DescriptorStatus descriptor_getChangedStatus(Descriptor* descriptor) {
+	MAGIC_ASSERT(descriptor);
+	return descriptor->changedStatus;
+}
+
 void descriptor_addStatusListener(Descriptor* descriptor, Listener* listener) {
 	MAGIC_ASSERT(descriptor);
 	descriptor->readyListeners = g_slist_prepend(descriptor->readyListeners, listener);
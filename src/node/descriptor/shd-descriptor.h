@@ -62,6 +62,9 @@ struct _Descriptor {
 	gint handle;
 	enum DescriptorType type;
 	enum DescriptorStatus status;
+	/* the status bits that flipped in the transition our listeners are
+	 * currently being notified about, DS_NONE outside of notifications */
+	enum DescriptorStatus changedStatus;
 	GSList* readyListeners;
 	gint referenceCount;
 	MAGIC_DECLARE;
@@ -78,7 +81,9 @@ enum DescriptorType descriptor_getType(Descriptor* descriptor);
 gint* descriptor_getHandleReference(Descriptor* descriptor);
 
 void descriptor_adjustStatus(Descriptor* descriptor, enum DescriptorStatus status, gboolean doSetBits);
+void descriptor_signalStatus(Descriptor* descriptor, enum DescriptorStatus status);
 enum DescriptorStatus descriptor_getStatus(Descriptor* descriptor);
+enum DescriptorStatus descriptor_getChangedStatus(Descriptor* descriptor);
 
 void descriptor_addStatusListener(Descriptor* descriptor, Listener* listener);
 void descriptor_removeStatusListener(Descriptor* descriptor, Listener* listener);
@@ -39,13 +39,17 @@ struct _EpollWatch {
 	Listener* listener;
 	/* holds the actual event info */
 	struct epoll_event event;
-	/* true if this watch exists in the reportable queue */
+	/* our link in the epoll ready list. its embedded here so that adding to and
+	 * removing from the ready list are both O(1) without extra allocations. */
+	GList readyLink;
+	/* true if readyLink is currently linked into the epoll ready list */
 	gboolean isReporting;
-	/* true if this watch is currently valid and in the watches table. this allows
-	 * support of lazy deletion of watches that are in the reportable queue when
-	 * we want to delete them, to avoid the O(n) removal time of the queue.
-	 */
-	gboolean isWatching;
+	/* the status bits that turned on since we last reported this watch. only
+	 * these are reportable for edge-triggered (EPOLLET) watches. */
+	enum DescriptorStatus edges;
+	/* true if this one-shot (EPOLLONESHOT) watch already reported an event and
+	 * needs to be re-armed with EPOLL_CTL_MOD before it reports again */
+	gboolean isDisarmed;
 	MAGIC_DECLARE;
 };
 
@@ -64,8 +68,10 @@ struct _Epoll {
 
 	/* holds the wrappers for the descriptors we are watching for events */
 	GHashTable* watching;
-	/* holds the watches which have events we need to report to the user */
-	GQueue* reporting;
+	/* intrusive list of the watches which have events we need to report to the user */
+	GQueue reporting;
+	/* number of OS file descriptors registered with osEpollDescriptor */
+	gint osWatchCount;
 
 	SimulationTime lastWaitTime;
 	Application* ownerApplication;
@@ -85,7 +91,10 @@ static EpollWatch* _epollwatch_new(Epoll* epoll, Descriptor* descriptor, struct
 
 	watch->listener = listener_new((CallbackFunc)epoll_descriptorStatusChanged, epoll, descriptor);
 	watch->descriptor = descriptor;
+	watch->readyLink.data = watch;
 	watch->event = *event;
+	/* whatever is ready when we start watching counts as an edge */
+	watch->edges = descriptor_getStatus(descriptor);
 
 	descriptor_addStatusListener(watch->descriptor, watch->listener);
 
@@ -107,17 +116,9 @@ static void _epollwatch_free(EpollWatch* watch) {
 static void _epoll_free(Epoll* epoll) {
 	MAGIC_ASSERT(epoll);
 
-	/* this will go through all epollwatch items and remove the listeners
-	 * only from those that dont already exist in the watching table */
-	while(!g_queue_is_empty(epoll->reporting)) {
-		EpollWatch* watch = g_queue_pop_head(epoll->reporting);
-		MAGIC_ASSERT(watch);
-		watch->isReporting = FALSE;
-		if(!watch->isWatching) {
-			_epollwatch_free(watch);
-		}
-	}
-	g_queue_free(epoll->reporting);
+	/* the ready list only links watches that are also in the watching table,
+	 * so we just drop the links and free everything from the table below */
+	g_queue_init(&(epoll->reporting));
 
 	GHashTableIter iter;
 	gpointer key, value;
@@ -154,7 +155,7 @@ Epoll* epoll_new(gint handle) {
 
 	/* allocate backend needed for managing events for this descriptor */
 	epoll->watching = g_hash_table_new_full(g_int_hash, g_int_equal, NULL, NULL);
-	epoll->reporting = g_queue_new();
+	g_queue_init(&(epoll->reporting));
 
 	/* the application may want us to watch some system files, so we need a
 	 * real OS epoll fd so we can offload that task.
@@ -187,6 +188,14 @@ static enum EpollWatchFlags _epollwatch_getStatus(EpollWatch* watch) {
 	return flags;
 }
 
+static gboolean _epollwatch_isEdgeTriggered(EpollWatch* watch) {
+	return (watch->event.events & EPOLLET) ? TRUE : FALSE;
+}
+
+static gboolean _epollwatch_isOneShot(EpollWatch* watch) {
+	return (watch->event.events & EPOLLONESHOT) ? TRUE : FALSE;
+}
+
 static gboolean _epollwatch_needsNotify(enum EpollWatchFlags f) {
 	if((f & EWF_ACTIVE) &&
 			(((f & EWF_READABLE) && (f & EWF_WAITINGREAD)) ||
@@ -197,9 +206,34 @@ static gboolean _epollwatch_needsNotify(enum EpollWatchFlags f) {
 	}
 }
 
+static enum EpollWatchFlags _epollwatch_getReportableStatus(EpollWatch* watch) {
+	enum EpollWatchFlags flags = _epollwatch_getStatus(watch);
+
+	/* edge-triggered watches only report the bits that turned on since the
+	 * last time we reported them, not every bit that is still set */
+	if(_epollwatch_isEdgeTriggered(watch)) {
+		if(!(watch->edges & DS_READABLE)) {
+			flags &= ~EWF_READABLE;
+		}
+		if(!(watch->edges & DS_WRITABLE)) {
+			flags &= ~EWF_WRITEABLE;
+		}
+	}
+
+	return flags;
+}
+
+static gboolean _epollwatch_isReady(EpollWatch* watch) {
+	/* disarmed one-shot watches stay silent until the user re-arms them */
+	if(watch->isDisarmed) {
+		return FALSE;
+	}
+	return _epollwatch_needsNotify(_epollwatch_getReportableStatus(watch));
+}
+
 static void _epoll_trySchedule(Epoll* epoll) {
 	/* schedule a shadow notification event if we have events to report */
-	if(!g_queue_is_empty(epoll->reporting)) {
+	if(!g_queue_is_empty(&(epoll->reporting))) {
 		/* avoid duplicating events in the shadow event queue for our epoll */
 		gboolean isScheduled = (epoll->flags & EF_SCHEDULED) ? TRUE : FALSE;
 		if(!isScheduled && application_isRunning(epoll->ownerApplication)) {
@@ -217,27 +251,23 @@ static void _epoll_check(Epoll* epoll, EpollWatch* watch) {
 	MAGIC_ASSERT(epoll);
 	MAGIC_ASSERT(watch);
 
+	/* an edge is lost if the bit turned off again before we reported it */
+	watch->edges &= descriptor_getStatus(watch->descriptor);
+
 	/* check if we need to schedule a notification */
-	gboolean needsNotify = _epollwatch_needsNotify(_epollwatch_getStatus(watch));
+	gboolean needsNotify = _epollwatch_isReady(watch);
 
 	if(needsNotify) {
 		/* we need to report an event to user */
 		if(!watch->isReporting) {
-			g_queue_push_tail(epoll->reporting, watch);
+			g_queue_push_tail_link(&(epoll->reporting), &(watch->readyLink));
 			watch->isReporting = TRUE;
 		}
 	} else {
-		/* this watch no longer needs reporting
-		 * NOTE: the removal is also done lazily, so this else block
-		 * is technically not needed. its up for debate if its faster to
-		 * iterate the queue to remove the event now, versus swapping in
-		 * the node to collect events and lazily removing this later. */
+		/* this watch no longer needs reporting */
 		if(watch->isReporting) {
-			g_queue_remove(epoll->reporting, watch);
+			g_queue_unlink(&(epoll->reporting), &(watch->readyLink));
 			watch->isReporting = FALSE;
-			if(!watch->isWatching) {
-				_epollwatch_free(watch);
-			}
 		}
 	}
 
@@ -266,7 +296,6 @@ gint epoll_control(Epoll* epoll, gint operation, Descriptor* descriptor,
 			watch = _epollwatch_new(epoll, descriptor, event);
 			g_hash_table_replace(epoll->watching,
 					descriptor_getHandleReference(descriptor), watch);
-			watch->isWatching = TRUE;
 
 			/* initiate a callback if the new watched descriptor is ready */
 			_epoll_check(epoll, watch);
@@ -281,10 +310,13 @@ gint epoll_control(Epoll* epoll, gint operation, Descriptor* descriptor,
 			}
 
 			MAGIC_ASSERT(watch);
-			g_assert(event && watch->isWatching);
+			g_assert(event);
 
-			/* the user set new events */
+			/* the user set new events, which also re-arms one-shot watches
+			 * and counts anything that is currently ready as a new edge */
 			watch->event = *event;
+			watch->isDisarmed = FALSE;
+			watch->edges = descriptor_getStatus(descriptor);
 
 			/* initiate a callback if the new event type on the watched descriptor is ready */
 			_epoll_check(epoll, watch);
@@ -301,14 +333,13 @@ gint epoll_control(Epoll* epoll, gint operation, Descriptor* descriptor,
 			MAGIC_ASSERT(watch);
 			g_hash_table_remove(epoll->watching,
 					descriptor_getHandleReference(descriptor));
-			watch->isWatching = FALSE;
 
-			/* we can only delete it if its not in the reporting queue */
-			if(!(watch->isReporting)) {
-				_epollwatch_free(watch);
-			} else {
-				descriptor_removeStatusListener(watch->descriptor, watch->listener);
+			/* unlinking from the ready list is O(1), so no need for lazy deletion */
+			if(watch->isReporting) {
+				g_queue_unlink(&(epoll->reporting), &(watch->readyLink));
+				watch->isReporting = FALSE;
 			}
+			_epollwatch_free(watch);
 
 			break;
 		}
@@ -326,7 +357,20 @@ gint epoll_controlOS(Epoll* epoll, gint operation, gint fileDescriptor,
 		struct epoll_event* event) {
 	MAGIC_ASSERT(epoll);
 	/* ask the OS about any events on our kernel epoll descriptor */
-	return epoll_ctl(epoll->osEpollDescriptor, operation, fileDescriptor, event);
+	gint result = epoll_ctl(epoll->osEpollDescriptor, operation, fileDescriptor, event);
+
+	/* track how many OS descriptors we have so we know when we can skip asking
+	 * the OS for events altogether */
+	if(result == 0) {
+		if(operation == EPOLL_CTL_ADD) {
+			(epoll->osWatchCount)++;
+		} else if(operation == EPOLL_CTL_DEL) {
+			(epoll->osWatchCount)--;
+			g_assert(epoll->osWatchCount >= 0);
+		}
+	}
+
+	return result;
 }
 
 gint epoll_getEvents(Epoll* epoll, struct epoll_event* eventArray,
@@ -338,23 +382,17 @@ gint epoll_getEvents(Epoll* epoll, struct epoll_event* eventArray,
 
 	/* return the available events in the eventArray, making sure not to
 	 * overflow. the number of actual events is returned in nEvents. */
-	gint reportableLength = g_queue_get_length(epoll->reporting);
+	gint reportableLength = g_queue_get_length(&(epoll->reporting));
 	gint eventArrayIndex = 0;
 
 	for(gint i = 0; i < eventArrayLength && i < reportableLength; i++) {
-		EpollWatch* watch = g_queue_pop_head(epoll->reporting);
+		GList* link = g_queue_pop_head_link(&(epoll->reporting));
+		EpollWatch* watch = link->data;
 		MAGIC_ASSERT(watch);
 
-		/* lazy-delete items that we are no longer watching */
-		if(!watch->isWatching) {
-			watch->isReporting = FALSE;
-			_epollwatch_free(watch);
-			continue;
-		}
-
 		/* double check that we should still notify this event */
-		enum EpollWatchFlags status = _epollwatch_getStatus(watch);
-		if(_epollwatch_needsNotify(status)) {
+		enum EpollWatchFlags status = _epollwatch_getReportableStatus(watch);
+		if(!watch->isDisarmed && _epollwatch_needsNotify(status)) {
 			/* report the event */
 			eventArray[eventArrayIndex] = watch->event;
 			eventArray[eventArrayIndex].events = 0;
@@ -363,16 +401,26 @@ gint epoll_getEvents(Epoll* epoll, struct epoll_event* eventArray,
 			eventArrayIndex++;
 			g_assert(eventArrayIndex <= eventArrayLength);
 
-			/* this watch persists until the descriptor status changes */
-			g_queue_push_tail(epoll->reporting, watch);
-			g_assert(watch->isReporting);
+			if(_epollwatch_isEdgeTriggered(watch) || _epollwatch_isOneShot(watch)) {
+				/* we consumed the edge, so wait for the next transition */
+				watch->edges = DS_NONE;
+				watch->isReporting = FALSE;
+				if(_epollwatch_isOneShot(watch)) {
+					watch->isDisarmed = TRUE;
+				}
+			} else {
+				/* this watch persists until the descriptor status changes */
+				g_queue_push_tail_link(&(epoll->reporting), &(watch->readyLink));
+				g_assert(watch->isReporting);
+			}
 		} else {
 			watch->isReporting = FALSE;
 		}
 	}
 
+	/* only pay for the syscall if the user registered some OS descriptors */
 	gint space = eventArrayLength - eventArrayIndex;
-	if(space) {
+	if(space && epoll->osWatchCount > 0) {
 		/* now we have to get events from the OS descriptors */
 		struct epoll_event osEvents[space];
 		/* since we are in shadow context, this will be forwarded to the OS epoll */
@@ -405,6 +453,9 @@ void epoll_descriptorStatusChanged(Epoll* epoll, Descriptor* descriptor) {
 	/* if we are not watching, its an error because we shouldn't be listening */
 	g_assert(watch && (watch->descriptor == descriptor));
 
+	/* remember which bits turned on so edge-triggered watches can report them */
+	watch->edges |= (descriptor_getChangedStatus(descriptor) & descriptor_getStatus(descriptor));
+
 	/* check the status and take the appropriate action */
 	_epoll_check(epoll, watch);
 }
@@ -417,7 +468,7 @@ void epoll_tryNotify(Epoll* epoll) {
 
 	/* we should notify the plugin only if we still have some events to report
 	 * XXX: what if our watches are empty, but the OS desc has events? */
-	if(!g_queue_is_empty(epoll->reporting)) {
+	if(!g_queue_is_empty(&(epoll->reporting))) {
 		/* notify application to collect the reportable events */
 		application_notify(epoll->ownerApplication);
 	}
@@ -244,9 +244,10 @@ gboolean socket_addToInputBuffer(Socket* socket, Packet* packet) {
 	g_queue_push_tail(socket->inputBuffer, packet);
 	socket->inputBufferLength += length;
 
-	/* we just added a packet, so we are readable */
+	/* we just added a packet, so we are readable. every arrival is a new edge,
+	 * even if the socket was readable already */
 	if(socket->inputBufferLength > 0) {
-		descriptor_adjustStatus((Descriptor*)socket, DS_READABLE, TRUE);
+		descriptor_signalStatus((Descriptor*)socket, DS_READABLE);
 	}
 
 	return TRUE;
@@ -286,6 +287,13 @@ gboolean socket_addToOutputBuffer(Socket* socket, Packet* packet) {
 		return FALSE;
 	}
 
+	/* packets to our own node go straight across without being queued */
+	in_addr_t ip = packet_getSourceIP(packet);
+	NetworkInterface* interface = node_lookupInterface(worker_getPrivate()->cached_node, ip);
+	if(networkinterface_sendLocal(interface, packet)) {
+		return TRUE;
+	}
+
 	/* add to our queue */
 	g_queue_push_tail(socket->outputBuffer, packet);
 	socket->outputBufferLength += length;
@@ -296,8 +304,6 @@ gboolean socket_addToOutputBuffer(Socket* socket, Packet* packet) {
 	}
 
 	/* tell the interface to include us when sending out to the network */
-	in_addr_t ip = packet_getSourceIP(packet);
-	NetworkInterface* interface = node_lookupInterface(worker_getPrivate()->cached_node, ip);
 	networkinterface_wantsSend(interface, socket);
 
 	return TRUE;
@@ -0,0 +1,318 @@
+/**
+ * The Shadow Simulator
+ *
+ * Copyright (c) 2010-2012 Rob Jansen <jansen@cs.umn.edu>
+ *
+ * This file is part of Shadow.
+ *
+ * Shadow is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shadow is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+
+#include "shadow.h"
+
+/* CUBIC constants from RFC 8312 */
+#define TCP_CUBIC_C 0.4
+#define TCP_CUBIC_BETA 0.7
+
+/*
+ * the original shadow algorithm: slow start until the first loss, then
+ * additive increase. the window is halved on every lost packet.
+ */
+typedef struct _TCPCongestionAIMD TCPCongestionAIMD;
+struct _TCPCongestionAIMD {
+	TCPCongestion super;
+	gboolean isSlowStart;
+	MAGIC_DECLARE;
+};
+
+/*
+ * NewReno (RFC 6582): slow start below the threshold, one packet per window
+ * of acks above it, and the window is halved once per window of losses.
+ */
+typedef struct _TCPCongestionReno TCPCongestionReno;
+struct _TCPCongestionReno {
+	TCPCongestion super;
+	MAGIC_DECLARE;
+};
+
+/*
+ * CUBIC (RFC 8312): the window grows as a cubic function of the time since
+ * the last loss, so it recovers quickly on paths with a large BDP.
+ */
+typedef struct _TCPCongestionCubic TCPCongestionCubic;
+struct _TCPCongestionCubic {
+	TCPCongestion super;
+	/* window just before the last reduction */
+	gdouble windowMax;
+	/* when the current congestion avoidance epoch started, if it did */
+	gboolean hasEpoch;
+	SimulationTime epochStart;
+	/* time in seconds to grow back to originPoint */
+	gdouble k;
+	gdouble originPoint;
+	/* the window Reno would have, CUBIC never does worse than that */
+	gdouble renoWindow;
+	MAGIC_DECLARE;
+};
+
+TCPCongestionType tcpcongestion_typeFromString(const gchar* name) {
+	if(!name) {
+		return TCP_CC_UNKNOWN;
+	} else if(!g_ascii_strcasecmp(name, "aimd")) {
+		return TCP_CC_AIMD;
+	} else if(!g_ascii_strcasecmp(name, "reno")) {
+		return TCP_CC_RENO;
+	} else if(!g_ascii_strcasecmp(name, "cubic")) {
+		return TCP_CC_CUBIC;
+	} else {
+		return TCP_CC_UNKNOWN;
+	}
+}
+
+const gchar* tcpcongestion_typeToString(TCPCongestionType type) {
+	switch(type) {
+		case TCP_CC_AIMD:
+			return "aimd";
+		case TCP_CC_RENO:
+			return "reno";
+		case TCP_CC_CUBIC:
+			return "cubic";
+		default:
+			return "unknown";
+	}
+}
+
+static void _tcpcongestion_init(TCPCongestion* congestion, TCPCongestionFunctionTable* vtable,
+		TCPCongestionType type, guint32 initialWindow, gboolean usesFastRecovery) {
+	g_assert(congestion && vtable);
+	MAGIC_INIT(congestion);
+
+	congestion->vtable = vtable;
+	congestion->type = type;
+	congestion->window = (gdouble) initialWindow;
+	congestion->usesFastRecovery = usesFastRecovery;
+}
+
+static gboolean _tcpcongestion_isSlowStart(TCPCongestion* congestion) {
+	return (congestion->threshold == 0 ||
+			congestion->window < congestion->threshold) ? TRUE : FALSE;
+}
+
+/* AIMD */
+
+static void _tcpcongestionaimd_packetsAcked(TCPCongestionAIMD* aimd, guint nPacketsAcked) {
+	MAGIC_ASSERT(aimd);
+	TCPCongestion* congestion = &(aimd->super);
+
+	if(aimd->isSlowStart) {
+		/* threshold not set => no loss yet => slow start phase 1
+		 *  i.e. multiplicative increase until retransmit event (which sets threshold)
+		 * threshold set => loss => slow start phase 2
+		 *  i.e. multiplicative increase until threshold */
+		congestion->window += ((gdouble)nPacketsAcked);
+		if(congestion->threshold != 0 && congestion->window >= congestion->threshold) {
+			aimd->isSlowStart = FALSE;
+		}
+	} else {
+		/* slow start is over
+		 * simple additive increase part of AIMD */
+		congestion->window += (gdouble)(nPacketsAcked * ((gdouble)(nPacketsAcked / congestion->window)));
+	}
+}
+
+static void _tcpcongestionaimd_packetLost(TCPCongestionAIMD* aimd) {
+	MAGIC_ASSERT(aimd);
+	TCPCongestion* congestion = &(aimd->super);
+
+	/* multiplicative decrease */
+	congestion->window /= 2;
+	if(congestion->window < 1) {
+		congestion->window = 1;
+	}
+	if(aimd->isSlowStart && congestion->threshold == 0) {
+		congestion->threshold = (guint32) congestion->window;
+	}
+}
+
+static void _tcpcongestionaimd_free(TCPCongestionAIMD* aimd) {
+	MAGIC_ASSERT(aimd);
+	MAGIC_CLEAR(aimd);
+	g_free(aimd);
+}
+
+TCPCongestionFunctionTable tcpcongestionaimd_functions = {
+	(TCPCongestionPacketsAckedFunc) _tcpcongestionaimd_packetsAcked,
+	(TCPCongestionPacketLostFunc) _tcpcongestionaimd_packetLost,
+	(TCPCongestionFreeFunc) _tcpcongestionaimd_free,
+	MAGIC_VALUE
+};
+
+/* NewReno */
+
+static void _tcpcongestionreno_packetsAcked(TCPCongestionReno* reno, guint nPacketsAcked) {
+	MAGIC_ASSERT(reno);
+	TCPCongestion* congestion = &(reno->super);
+
+	if(_tcpcongestion_isSlowStart(congestion)) {
+		congestion->window += (gdouble) nPacketsAcked;
+	} else {
+		congestion->window += ((gdouble) nPacketsAcked) / congestion->window;
+	}
+}
+
+static void _tcpcongestionreno_packetLost(TCPCongestionReno* reno) {
+	MAGIC_ASSERT(reno);
+	TCPCongestion* congestion = &(reno->super);
+
+	congestion->threshold = MAX((guint32) (congestion->window / 2), 2);
+	congestion->window = (gdouble) congestion->threshold;
+}
+
+static void _tcpcongestionreno_free(TCPCongestionReno* reno) {
+	MAGIC_ASSERT(reno);
+	MAGIC_CLEAR(reno);
+	g_free(reno);
+}
+
+TCPCongestionFunctionTable tcpcongestionreno_functions = {
+	(TCPCongestionPacketsAckedFunc) _tcpcongestionreno_packetsAcked,
+	(TCPCongestionPacketLostFunc) _tcpcongestionreno_packetLost,
+	(TCPCongestionFreeFunc) _tcpcongestionreno_free,
+	MAGIC_VALUE
+};
+
+/* CUBIC */
+
+static void _tcpcongestioncubic_packetsAcked(TCPCongestionCubic* cubic, guint nPacketsAcked) {
+	MAGIC_ASSERT(cubic);
+	TCPCongestion* congestion = &(cubic->super);
+
+	if(_tcpcongestion_isSlowStart(congestion)) {
+		congestion->window += (gdouble) nPacketsAcked;
+		return;
+	}
+
+	SimulationTime now = worker_getPrivate()->clock_now;
+
+	if(!cubic->hasEpoch) {
+		cubic->hasEpoch = TRUE;
+		cubic->epochStart = now;
+		if(congestion->window < cubic->windowMax) {
+			cubic->k = cbrt((cubic->windowMax - congestion->window) / TCP_CUBIC_C);
+			cubic->originPoint = cubic->windowMax;
+		} else {
+			cubic->k = 0;
+			cubic->originPoint = congestion->window;
+		}
+		cubic->renoWindow = congestion->window;
+	}
+
+	gdouble t = ((gdouble) (now - cubic->epochStart)) / SIMTIME_ONE_SECOND;
+	gdouble target = cubic->originPoint + TCP_CUBIC_C * pow(t - cubic->k, 3);
+	target = MIN(target, 1.5 * congestion->window);
+
+	gdouble acked = (gdouble) nPacketsAcked;
+	if(target > congestion->window) {
+		congestion->window += (target - congestion->window) * acked / congestion->window;
+	} else {
+		congestion->window += 0.01 * acked / congestion->window;
+	}
+
+	/* stay at least as fast as Reno would be in the same conditions */
+	cubic->renoWindow += (3.0 * (1.0 - TCP_CUBIC_BETA) / (1.0 + TCP_CUBIC_BETA)) *
+			acked / congestion->window;
+	congestion->window = MAX(congestion->window, cubic->renoWindow);
+}
+
+static void _tcpcongestioncubic_packetLost(TCPCongestionCubic* cubic) {
+	MAGIC_ASSERT(cubic);
+	TCPCongestion* congestion = &(cubic->super);
+
+	/* fast convergence: release bandwidth to newer flows */
+	if(congestion->window < cubic->windowMax) {
+		cubic->windowMax = congestion->window * (1.0 + TCP_CUBIC_BETA) / 2.0;
+	} else {
+		cubic->windowMax = congestion->window;
+	}
+
+	congestion->threshold = MAX((guint32) (congestion->window * TCP_CUBIC_BETA), 2);
+	congestion->window = (gdouble) congestion->threshold;
+	cubic->hasEpoch = FALSE;
+}
+
+static void _tcpcongestioncubic_free(TCPCongestionCubic* cubic) {
+	MAGIC_ASSERT(cubic);
+	MAGIC_CLEAR(cubic);
+	g_free(cubic);
+}
+
+TCPCongestionFunctionTable tcpcongestioncubic_functions = {
+	(TCPCongestionPacketsAckedFunc) _tcpcongestioncubic_packetsAcked,
+	(TCPCongestionPacketLostFunc) _tcpcongestioncubic_packetLost,
+	(TCPCongestionFreeFunc) _tcpcongestioncubic_free,
+	MAGIC_VALUE
+};
+
+TCPCongestion* tcpcongestion_new(TCPCongestionType type, guint32 initialWindow) {
+	switch(type) {
+		case TCP_CC_RENO: {
+			TCPCongestionReno* reno = g_new0(TCPCongestionReno, 1);
+			MAGIC_INIT(reno);
+			_tcpcongestion_init(&(reno->super), &tcpcongestionreno_functions,
+					type, initialWindow, TRUE);
+			return &(reno->super);
+		}
+
+		case TCP_CC_CUBIC: {
+			TCPCongestionCubic* cubic = g_new0(TCPCongestionCubic, 1);
+			MAGIC_INIT(cubic);
+			_tcpcongestion_init(&(cubic->super), &tcpcongestioncubic_functions,
+					type, initialWindow, TRUE);
+			return &(cubic->super);
+		}
+
+		case TCP_CC_AIMD:
+		default: {
+			TCPCongestionAIMD* aimd = g_new0(TCPCongestionAIMD, 1);
+			MAGIC_INIT(aimd);
+			aimd->isSlowStart = TRUE;
+			_tcpcongestion_init(&(aimd->super), &tcpcongestionaimd_functions,
+					TCP_CC_AIMD, initialWindow, FALSE);
+			return &(aimd->super);
+		}
+	}
+}
+
+void tcpcongestion_free(TCPCongestion* congestion) {
+	MAGIC_ASSERT(congestion);
+	MAGIC_ASSERT(congestion->vtable);
+	MAGIC_CLEAR(congestion);
+	congestion->vtable->free(congestion);
+}
+
+void tcpcongestion_packetsAcked(TCPCongestion* congestion, guint nPacketsAcked) {
+	MAGIC_ASSERT(congestion);
+	MAGIC_ASSERT(congestion->vtable);
+	if(nPacketsAcked > 0) {
+		congestion->vtable->packetsAcked(congestion, nPacketsAcked);
+	}
+}
+
+void tcpcongestion_packetLost(TCPCongestion* congestion) {
+	MAGIC_ASSERT(congestion);
+	MAGIC_ASSERT(congestion->vtable);
+	congestion->vtable->packetLost(congestion);
+}
@@ -0,0 +1,85 @@
+/**
+ * The Shadow Simulator
+ *
+ * Copyright (c) 2010-2012 Rob Jansen <jansen@cs.umn.edu>
+ *
+ * This file is part of Shadow.
+ *
+ * Shadow is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shadow is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHD_TCP_CONGESTION_H_
+#define SHD_TCP_CONGESTION_H_
+
+#include "shadow.h"
+
+/* the congestion control algorithms a TCP socket may use */
+typedef enum _TCPCongestionType TCPCongestionType;
+enum _TCPCongestionType {
+	TCP_CC_UNKNOWN, TCP_CC_AIMD, TCP_CC_RENO, TCP_CC_CUBIC,
+};
+
+typedef struct _TCPCongestion TCPCongestion;
+typedef struct _TCPCongestionFunctionTable TCPCongestionFunctionTable;
+
+/* required interface functions. see tcpcongestion_new() for the subclasses. */
+typedef void (*TCPCongestionPacketsAckedFunc)(TCPCongestion* congestion, guint nPacketsAcked);
+typedef void (*TCPCongestionPacketLostFunc)(TCPCongestion* congestion);
+typedef void (*TCPCongestionFreeFunc)(TCPCongestion* congestion);
+
+/**
+ * Virtual function table for congestion control algorithms.
+ */
+struct _TCPCongestionFunctionTable {
+	TCPCongestionPacketsAckedFunc packetsAcked;
+	TCPCongestionPacketLostFunc packetLost;
+	TCPCongestionFreeFunc free;
+	MAGIC_DECLARE;
+};
+
+/**
+ * The state every algorithm keeps. Subclasses keep this as the first element
+ * in their own structure.
+ */
+struct _TCPCongestion {
+	TCPCongestionFunctionTable* vtable;
+	TCPCongestionType type;
+	/* our current congestion window, in packets */
+	gdouble window;
+	/* slow start threshold in packets, 0 until the first loss */
+	guint32 threshold;
+	/* if TRUE, the window is reduced once per window of losses (NewReno fast
+	 * recovery). if FALSE, it is reduced on every lost packet. */
+	gboolean usesFastRecovery;
+	MAGIC_DECLARE;
+};
+
+TCPCongestionType tcpcongestion_typeFromString(const gchar* name);
+const gchar* tcpcongestion_typeToString(TCPCongestionType type);
+
+TCPCongestion* tcpcongestion_new(TCPCongestionType type, guint32 initialWindow);
+void tcpcongestion_free(TCPCongestion* congestion);
+
+/**
+ * Grow the window after nPacketsAcked new packets were acknowledged.
+ */
+void tcpcongestion_packetsAcked(TCPCongestion* congestion, guint nPacketsAcked);
+
+/**
+ * Shrink the window after a loss. With fast recovery, this is only called
+ * for the first loss in each window.
+ */
+void tcpcongestion_packetLost(TCPCongestion* congestion);
+
+#endif /* SHD_TCP_CONGESTION_H_ */
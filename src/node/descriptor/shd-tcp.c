@@ -120,12 +120,9 @@ struct _TCP {
 		guint32 lastWindow;
 	} send;
 
-	/* congestion control, sequence numbers used for AIMD and slow start */
-	gboolean isSlowStart;
+	/* congestion control algorithm, holds our congestion window */
+	TCPCongestion* cc;
 	struct {
-		/* our current calculated congestion window */
-		gdouble window;
-		guint32 threshold;
 		/* their last advertised window */
 		guint32 lastWindow;
 		/* send sequence number used for last window update */
@@ -134,6 +131,26 @@ struct _TCP {
 		guint32 lastAcknowledgement;
 	} congestion;
 
+	/* loss recovery for algorithms that use fast recovery */
+	struct {
+		/* TRUE from a loss until everything sent before it is acked */
+		gboolean isActive;
+		/* send.next when recovery started */
+		guint32 point;
+		/* with SACK we know every hole and retransmit each right away. without
+		 * it, we only learn of the next hole when a partial ack arrives. */
+		gboolean useSelectiveAcks;
+		/* lost packets waiting for their partial ack, in sequence order */
+		GQueue* lost;
+	} recovery;
+
+	/* counters we log when the socket is freed */
+	struct {
+		guint64 packetsSent;
+		guint64 packetsRetransmitted;
+		guint numRecoveries;
+	} info;
+
 	/* TCP throttles outgoing data packets if too many are in flight */
 	GQueue* throttledOutput;
 	gsize throttledOutputLength;
@@ -154,6 +171,9 @@ struct _TCP {
 	Packet* partialUserDataPacket;
 	guint partialOffset;
 
+	/* our pending TIMEWAIT close timer, if any */
+	Timer* closeTimer;
+
 	/* if I am a server, I parent many multiplexed child sockets */
 	TCPServer* server;
 
@@ -363,6 +383,11 @@ static void _tcp_setState(TCP* tcp, enum TCPState state) {
 			break;
 		}
 		case TCPS_CLOSED: {
+			/* we dont need the close timer if we got here some other way. it
+			 * holds a reference to us, so we cancel it at the very end. */
+			Timer* closeTimer = tcp->closeTimer;
+			tcp->closeTimer = NULL;
+
 			/* user can no longer use socket */
 			descriptor_adjustStatus((Descriptor*)tcp, DS_ACTIVE, FALSE);
 
@@ -389,12 +414,22 @@ static void _tcp_setState(TCP* tcp, enum TCPState state) {
 				/* this will unbind from the network interface and free socket */
 				node_closeDescriptor(worker_getPrivate()->cached_node, tcp->super.super.super.handle);
 			}
+
+			if(closeTimer) {
+				timerwheel_cancel(node_getTimerWheel(worker_getPrivate()->cached_node), closeTimer);
+			}
 			break;
 		}
 		case TCPS_TIMEWAIT: {
-			/* schedule a close timer self-event to finish out the closing process */
-			TCPCloseTimerExpiredEvent* event = tcpclosetimerexpired_new(tcp);
-			worker_scheduleEvent((Event*)event, CONFIG_TCPCLOSETIMER_DELAY, 0);
+			/* schedule a close timer to finish out the closing process. the
+			 * timer holds a reference so we stay alive until it fires. */
+			if(!tcp->closeTimer) {
+				Worker* worker = worker_getPrivate();
+				descriptor_ref(tcp);
+				tcp->closeTimer = timerwheel_add(node_getTimerWheel(worker->cached_node),
+						worker->clock_now + CONFIG_TCPCLOSETIMER_DELAY,
+						(CallbackFunc)tcp_closeTimerExpired, tcp, NULL, descriptor_unref);
+			}
 			break;
 		}
 		default:
@@ -418,7 +453,7 @@ static void _tcp_updateSendWindow(TCP* tcp) {
 	MAGIC_ASSERT(tcp);
 
 	/* send window is minimum of congestion window and the last advertised window */
-	tcp->send.window = MIN(((guint32)tcp->congestion.window), tcp->congestion.lastWindow);
+	tcp->send.window = MIN(((guint32)tcp->cc->window), tcp->congestion.lastWindow);
 	if(tcp->send.window < 1) {
 		tcp->send.window = 1;
 	}
@@ -427,19 +462,9 @@ static void _tcp_updateSendWindow(TCP* tcp) {
 static void _tcp_updateCongestionWindow(TCP* tcp, guint nPacketsAcked) {
 	MAGIC_ASSERT(tcp);
 
-	if(tcp->isSlowStart) {
-		/* threshold not set => no timeout yet => slow start phase 1
-		 *  i.e. multiplicative increase until retransmit event (which sets threshold)
-		 * threshold set => timeout => slow start phase 2
-		 *  i.e. multiplicative increase until threshold */
-		tcp->congestion.window += ((gdouble)nPacketsAcked);
-		if(tcp->congestion.threshold != 0 && tcp->congestion.window >= tcp->congestion.threshold) {
-			tcp->isSlowStart = FALSE;
-		}
-	} else {
-		/* slow start is over
-		 * simple additive increase part of AIMD */
-		tcp->congestion.window += (gdouble)(nPacketsAcked * ((gdouble)(nPacketsAcked / tcp->congestion.window)));
+	/* the window does not grow while we are still repairing losses */
+	if(!tcp->recovery.isActive) {
+		tcpcongestion_packetsAcked(tcp->cc, nPacketsAcked);
 	}
 }
 
@@ -536,6 +561,48 @@ static void _tcp_removeRetransmit(TCP* tcp, guint sequence) {
 	}
 }
 
+static void _tcp_retransmit(TCP* tcp, Packet* packet, guint sequence) {
+	MAGIC_ASSERT(tcp);
+
+	debug("%s <-> %s: retransmitting packet# %u", tcp->super.boundString, tcp->super.peerString, sequence);
+
+	if(packet_getPayloadLength(packet) > 0) {
+		tcp->info.packetsRetransmitted++;
+	}
+	_tcp_removeRetransmit(tcp, sequence);
+	_tcp_bufferPacketOut(tcp, packet);
+}
+
+static void _tcp_updateRecovery(TCP* tcp) {
+	MAGIC_ASSERT(tcp);
+
+	if(!tcp->recovery.isActive) {
+		return;
+	}
+
+	/* a partial ack tells us the next hole, which we may have been holding */
+	Packet* packet = g_queue_peek_head(tcp->recovery.lost);
+	if(packet) {
+		PacketTCPHeader header;
+		packet_getTCPHeader(packet, &header);
+		if(header.sequence <= tcp->send.unacked) {
+			g_queue_pop_head(tcp->recovery.lost);
+			_tcp_retransmit(tcp, packet, header.sequence);
+		}
+	}
+
+	/* everything outstanding when we detected the loss arrived */
+	if(tcp->send.unacked >= tcp->recovery.point) {
+		tcp->recovery.isActive = FALSE;
+		while(!g_queue_is_empty(tcp->recovery.lost)) {
+			packet = g_queue_pop_head(tcp->recovery.lost);
+			PacketTCPHeader header;
+			packet_getTCPHeader(packet, &header);
+			_tcp_retransmit(tcp, packet, header.sequence);
+		}
+	}
+}
+
 static void _tcp_flush(TCP* tcp) {
 	MAGIC_ASSERT(tcp);
 
@@ -578,6 +645,9 @@ static void _tcp_flush(TCP* tcp) {
 
 		/* packet is sendable, we removed it from out buffer */
 		tcp->throttledOutputLength -= length;
+		if(length > 0) {
+			tcp->info.packetsSent++;
+		}
 
 		/* update TCP header to our current advertised window and acknowledgement */
 		packet_updateTCP(packet, tcp->receive.next, tcp->receive.window);
@@ -625,7 +695,7 @@ static void _tcp_flush(TCP* tcp) {
 		if((tcp->receive.next >= tcp->receive.end) && !(tcp->flags & TCPF_EOF_SIGNALED)) {
 			/* user needs to read a 0 so it knows we closed */
 			tcp->error |= TCPE_RECEIVE_EOF;
-			descriptor_adjustStatus((Descriptor*)tcp, DS_READABLE, TRUE);
+			descriptor_signalStatus((Descriptor*)tcp, DS_READABLE);
 		}
 	}
 }
@@ -881,8 +951,8 @@ gboolean tcp_processPacket(TCP* tcp, Packet* packet) {
 				if(tcp->child) {
 					tcp->child->state = TCPCS_PENDING;
 					g_queue_push_tail(tcp->child->parent->server->pending, tcp->child);
-					/* user should accept new child from parent */
-					descriptor_adjustStatus(&(tcp->child->parent->super.super.super), DS_READABLE, TRUE);
+					/* user should accept new child from parent, even if others are pending */
+					descriptor_signalStatus(&(tcp->child->parent->super.super.super), DS_READABLE);
 				}
 			}
 			break;
@@ -1044,6 +1114,9 @@ gboolean tcp_processPacket(TCP* tcp, Packet* packet) {
 
 	/* try to update congestion window based on potentially new info */
 	_tcp_updateCongestionWindow(tcp, nPacketsAcked);
+	if(nPacketsAcked > 0) {
+		_tcp_updateRecovery(tcp);
+	}
 
 	/* now flush as many packets as we can to socket */
 	_tcp_flush(tcp);
@@ -1085,22 +1158,29 @@ void tcp_droppedPacket(TCP* tcp, Packet* packet) {
 		return;
 	}
 
-	/* the packet was "dropped" - this is basically a negative ack.
-	 * handle congestion control.
-	 * TCP-Reno-like fast retransmit, i.e. multiplicative decrease. */
-	tcp->congestion.window /= 2;
-	if(tcp->congestion.window < 1) {
-		tcp->congestion.window = 1;
-	}
-	if(tcp->isSlowStart && tcp->congestion.threshold == 0) {
-		tcp->congestion.threshold = (guint32) tcp->congestion.window;
+	/* the packet was "dropped" - this is basically a negative ack */
+	gboolean carriesData = (packet_getPayloadLength(packet) > 0) ? TRUE : FALSE;
+
+	if(!tcp->cc->usesFastRecovery) {
+		/* every loss shrinks the window */
+		tcpcongestion_packetLost(tcp->cc);
+	} else if(carriesData && (!tcp->recovery.isActive || header.sequence >= tcp->recovery.point)) {
+		/* fast retransmit: the first loss in a window starts recovery, and is
+		 * the only one that shrinks the window */
+		tcp->recovery.isActive = TRUE;
+		tcp->recovery.point = tcp->send.next;
+		tcp->info.numRecoveries++;
+		tcpcongestion_packetLost(tcp->cc);
+	} else if(carriesData && !tcp->recovery.useSelectiveAcks &&
+			header.sequence > tcp->send.unacked) {
+		/* NewReno retransmits a later hole only after the partial ack for the
+		 * earlier ones, so hold it until then */
+		g_queue_insert_sorted(tcp->recovery.lost, packet, (GCompareDataFunc)packet_compareTCPSequence, NULL);
+		return;
 	}
 
-	debug("%s <-> %s: retransmitting packet# %u", tcp->super.boundString, tcp->super.peerString, header.sequence);
-
 	/* buffer and send as appropriate */
-	_tcp_removeRetransmit(tcp, header.sequence);
-	_tcp_bufferPacketOut(tcp, packet);
+	_tcp_retransmit(tcp, packet, header.sequence);
 	_tcp_flush(tcp);
 }
 
@@ -1289,8 +1369,23 @@ void tcp_free(TCP* tcp) {
 	}
 	g_queue_free(tcp->unorderedInput);
 
+	while(g_queue_get_length(tcp->recovery.lost) > 0) {
+		packet_unref(g_queue_pop_head(tcp->recovery.lost));
+	}
+	g_queue_free(tcp->recovery.lost);
+
 	g_hash_table_destroy(tcp->retransmission);
 
+	if(tcp->info.packetsSent > 0) {
+		info("%s <-> %s: [shadow-tcp] congestion control %s%s, sent %"G_GUINT64_FORMAT
+				" data packets, retransmitted %"G_GUINT64_FORMAT", %u loss recoveries",
+				tcp->super.boundString, tcp->super.peerString,
+				tcpcongestion_typeToString(tcp->cc->type),
+				(tcp->cc->usesFastRecovery && tcp->recovery.useSelectiveAcks) ? "+sack" : "",
+				tcp->info.packetsSent, tcp->info.packetsRetransmitted, tcp->info.numRecoveries);
+	}
+	tcpcongestion_free(tcp->cc);
+
 	if(tcp->child) {
 		MAGIC_ASSERT(tcp->child);
 		MAGIC_ASSERT(tcp->child->parent);
@@ -1356,6 +1451,8 @@ void tcp_close(TCP* tcp) {
 
 void tcp_closeTimerExpired(TCP* tcp) {
 	MAGIC_ASSERT(tcp);
+	/* the timer is done, the timer wheel frees it once we return */
+	tcp->closeTimer = NULL;
 	_tcp_setState(tcp, TCPS_CLOSED);
 }
 
@@ -1372,7 +1469,8 @@ SocketFunctionTable tcp_functions = {
 	MAGIC_VALUE
 };
 
-TCP* tcp_new(gint handle, guint receiveBufferSize, guint sendBufferSize) {
+TCP* tcp_new(gint handle, guint receiveBufferSize, guint sendBufferSize,
+		TCPCongestionType congestionType, gboolean useSelectiveAcks) {
 	TCP* tcp = g_new0(TCP, 1);
 	MAGIC_INIT(tcp);
 
@@ -1380,7 +1478,7 @@ TCP* tcp_new(gint handle, guint receiveBufferSize, guint sendBufferSize) {
 
 	guint32 initial_window = worker_getConfig()->initialTCPWindow;
 
-	tcp->congestion.window = (gdouble)initial_window;
+	tcp->cc = tcpcongestion_new(congestionType, initial_window);
 	tcp->congestion.lastWindow = initial_window;
 	tcp->send.window = initial_window;
 	tcp->send.lastWindow = initial_window;
@@ -1399,7 +1497,8 @@ TCP* tcp_new(gint handle, guint receiveBufferSize, guint sendBufferSize) {
 	tcp->receive.next = initialSequenceNumber;
 	tcp->receive.start = initialSequenceNumber;
 
-	tcp->isSlowStart = TRUE;
+	tcp->recovery.useSelectiveAcks = useSelectiveAcks;
+	tcp->recovery.lost = g_queue_new();
 
 	tcp->throttledOutput = g_queue_new();
 	tcp->unorderedInput = g_queue_new();
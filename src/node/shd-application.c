@@ -28,6 +28,10 @@ struct _Application {
 
 	SimulationTime startTime;
 	GString* arguments;
+
+	/* our pending callback timers, by timer ID */
+	GHashTable* timers;
+	guint timerIDCounter;
 	MAGIC_DECLARE;
 };
 
@@ -36,6 +40,9 @@ struct _ApplicationCallbackData {
 	CallbackFunc callback;
 	gpointer data;
 	gpointer argument;
+	Application* application;
+	Timer* timer;
+	guint timerID;
 };
 
 Application* application_new(GQuark pluginID, gchar* pluginPath,
@@ -47,6 +54,9 @@ Application* application_new(GQuark pluginID, gchar* pluginPath,
 	application->pluginPath = g_string_new(pluginPath);
 	application->startTime = startTime;
 	application->arguments = g_string_new(arguments);
+	application->timers = g_hash_table_new(g_direct_hash, g_direct_equal);
+	/* 0 is never a valid timer ID */
+	application->timerIDCounter = 1;
 
 	return application;
 }
@@ -58,6 +68,7 @@ void application_free(Application* application) {
 
 	g_string_free(application->pluginPath, TRUE);
 	g_string_free(application->arguments, TRUE);
+	g_hash_table_destroy(application->timers);
 
 	MAGIC_CLEAR(application);
 	g_free(application);
@@ -138,6 +149,15 @@ void application_start(Application* application) {
 void application_stop(Application* application) {
 	MAGIC_ASSERT(application);
 
+	/* our callbacks are useless once we stop, so dont let them fire */
+	GList* timers = g_hash_table_get_values(application->timers);
+	TimerWheel* wheel = node_getTimerWheel(worker_getPrivate()->cached_node);
+	for(GList* item = timers; item != NULL; item = g_list_next(item)) {
+		ApplicationCallbackData* data = item->data;
+		timerwheel_cancel(wheel, data->timer);
+	}
+	g_list_free(timers);
+
 	/* we only have state if we are running */
 	if(application_isRunning(application)) {
 		/* need to get thread-private plugin from current worker */
@@ -168,7 +188,17 @@ void application_notify(Application* application) {
 	}
 }
 
-static void _application_callbackTimerExpired(Application* application, ApplicationCallbackData* data) {
+void application_hibernate(Application* application) {
+	MAGIC_ASSERT(application);
+
+	/* the plug-in wakes the state up again the next time it runs */
+	if(application_isRunning(application)) {
+		Plugin* plugin = worker_getPlugin(application->pluginID, application->pluginPath);
+		plugin_hibernateState(plugin, application->state);
+	}
+}
+
+static void _application_callbackTimerExpired(ApplicationCallbackData* data, Application* application) {
 	MAGIC_ASSERT(application);
 	g_assert(data);
 
@@ -182,12 +212,17 @@ static void _application_callbackTimerExpired(Application* application, Applicat
 		plugin_executeGeneric(plugin, application->state, data->callback, data->data, data->argument);
 		worker->cached_application = NULL;
 	}
+}
 
+static void _application_callbackTimerFree(ApplicationCallbackData* data) {
+	g_assert(data);
+	/* the timer fired or was cancelled, either way its gone */
+	g_hash_table_remove(data->application->timers, GUINT_TO_POINTER(data->timerID));
 	g_free(data);
 }
 
-void application_callback(Application* application, CallbackFunc userCallback,
-		gpointer userData, gpointer userArgument, guint millisecondsDelay) {
+guint application_createTimer(Application* application, CallbackFunc userCallback,
+		gpointer userData, gpointer userArgument, SimulationTime nanosecondsDelay) {
 	MAGIC_ASSERT(application);
 	g_assert(application_isRunning(application));
 
@@ -200,10 +235,52 @@ void application_callback(Application* application, CallbackFunc userCallback,
 	data->callback = userCallback;
 	data->data = userData;
 	data->argument = userArgument;
+	data->application = application;
+	data->timerID = application->timerIDCounter++;
 
-	CallbackEvent* event = callback_new((CallbackFunc)_application_callbackTimerExpired, application, data);
-	SimulationTime nanos = SIMTIME_ONE_MILLISECOND * millisecondsDelay;
+	Worker* worker = worker_getPrivate();
 
-	/* callback to our own node */
-	worker_scheduleEvent((Event*)event, nanos, 0);
+	/* callback to our own node, through its timer wheel */
+	data->timer = timerwheel_add(node_getTimerWheel(worker->cached_node),
+			worker->clock_now + nanosecondsDelay, (CallbackFunc)_application_callbackTimerExpired,
+			data, application, (GDestroyNotify)_application_callbackTimerFree);
+	g_hash_table_replace(application->timers, GUINT_TO_POINTER(data->timerID), data);
+
+	return data->timerID;
+}
+
+gboolean application_cancelTimer(Application* application, guint timerID) {
+	MAGIC_ASSERT(application);
+
+	/* the timer may have already fired or been cancelled */
+	ApplicationCallbackData* data = g_hash_table_lookup(application->timers, GUINT_TO_POINTER(timerID));
+	if(!data) {
+		return FALSE;
+	}
+
+	Worker* worker = worker_getPrivate();
+	timerwheel_cancel(node_getTimerWheel(worker->cached_node), data->timer);
+	return TRUE;
+}
+
+gboolean application_rescheduleTimer(Application* application, guint timerID,
+		SimulationTime nanosecondsDelay) {
+	MAGIC_ASSERT(application);
+
+	/* the timer may have already fired or been cancelled */
+	ApplicationCallbackData* data = g_hash_table_lookup(application->timers, GUINT_TO_POINTER(timerID));
+	if(!data) {
+		return FALSE;
+	}
+
+	Worker* worker = worker_getPrivate();
+	timerwheel_reschedule(node_getTimerWheel(worker->cached_node), data->timer,
+			worker->clock_now + nanosecondsDelay);
+	return TRUE;
+}
+
+void application_callback(Application* application, CallbackFunc userCallback,
+		gpointer userData, gpointer userArgument, guint millisecondsDelay) {
+	application_createTimer(application, userCallback, userData, userArgument,
+			SIMTIME_ONE_MILLISECOND * millisecondsDelay);
 }
@@ -35,7 +35,13 @@ void application_stop(Application* application);
 gboolean application_isRunning(Application* application);
 
 void application_notify(Application* application);
+void application_hibernate(Application* application);
 void application_callback(Application* application, CallbackFunc userCallback,
 		gpointer userData, gpointer userArgument, guint millisecondsDelay);
+guint application_createTimer(Application* application, CallbackFunc userCallback,
+		gpointer userData, gpointer userArgument, SimulationTime nanosecondsDelay);
+gboolean application_cancelTimer(Application* application, guint timerID);
+gboolean application_rescheduleTimer(Application* application, guint timerID,
+		SimulationTime nanosecondsDelay);
 
 #endif /* SHD_APPLICATION_H_ */
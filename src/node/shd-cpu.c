@@ -24,6 +24,10 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
 #include "shadow.h"
 
@@ -38,6 +42,24 @@ struct _CPU {
 	MAGIC_DECLARE;
 };
 
+struct _CPUTimer {
+	CPUDelayModel model;
+	/* for CPU_DELAY_WALLCLOCK */
+	GTimer* wallTimer;
+	/* for CPU_DELAY_INSTRUCTIONS and CPU_DELAY_CYCLES */
+	gint counterDescriptor;
+	/* counter or TSC value when the timer was last started */
+	guint64 startValue;
+	/* counter or TSC value when the timer was paused, if it is */
+	guint64 pauseValue;
+	gboolean isPaused;
+	MAGIC_DECLARE;
+};
+
+/* TSC ticks per millisecond, calibrated once for the whole process */
+static GOnce tscCalibrationOnce = G_ONCE_INIT;
+static guint64 tscFrequencyKHz = 0;
+
 CPU* cpu_new(guint frequencyKHz, gint threshold, gint precision) {
 	CPU* cpu = g_new0(CPU, 1);
 	MAGIC_INIT(cpu);
@@ -97,12 +119,7 @@ void cpu_updateTime(CPU* cpu, SimulationTime now) {
 	cpu->timeCPUAvailable = (SimulationTime) MAX(cpu->timeCPUAvailable, now);
 }
 
-void cpu_addDelay(CPU* cpu, SimulationTime delay) {
-	MAGIC_ASSERT(cpu);
-
-	/* first normalize the physical CPU to the virtual CPU */
-	SimulationTime adjustedDelay = (SimulationTime) (cpu->frequencyRatio * delay);
-
+static void _cpu_addAdjustedDelay(CPU* cpu, SimulationTime adjustedDelay) {
 	/* round the adjusted delay to the nearest precision if needed */
 	if(cpu->precision != SIMTIME_INVALID) {
 		SimulationTime remainder = (SimulationTime) (adjustedDelay % cpu->precision);
@@ -120,3 +137,263 @@ void cpu_addDelay(CPU* cpu, SimulationTime delay) {
 
 	cpu->timeCPUAvailable += adjustedDelay;
 }
+
+void cpu_addDelay(CPU* cpu, SimulationTime delay) {
+	MAGIC_ASSERT(cpu);
+
+	/* first normalize the physical CPU to the virtual CPU */
+	SimulationTime adjustedDelay = (SimulationTime) (cpu->frequencyRatio * delay);
+	_cpu_addAdjustedDelay(cpu, adjustedDelay);
+}
+
+void cpu_addCycles(CPU* cpu, guint64 cycles) {
+	MAGIC_ASSERT(cpu);
+
+	/* cycles are host independent, so convert directly at the virtual speed */
+	SimulationTime adjustedDelay = (SimulationTime) ((cycles * SIMTIME_ONE_MILLISECOND) / cpu->frequencyKHz);
+	_cpu_addAdjustedDelay(cpu, adjustedDelay);
+}
+
+gsize cpu_getMemoryUsage(CPU* cpu) {
+	MAGIC_ASSERT(cpu);
+	return sizeof(CPU);
+}
+
+CPUDelayModel cpu_getDelayModel(const gchar* input) {
+	if(input == NULL) {
+		return CPU_DELAY_WALLCLOCK;
+	} else if(g_ascii_strcasecmp(input, "none") == 0) {
+		return CPU_DELAY_NONE;
+	} else if(g_ascii_strcasecmp(input, "instructions") == 0) {
+		return CPU_DELAY_INSTRUCTIONS;
+	} else if(g_ascii_strcasecmp(input, "cycles") == 0) {
+		return CPU_DELAY_CYCLES;
+	} else if(g_ascii_strcasecmp(input, "tsc") == 0) {
+		return CPU_DELAY_TSC;
+	} else if(g_ascii_strcasecmp(input, "wallclock") == 0) {
+		return CPU_DELAY_WALLCLOCK;
+	} else {
+		warning("unknown CPU delay model '%s', using 'wallclock'", input);
+		return CPU_DELAY_WALLCLOCK;
+	}
+}
+
+static gboolean _cputimer_hasTSC() {
+#if defined(__x86_64__) || defined(__i386__)
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+static guint64 _cputimer_readTSC() {
+#if defined(__x86_64__) || defined(__i386__)
+	return (guint64) __builtin_ia32_rdtsc();
+#else
+	return 0;
+#endif
+}
+
+static gpointer _cputimer_calibrateTSC(gpointer data) {
+	/* count ticks against the monotonic clock over a short sleep */
+	gint64 startMicros = g_get_monotonic_time();
+	guint64 startTicks = _cputimer_readTSC();
+	g_usleep(20000);
+	guint64 endTicks = _cputimer_readTSC();
+	gint64 endMicros = g_get_monotonic_time();
+
+	gint64 elapsedMicros = endMicros - startMicros;
+	if(elapsedMicros > 0 && endTicks > startTicks) {
+		tscFrequencyKHz = ((endTicks - startTicks) * 1000) / ((guint64)elapsedMicros);
+	}
+
+	message("calibrated TSC frequency at %"G_GUINT64_FORMAT" KHz", tscFrequencyKHz);
+	return NULL;
+}
+
+static gint _cputimer_openCounter(CPUDelayModel model) {
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(struct perf_event_attr));
+
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(struct perf_event_attr);
+	attr.config = model == CPU_DELAY_CYCLES ? PERF_COUNT_HW_CPU_CYCLES : PERF_COUNT_HW_INSTRUCTIONS;
+	/* only count what runs in user space on the calling thread */
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	return (gint) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static guint64 _cputimer_readCounter(CPUTimer* timer) {
+	guint64 value = 0;
+	if(read(timer->counterDescriptor, &value, sizeof(guint64)) != sizeof(guint64)) {
+		return timer->startValue;
+	}
+	return value;
+}
+
+CPUTimer* cputimer_new(CPUDelayModel model) {
+	CPUTimer* timer = g_new0(CPUTimer, 1);
+	MAGIC_INIT(timer);
+
+	timer->counterDescriptor = -1;
+
+	/* counters were asked for to get reproducible delays, so do not quietly
+	 * replace them with a clock that measures host noise */
+	if(model == CPU_DELAY_INSTRUCTIONS || model == CPU_DELAY_CYCLES) {
+		timer->counterDescriptor = _cputimer_openCounter(model);
+		if(timer->counterDescriptor < 0) {
+			error("perf_event_open() failed for CPU delay counters: %s. "
+					"check /proc/sys/kernel/perf_event_paranoid or choose another --cpu-delay-model",
+					g_strerror(errno));
+		}
+	}
+	/* fall back from the TSC to the wall clock, as available */
+	if(model == CPU_DELAY_TSC) {
+		if(_cputimer_hasTSC()) {
+			g_once(&tscCalibrationOnce, _cputimer_calibrateTSC, NULL);
+		}
+		if(!tscFrequencyKHz) {
+			warning("TSC is not usable for CPU delays, falling back to 'wallclock'");
+			model = CPU_DELAY_WALLCLOCK;
+		}
+	}
+	if(model == CPU_DELAY_WALLCLOCK) {
+		timer->wallTimer = g_timer_new();
+	}
+
+	timer->model = model;
+	return timer;
+}
+
+void cputimer_free(CPUTimer* timer) {
+	MAGIC_ASSERT(timer);
+
+	if(timer->wallTimer) {
+		g_timer_destroy(timer->wallTimer);
+	}
+	if(timer->counterDescriptor >= 0) {
+		close(timer->counterDescriptor);
+	}
+
+	MAGIC_CLEAR(timer);
+	g_free(timer);
+}
+
+void cputimer_start(CPUTimer* timer) {
+	MAGIC_ASSERT(timer);
+
+	switch(timer->model) {
+		case CPU_DELAY_INSTRUCTIONS:
+		case CPU_DELAY_CYCLES: {
+			timer->startValue = _cputimer_readCounter(timer);
+			break;
+		}
+		case CPU_DELAY_TSC: {
+			timer->startValue = _cputimer_readTSC();
+			break;
+		}
+		case CPU_DELAY_WALLCLOCK: {
+			g_timer_start(timer->wallTimer);
+			break;
+		}
+		case CPU_DELAY_NONE:
+		default: {
+			break;
+		}
+	}
+}
+
+void cputimer_pause(CPUTimer* timer) {
+	MAGIC_ASSERT(timer);
+	g_assert(!timer->isPaused);
+
+	switch(timer->model) {
+		case CPU_DELAY_INSTRUCTIONS:
+		case CPU_DELAY_CYCLES: {
+			timer->pauseValue = _cputimer_readCounter(timer);
+			break;
+		}
+		case CPU_DELAY_TSC: {
+			timer->pauseValue = _cputimer_readTSC();
+			break;
+		}
+		case CPU_DELAY_WALLCLOCK: {
+			g_timer_stop(timer->wallTimer);
+			break;
+		}
+		case CPU_DELAY_NONE:
+		default: {
+			break;
+		}
+	}
+
+	timer->isPaused = TRUE;
+}
+
+void cputimer_resume(CPUTimer* timer) {
+	MAGIC_ASSERT(timer);
+	g_assert(timer->isPaused);
+
+	/* shift the start forward by however long we were paused */
+	switch(timer->model) {
+		case CPU_DELAY_INSTRUCTIONS:
+		case CPU_DELAY_CYCLES: {
+			timer->startValue += _cputimer_readCounter(timer) - timer->pauseValue;
+			break;
+		}
+		case CPU_DELAY_TSC: {
+			timer->startValue += _cputimer_readTSC() - timer->pauseValue;
+			break;
+		}
+		case CPU_DELAY_WALLCLOCK: {
+			g_timer_continue(timer->wallTimer);
+			break;
+		}
+		case CPU_DELAY_NONE:
+		default: {
+			break;
+		}
+	}
+
+	timer->isPaused = FALSE;
+}
+
+SimulationTime cputimer_stop(CPUTimer* timer, CPU* cpu) {
+	MAGIC_ASSERT(timer);
+	MAGIC_ASSERT(cpu);
+	g_assert(!timer->isPaused);
+
+	SimulationTime delay = 0;
+
+	switch(timer->model) {
+		case CPU_DELAY_INSTRUCTIONS:
+		case CPU_DELAY_CYCLES: {
+			/* we treat one instruction as one cycle of the virtual CPU */
+			guint64 count = _cputimer_readCounter(timer) - timer->startValue;
+			delay = (SimulationTime) ((count * SIMTIME_ONE_MILLISECOND) / cpu->frequencyKHz);
+			cpu_addCycles(cpu, count);
+			break;
+		}
+		case CPU_DELAY_TSC: {
+			guint64 ticks = _cputimer_readTSC() - timer->startValue;
+			delay = (SimulationTime) ((ticks * SIMTIME_ONE_MILLISECOND) / tscFrequencyKHz);
+			cpu_addDelay(cpu, delay);
+			break;
+		}
+		case CPU_DELAY_WALLCLOCK: {
+			/* no need to call stop */
+			gdouble elapsed = g_timer_elapsed(timer->wallTimer, NULL);
+			delay = (SimulationTime) (elapsed * SIMTIME_ONE_SECOND);
+			cpu_addDelay(cpu, delay);
+			break;
+		}
+		case CPU_DELAY_NONE:
+		default: {
+			break;
+		}
+	}
+
+	return delay;
+}
@@ -23,6 +23,24 @@
 #define SHD_CPU_H_
 
 typedef struct _CPU CPU;
+typedef struct _CPUTimer CPUTimer;
+
+/**
+ * How the CPU time a plug-in consumes is measured and charged to its node.
+ */
+typedef enum _CPUDelayModel CPUDelayModel;
+enum _CPUDelayModel {
+	/* plug-ins run for free; fully deterministic */
+	CPU_DELAY_NONE,
+	/* user-space instructions retired on the worker thread; reproducible */
+	CPU_DELAY_INSTRUCTIONS,
+	/* user-space cycles on the worker thread */
+	CPU_DELAY_CYCLES,
+	/* time stamp counter, calibrated against the monotonic clock */
+	CPU_DELAY_TSC,
+	/* wall clock time from a GTimer */
+	CPU_DELAY_WALLCLOCK,
+};
 
 CPU* cpu_new(guint frequencyMHz, gint threshold, gint precision);
 void cpu_free(CPU* cpu);
@@ -30,6 +48,17 @@ void cpu_free(CPU* cpu);
 gboolean cpu_isBlocked(CPU* cpu);
 void cpu_updateTime(CPU* cpu, SimulationTime now);
 void cpu_addDelay(CPU* cpu, SimulationTime delay);
+void cpu_addCycles(CPU* cpu, guint64 cycles);
+gsize cpu_getMemoryUsage(CPU* cpu);
 SimulationTime cpu_getDelay(CPU* cpu);
 
+CPUDelayModel cpu_getDelayModel(const gchar* input);
+
+CPUTimer* cputimer_new(CPUDelayModel model);
+void cputimer_free(CPUTimer* timer);
+void cputimer_start(CPUTimer* timer);
+void cputimer_pause(CPUTimer* timer);
+void cputimer_resume(CPUTimer* timer);
+SimulationTime cputimer_stop(CPUTimer* timer, CPU* cpu);
+
 #endif /* SHD_CPU_H_ */
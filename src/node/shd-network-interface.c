@@ -23,8 +23,10 @@
 
 enum NetworkInterfaceFlags {
 	NIF_NONE = 0,
+	/* a wake-up event is pending for each direction */
 	NIF_SENDING = 1 << 0,
 	NIF_RECEIVING = 1 << 1,
+	NIF_DELIVERING = 1 << 2,
 };
 
 enum NetworkInterfaceQDisc {
@@ -46,11 +48,14 @@ struct _NetworkInterface {
 	/* (protocol,port)-to-socket bindings */
 	GHashTable* boundSockets;
 
-	/* NIC input queue */
+	/* NIC input queue of packets waiting for the downlink, and its byte limit */
 	GQueue* inBuffer;
 	gsize inBufferSize;
 	gsize inBufferLength;
 
+	/* packets to ourselves, handed straight to the destination socket */
+	GQueue* localBuffer;
+
 	/* Transports wanting to send data out */
 	GQueue* rrQueue;
 	PriorityQueue* fifoQueue;
@@ -60,14 +65,23 @@ struct _NetworkInterface {
 	gchar* pcapDir;
 	FILE *pcapFile;
 
-	/* bandwidth accounting */
-	SimulationTime lastTimeReceived;
-	SimulationTime lastTimeSent;
-	gdouble sendNanosecondsConsumed;
-	gdouble receiveNanosecondsConsumed;
+	/*
+	 * bandwidth accounting. each link is a virtual clock: the time, in
+	 * nanoseconds, at which it finishes the last packet given to it. a packet
+	 * starts when both it and the link are ready.
+	 */
+	gdouble sendFinishTime;
+	gdouble receiveFinishTime;
 	MAGIC_DECLARE;
 };
 
+/* a packet waiting in the input queue until the downlink finishes it */
+typedef struct _NetworkInterfaceArrival NetworkInterfaceArrival;
+struct _NetworkInterfaceArrival {
+	Packet* packet;
+	SimulationTime finishTime;
+};
+
 static void _networkinterface_pcapInit(NetworkInterface *interface) {
 	if(!interface || !interface->logPcap || !interface->pcapFile) {
 		return;
@@ -124,6 +138,7 @@ NetworkInterface* networkinterface_new(Network* network, GQuark address, gchar*
 	/* incoming packet buffer */
 	interface->inBuffer = g_queue_new();
 	interface->inBufferSize = interfaceReceiveLength;
+	interface->localBuffer = g_queue_new();
 
 	/* incoming packets get passed along to sockets */
 	interface->boundSockets = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, descriptor_unref);
@@ -180,11 +195,17 @@ void networkinterface_free(NetworkInterface* interface) {
 
 	/* unref all packets sitting in our input buffer */
 	while(interface->inBuffer && !g_queue_is_empty(interface->inBuffer)) {
-		Packet* packet = g_queue_pop_head(interface->inBuffer);
-		packet_unref(packet);
+		NetworkInterfaceArrival* arrival = g_queue_pop_head(interface->inBuffer);
+		packet_unref(arrival->packet);
+		g_free(arrival);
 	}
 	g_queue_free(interface->inBuffer);
 
+	while(interface->localBuffer && !g_queue_is_empty(interface->localBuffer)) {
+		packet_unref(g_queue_pop_head(interface->localBuffer));
+	}
+	g_queue_free(interface->localBuffer);
+
 	/* unref all sockets wanting to send */
 	while(interface->rrQueue && !g_queue_is_empty(interface->rrQueue)) {
 		Socket* socket = g_queue_pop_head(interface->rrQueue);
@@ -225,6 +246,21 @@ guint32 networkinterface_getSpeedDownKiBps(NetworkInterface* interface) {
 	return interface->bwDownKiBps;
 }
 
+gsize networkinterface_getMemoryUsage(NetworkInterface* interface) {
+	MAGIC_ASSERT(interface);
+
+	/* queued packets are counted with the sockets that own them */
+	gsize bytes = sizeof(NetworkInterface);
+	bytes += g_hash_table_size(interface->boundSockets) * UTILITY_HASH_ENTRY_SIZE;
+	bytes += g_queue_get_length(interface->inBuffer) *
+			(UTILITY_QUEUE_ENTRY_SIZE + sizeof(NetworkInterfaceArrival));
+	bytes += g_queue_get_length(interface->localBuffer) * UTILITY_QUEUE_ENTRY_SIZE;
+	bytes += g_queue_get_length(interface->rrQueue) * UTILITY_QUEUE_ENTRY_SIZE;
+	bytes += priorityqueue_getLength(interface->fifoQueue) *
+			(sizeof(gpointer) + UTILITY_HASH_ENTRY_SIZE);
+	return bytes;
+}
+
 gboolean networkinterface_isAssociated(NetworkInterface* interface, gint key) {
 	MAGIC_ASSERT(interface);
 
@@ -370,61 +406,69 @@ static void _networkinterface_dropInboundPacket(NetworkInterface* interface, Pac
 		worker_scheduleEvent((Event*)event, 1, 0);
 	} else {
 		/* let the network schedule the event with appropriate delays */
-		network_scheduleRetransmit(interface->network, packet);
+		network_scheduleRetransmit(interface->network, packet, 0);
 	}
 }
 
-static void _networkinterface_scheduleNextReceive(NetworkInterface* interface) {
-	/* the next packets need to be received and processed */
-	SimulationTime batchTime = worker_getConfig()->interfaceBatchTime;
+static void _networkinterface_pushToSocket(NetworkInterface* interface, Packet* packet) {
+	/* hand it off to the correct socket layer */
+	gint key = packet_getDestinationAssociationKey(packet);
+	Socket* socket = g_hash_table_lookup(interface->boundSockets, GINT_TO_POINTER(key));
 
-	/* receive packets in batches */
-	while(!g_queue_is_empty(interface->inBuffer) &&
-			interface->receiveNanosecondsConsumed <= batchTime) {
-		/* get the next packet */
-		Packet* packet = g_queue_pop_head(interface->inBuffer);
-		g_assert(packet);
+	/* if the socket closed, just drop the packet */
+	if(socket) {
+		gboolean needsRetransmit = socket_pushInPacket(socket, packet);
+		if(needsRetransmit) {
+			/* socket can not handle it now, so drop it */
+			_networkinterface_dropInboundPacket(interface, packet);
+		}
+	}
+}
 
-		/* free up buffer space */
-		guint length = packet_getPayloadLength(packet) + packet_getHeaderSize(packet);
-		interface->inBufferLength -= length;
+static void _networkinterface_receivePacket(NetworkInterface* interface, Packet* packet) {
+	guint length = packet_getPayloadLength(packet) + packet_getHeaderSize(packet);
 
-		/* hand it off to the correct socket layer */
-		gint key = packet_getDestinationAssociationKey(packet);
-		Socket* socket = g_hash_table_lookup(interface->boundSockets, GINT_TO_POINTER(key));
+	gchar* packetString = packet_getString(packet);
+	debug("packet in: %s", packetString);
+	g_free(packetString);
 
-		gchar* packetString = packet_getString(packet);
-		debug("packet in: %s", packetString);
-		g_free(packetString);
+	_networkinterface_pcapWritePacket(interface, packet);
+	_networkinterface_pushToSocket(interface, packet);
 
-		_networkinterface_pcapWritePacket(interface, packet);
+	tracker_addInputBytes(node_getTracker(worker_getPrivate()->cached_node),(guint64)length);
+}
 
-		/* if the socket closed, just drop the packet */
-		if(socket) {
-			gboolean needsRetransmit = socket_pushInPacket(socket, packet);
-			if(needsRetransmit) {
-				/* socket can not handle it now, so drop it */
-				_networkinterface_dropInboundPacket(interface, packet);
-			}
+static void _networkinterface_scheduleNextReceive(NetworkInterface* interface) {
+	SimulationTime now = worker_getPrivate()->clock_now;
+
+	/* everything the downlink finishes within one more MTU goes up to the
+	 * sockets now, so a saturated link does not wake up for every packet */
+	SimulationTime dueTime = now + (SimulationTime) ceil(CONFIG_MTU * interface->timePerByteDown);
+	while(!g_queue_is_empty(interface->inBuffer)) {
+		NetworkInterfaceArrival* arrival = g_queue_peek_head(interface->inBuffer);
+		if(arrival->finishTime > dueTime) {
+			break;
 		}
+		g_queue_pop_head(interface->inBuffer);
+
+		Packet* packet = arrival->packet;
+		g_free(arrival);
 
-		/* successfully received, calculate how long it took to 'receive' this packet */
-		interface->receiveNanosecondsConsumed += (length * interface->timePerByteDown);
-		tracker_addInputBytes(node_getTracker(worker_getPrivate()->cached_node),(guint64)length);
+		/* free up buffer space */
+		interface->inBufferLength -= packet_getPayloadLength(packet) + packet_getHeaderSize(packet);
+
+		_networkinterface_receivePacket(interface, packet);
 	}
 
-	/*
-	 * we need to call back and try to receive more, even if we didnt consume all
-	 * of our batch time, because we might have more packets to receive then.
-	 */
-	SimulationTime receiveTime = (SimulationTime) floor(interface->receiveNanosecondsConsumed);
-	if(receiveTime >= SIMTIME_ONE_NANOSECOND) {
-		/* we are 'receiving' the packets */
+	/* wake up when the downlink finishes the next one */
+	if(!g_queue_is_empty(interface->inBuffer) && !(interface->flags & NIF_RECEIVING)) {
+		NetworkInterfaceArrival* arrival = g_queue_peek_head(interface->inBuffer);
+		SimulationTime delay = arrival->finishTime - now;
+
 		interface->flags |= NIF_RECEIVING;
-		/* call back when the packets are 'received' */
 		InterfaceReceivedEvent* event = interfacereceived_new(interface);
 		/* event destination is our node */
-		worker_scheduleEvent((Event*)event, receiveTime, 0);
+		worker_scheduleEvent((Event*)event, delay, 0);
 	}
 }
 
@@ -432,19 +476,30 @@ void networkinterface_packetArrived(NetworkInterface* interface, Packet* packet)
 	MAGIC_ASSERT(interface);
 
 	/* a packet arrived. lets try to receive or buffer it */
+	SimulationTime now = worker_getPrivate()->clock_now;
 	guint length = packet_getPayloadLength(packet) + packet_getHeaderSize(packet);
 	gssize space = interface->inBufferSize - interface->inBufferLength;
 	g_assert(space >= 0);
 
-	if(length <= space) {
-		/* we have space to buffer it */
-		g_queue_push_tail(interface->inBuffer, packet);
+	/* the downlink starts on it when it is done with everything before it */
+	gdouble startTime = MAX((gdouble)now, interface->receiveFinishTime);
+	gboolean isIdle = (startTime <= (gdouble)now && g_queue_is_empty(interface->inBuffer)) ? TRUE : FALSE;
+
+	if(isIdle) {
+		/* nothing ahead of it, it was received as its last byte arrived */
+		interface->receiveFinishTime = startTime + (length * interface->timePerByteDown);
+		_networkinterface_receivePacket(interface, packet);
+	} else if(length <= space) {
+		/* we have space to buffer it until the downlink is done with it */
+		interface->receiveFinishTime = startTime + (length * interface->timePerByteDown);
+
+		NetworkInterfaceArrival* arrival = g_new0(NetworkInterfaceArrival, 1);
+		arrival->packet = packet;
+		arrival->finishTime = (SimulationTime) ceil(interface->receiveFinishTime);
+		g_queue_push_tail(interface->inBuffer, arrival);
 		interface->inBufferLength += length;
 
-		/* we need a trigger if we are not currently receiving */
-		if(!(interface->flags & NIF_RECEIVING)) {
-			_networkinterface_scheduleNextReceive(interface);
-		}
+		_networkinterface_scheduleNextReceive(interface);
 	} else {
 		/* buffers are full, drop packet */
 		_networkinterface_dropInboundPacket(interface, packet);
@@ -454,23 +509,55 @@ void networkinterface_packetArrived(NetworkInterface* interface, Packet* packet)
 void networkinterface_received(NetworkInterface* interface) {
 	MAGIC_ASSERT(interface);
 
-	/* we just finished receiving some packets */
+	/* our wake-up fired, receive whatever is done */
 	interface->flags &= ~NIF_RECEIVING;
+	_networkinterface_scheduleNextReceive(interface);
+}
 
-	/* decide how much delay we get to absorb based on the passed time */
-	SimulationTime now = worker_getPrivate()->clock_now;
-	SimulationTime absorbInterval = now - interface->lastTimeReceived;
+gboolean networkinterface_sendLocal(NetworkInterface* interface, Packet* packet) {
+	MAGIC_ASSERT(interface);
 
-	if(absorbInterval > 0) {
-		/* decide how much delay we get to absorb based on the passed time */
-		gdouble newConsumed = interface->receiveNanosecondsConsumed - absorbInterval;
-		interface->receiveNanosecondsConsumed = MAX(0, newConsumed);
+	/* only packets to ourselves qualify, and only if they need not show up
+	 * in a pcap file. those never see the uplink, the downlink or the network. */
+	if(interface->logPcap || networkinterface_getIPAddress(interface) != packet_getDestinationIP(packet)) {
+		return FALSE;
 	}
 
-	interface->lastTimeReceived = now;
+	/* hold our own reference until it is delivered, like a packet event would */
+	packet_ref(packet);
+	g_queue_push_tail(interface->localBuffer, packet);
 
-	/* now try to receive the next ones */
-	_networkinterface_scheduleNextReceive(interface);
+	guint length = packet_getPayloadLength(packet) + packet_getHeaderSize(packet);
+	tracker_addOutputBytes(node_getTracker(worker_getPrivate()->cached_node),(guint64)length);
+
+	/* everything sent before the wake-up is delivered by it */
+	if(!(interface->flags & NIF_DELIVERING)) {
+		interface->flags |= NIF_DELIVERING;
+		InterfaceDeliveredEvent* event = interfacedelivered_new(interface);
+		/* event destination is our node */
+		worker_scheduleEvent((Event*)event, 1, 0);
+	}
+
+	return TRUE;
+}
+
+void networkinterface_delivered(NetworkInterface* interface) {
+	MAGIC_ASSERT(interface);
+
+	/* deliver only what is queued now. replies the sockets send while we
+	 * deliver wait for the next wake-up, as they would on a real loopback. */
+	interface->flags &= ~NIF_DELIVERING;
+	guint remaining = g_queue_get_length(interface->localBuffer);
+	guint64 totalLength = 0;
+
+	while(remaining-- > 0) {
+		Packet* packet = g_queue_pop_head(interface->localBuffer);
+		totalLength += packet_getPayloadLength(packet) + packet_getHeaderSize(packet);
+		_networkinterface_pushToSocket(interface, packet);
+		packet_unref(packet);
+	}
+
+	tracker_addInputBytes(node_getTracker(worker_getPrivate()->cached_node), totalLength);
 }
 
 void networkinterface_packetDropped(NetworkInterface* interface, Packet* packet) {
@@ -536,13 +623,28 @@ static Packet* _networkinterface_selectFirstInFirstOut(NetworkInterface* interfa
 	return packet;
 }
 
+static gboolean _networkinterface_hasSendablePackets(NetworkInterface* interface) {
+	switch(interface->qdisc) {
+		case NIQ_RR: {
+			return !g_queue_is_empty(interface->rrQueue);
+		}
+		case NIQ_FIFO:
+		default: {
+			return !priorityqueue_isEmpty(interface->fifoQueue);
+		}
+	}
+}
+
 static void _networkinterface_scheduleNextSend(NetworkInterface* interface) {
-	/* the next packet needs to be sent according to bandwidth limitations.
-	 * we need to spend time sending it before sending the next. */
-	SimulationTime batchTime = worker_getConfig()->interfaceBatchTime;
+	/* each packet leaves when the uplink is done with the packets before it.
+	 * we hand packets to the network right away, stamped with that departure
+	 * time, but only about one MTU ahead. the qdisc should still choose the
+	 * next packet close to when it leaves, or a socket that writes later
+	 * would queue behind bulk data that is already committed. */
+	SimulationTime now = worker_getPrivate()->clock_now;
+	gdouble backlogLimit = CONFIG_MTU * interface->timePerByteUp;
 
-	/* loop until we find a socket that has something to send */
-	while(interface->sendNanosecondsConsumed <= batchTime) {
+	while(interface->sendFinishTime - (gdouble)now < backlogLimit) {
 
 		/* choose which packet to send next based on our queuing discipline */
 		Packet* packet;
@@ -561,41 +663,40 @@ static void _networkinterface_scheduleNextSend(NetworkInterface* interface) {
 			break;
 		}
 
+		/* calculate when the uplink finishes 'sending' this packet */
+		guint length = packet_getPayloadLength(packet) + packet_getHeaderSize(packet);
+		gdouble startTime = MAX((gdouble)now, interface->sendFinishTime);
+		interface->sendFinishTime = startTime + (length * interface->timePerByteUp);
+		SimulationTime departureDelay = (SimulationTime) ceil(interface->sendFinishTime - (gdouble)now);
+
 		/* now actually send the packet somewhere */
 		if(networkinterface_getIPAddress(interface) == packet_getDestinationIP(packet)) {
 			/* packet will arrive on our own interface */
 			PacketArrivedEvent* event = packetarrived_new(packet);
 			/* event destination is our node */
-			worker_scheduleEvent((Event*)event, 1, 0);
+			worker_scheduleEvent((Event*)event, MAX(departureDelay, 1), 0);
 		} else {
 			/* let the network schedule with appropriate delays */
-			network_schedulePacket(interface->network, packet);
+			network_schedulePacket(interface->network, packet, departureDelay);
 		}
 
 		gchar* packetString = packet_getString(packet);
 		debug("packet out: %s", packetString);
 		g_free(packetString);
 
-		/* successfully sent, calculate how long it took to 'send' this packet */
-		guint length = packet_getPayloadLength(packet) + packet_getHeaderSize(packet);
-
-		interface->sendNanosecondsConsumed += (length * interface->timePerByteUp);
 		tracker_addOutputBytes(node_getTracker(worker_getPrivate()->cached_node),(guint64)length);
 		_networkinterface_pcapWritePacket(interface, packet);
 	}
 
-	/*
-	 * we need to call back and try to send more, even if we didnt consume all
-	 * of our batch time, because we might have more packets to send then.
-	 */
-	SimulationTime sendTime = (SimulationTime) floor(interface->sendNanosecondsConsumed);
-	if(sendTime >= SIMTIME_ONE_NANOSECOND) {
-		/* we are 'sending' the packets */
+	/* if packets are still waiting, call back when the last committed one has
+	 * left. sockets that get new packets while we have room trigger the next send. */
+	if(_networkinterface_hasSendablePackets(interface) && !(interface->flags & NIF_SENDING)) {
+		SimulationTime delay = (SimulationTime) MAX(ceil(interface->sendFinishTime - (gdouble)now), 1);
+
 		interface->flags |= NIF_SENDING;
-		/* call back when the packets are 'sent' */
 		InterfaceSentEvent* event = interfacesent_new(interface);
 		/* event destination is our node */
-		worker_scheduleEvent((Event*)event, sendTime, 0);
+		worker_scheduleEvent((Event*)event, delay, 0);
 	}
 }
 
@@ -630,20 +731,7 @@ void networkinterface_wantsSend(NetworkInterface* interface, Socket* socket) {
 void networkinterface_sent(NetworkInterface* interface) {
 	MAGIC_ASSERT(interface);
 
-	/* we just finished sending some packets */
+	/* our wake-up fired, the uplink has room for more packets */
 	interface->flags &= ~NIF_SENDING;
-
-	/* decide how much delay we get to absorb based on the passed time */
-	SimulationTime now = worker_getPrivate()->clock_now;
-	SimulationTime absorbInterval = now - interface->lastTimeSent;
-
-	if(absorbInterval > 0) {
-		gdouble newConsumed = interface->sendNanosecondsConsumed - absorbInterval;
-		interface->sendNanosecondsConsumed = MAX(0, newConsumed);
-	}
-
-	interface->lastTimeSent = now;
-
-	/* now try to send the next ones */
 	_networkinterface_scheduleNextSend(interface);
 }
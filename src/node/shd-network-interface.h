@@ -35,6 +35,7 @@ in_addr_t networkinterface_getIPAddress(NetworkInterface* interface);
 gchar* networkinterface_getIPName(NetworkInterface* interface);
 guint32 networkinterface_getSpeedUpKiBps(NetworkInterface* interface);
 guint32 networkinterface_getSpeedDownKiBps(NetworkInterface* interface);
+gsize networkinterface_getMemoryUsage(NetworkInterface* interface);
 
 gboolean networkinterface_isAssociated(NetworkInterface* interface, gint key);
 void networkinterface_associate(NetworkInterface* interface, Socket* transport);
@@ -42,6 +43,8 @@ void networkinterface_disassociate(NetworkInterface* interface, Socket* transpor
 
 void networkinterface_packetArrived(NetworkInterface* interface, Packet* packet);
 void networkinterface_received(NetworkInterface* interface);
+gboolean networkinterface_sendLocal(NetworkInterface* interface, Packet* packet);
+void networkinterface_delivered(NetworkInterface* interface);
 void networkinterface_packetDropped(NetworkInterface* interface, Packet* packet);
 void networkinterface_wantsSend(NetworkInterface* interface, Socket* transport);
 void networkinterface_sent(NetworkInterface* interface);
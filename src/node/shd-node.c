@@ -25,6 +25,9 @@ struct _Node {
 	/* holds this node's events */
 	EventQueue* events;
 
+	/* holds this node's timers, only the next one to expire is in events */
+	TimerWheel* timers;
+
 	/* the network this node belongs to */
 	Network* network;
 
@@ -33,7 +36,6 @@ struct _Node {
 	 */
 	GMutex lock;
 
-	GQuark id;
 	gchar* name;
 	GHashTable* interfaces;
 	NetworkInterface* defaultInterface;
@@ -42,26 +44,25 @@ struct _Node {
 	/* the applications this node is running */
 	GList* applications;
 
-	/* a statistics tracker for in/out bytes, CPU, memory, etc. */
+	/* a statistics tracker for in/out bytes, CPU, memory, etc.
+	 * NULL if nobody will ever see the statistics. */
 	Tracker* tracker;
 
-	/* this node's loglevel */
-	GLogLevelFlags logLevel;
-
-	/* flag on whether or not packets are being captured */
-	gchar logPcap;
-	
 	/* Directory to save PCAP files to if packets are being captured */
 	gchar* pcapDir;
 
+	/* settings for interfaces we only create when they are first used */
+	gchar* qdisc;
+	guint64 interfaceReceiveLength;
+
 	/* all file, socket, and epoll descriptors we know about and track */
 	GHashTable* descriptors;
-	gint descriptorHandleCounter;
 	guint64 receiveBufferSize;
 	guint64 sendBufferSize;
 
-	/* random port counter, in host order */
-	in_port_t randomPortCounter;
+	/* how our TCP sockets react to congestion */
+	TCPCongestionType tcpCongestion;
+	gboolean tcpSelectiveAcks;
 
 	/* track the order in which the application sent us application data */
 	gdouble packetPriorityCounter;
@@ -69,6 +70,20 @@ struct _Node {
 	/* random stream */
 	Random* random;
 
+	/* the small members go last, so they pack together without padding */
+	GQuark id;
+
+	/* this node's loglevel */
+	GLogLevelFlags logLevel;
+
+	gint descriptorHandleCounter;
+
+	/* random port counter, in host order */
+	in_port_t randomPortCounter;
+
+	/* flag on whether or not packets are being captured */
+	gchar logPcap;
+
 	MAGIC_DECLARE;
 };
 
@@ -77,6 +92,7 @@ Node* node_new(GQuark id, Network* network, guint32 ip,
 		guint cpuFrequency, gint cpuThreshold, gint cpuPrecision, guint nodeSeed,
 		SimulationTime heartbeatInterval, GLogLevelFlags heartbeatLogLevel,
 		GLogLevelFlags logLevel, gboolean logPcap, gchar* pcapDir, gchar* qdisc,
+		TCPCongestionType tcpCongestion, gboolean tcpSelectiveAcks,
 		guint64 receiveBufferSize, guint64 sendBufferSize, guint64 interfaceReceiveLength) {
 	Node* node = g_new0(Node, 1);
 	MAGIC_INIT(node);
@@ -87,6 +103,7 @@ Node* node_new(GQuark id, Network* network, guint32 ip,
 
 	/* thread-level event communication with other nodes */
 	node->events = eventqueue_new();
+	node->timers = timerwheel_new();
 
 	/* where we are in the network topology */
 	node->network = network;
@@ -96,16 +113,17 @@ Node* node_new(GQuark id, Network* network, guint32 ip,
 			NULL, (GDestroyNotify) networkinterface_free);
 	NetworkInterface* ethernet = networkinterface_new(network, id, hostname->str, bwDownKiBps, bwUpKiBps, logPcap, pcapDir, qdisc, interfaceReceiveLength);
 	g_hash_table_replace(node->interfaces, GUINT_TO_POINTER((guint)id), ethernet);
-	GString *loopbackName = g_string_new("");
-	g_string_append_printf(loopbackName, "%s-loopback", hostname->str);
-	NetworkInterface* loopback = networkinterface_new(NULL, (GQuark)htonl(INADDR_LOOPBACK), loopbackName->str, G_MAXUINT32, G_MAXUINT32, logPcap, pcapDir, qdisc, interfaceReceiveLength);
-	g_hash_table_replace(node->interfaces, GUINT_TO_POINTER((guint)htonl(INADDR_LOOPBACK)), loopback);
+	/* most nodes never use loopback, it is created on first lookup */
+	node->qdisc = qdisc;
+	node->interfaceReceiveLength = interfaceReceiveLength;
 	node->defaultInterface = ethernet;
 
 	/* virtual descriptor management */
 	node->descriptors = g_hash_table_new_full(g_int_hash, g_int_equal, NULL, descriptor_unref);
 	node->descriptorHandleCounter = MIN_DESCRIPTOR;
 	node->receiveBufferSize = receiveBufferSize;
+	node->tcpCongestion = tcpCongestion;
+	node->tcpSelectiveAcks = tcpSelectiveAcks;
 	node->sendBufferSize = sendBufferSize;
 
 	/* host order so increments make sense */
@@ -116,7 +134,18 @@ Node* node_new(GQuark id, Network* network, guint32 ip,
 
 	node->cpu = cpu_new(cpuFrequency, cpuThreshold, cpuPrecision);
 	node->random = random_new(nodeSeed);
-	node->tracker = tracker_new(heartbeatInterval, heartbeatLogLevel);
+	/* statistics are only ever reported in heartbeats. our own settings
+	 * take precedence over the global config. */
+	Configuration* config = worker_getConfig();
+	if(!heartbeatInterval) {
+		heartbeatInterval = configuration_getHearbeatInterval(config);
+	}
+	if(!heartbeatLogLevel) {
+		heartbeatLogLevel = configuration_getHeartbeatLogLevel(config);
+	}
+	if(heartbeatInterval) {
+		node->tracker = tracker_new(heartbeatInterval, heartbeatLogLevel);
+	}
 	node->logLevel = logLevel;
 	node->logPcap = logPcap;
 	node->pcapDir = pcapDir;
@@ -134,12 +163,15 @@ void node_free(Node* node, gpointer userData) {
 
 	g_hash_table_destroy(node->interfaces);
 	g_hash_table_destroy(node->descriptors);
+	timerwheel_free(node->timers);
 
 	g_free(node->name);
 
 	eventqueue_free(node->events);
 	cpu_free(node->cpu);
-	tracker_free(node->tracker);
+	if(node->tracker) {
+		tracker_free(node->tracker);
+	}
 
 	g_mutex_clear(&(node->lock));
 
@@ -162,6 +194,11 @@ EventQueue* node_getEvents(Node* node) {
 	return node->events;
 }
 
+TimerWheel* node_getTimerWheel(Node* node) {
+	MAGIC_ASSERT(node);
+	return node->timers;
+}
+
 void node_addApplication(Node* node, GQuark pluginID, gchar* pluginPath,
 		SimulationTime startTime, SimulationTime stopTime, gchar* arguments) {
 	MAGIC_ASSERT(node);
@@ -188,6 +225,11 @@ void node_stopApplication(Node* node, Application* application) {
 	application_stop(application);
 }
 
+void node_hibernate(Node* node) {
+	MAGIC_ASSERT(node);
+	g_list_foreach(node->applications, (GFunc) application_hibernate, NULL);
+}
+
 void node_freeAllApplications(Node* node, gpointer userData) {
 	MAGIC_ASSERT(node);
 
@@ -235,6 +277,11 @@ Network* node_getNetwork(Node* node) {
 	return node->network;
 }
 
+GQuark node_getID(Node* node) {
+	MAGIC_ASSERT(node);
+	return node->id;
+}
+
 gchar* node_getName(Node* node) {
 	MAGIC_ASSERT(node);
 	return node->name;
@@ -260,9 +307,43 @@ Descriptor* node_lookupDescriptor(Node* node, gint handle) {
 	return g_hash_table_lookup(node->descriptors, (gconstpointer) &handle);
 }
 
+static NetworkInterface* _node_createLoopback(Node* node) {
+	in_addr_t loIP = htonl(INADDR_LOOPBACK);
+
+	gchar* loopbackName = g_strdup_printf("%s-loopback", node->name);
+	NetworkInterface* loopback = networkinterface_new(NULL, (GQuark)loIP, loopbackName,
+			G_MAXUINT32, G_MAXUINT32, node->logPcap, node->pcapDir, node->qdisc,
+			node->interfaceReceiveLength);
+	g_free(loopbackName);
+
+	g_hash_table_replace(node->interfaces, GUINT_TO_POINTER((guint)loIP), loopback);
+
+	/* sockets bound to all interfaces before now must include this one. the
+	 * children of server sockets have no key and were never associated. */
+	GHashTableIter iter;
+	gpointer key, value;
+	g_hash_table_iter_init(&iter, node->descriptors);
+	while(g_hash_table_iter_next(&iter, &key, &value)) {
+		Descriptor* descriptor = value;
+		enum DescriptorType type = descriptor_getType(descriptor);
+		if((type == DT_TCPSOCKET || type == DT_UDPSOCKET) &&
+				socket_isBound((Socket*)descriptor) &&
+				socket_getBinding((Socket*)descriptor) == htonl(INADDR_ANY) &&
+				socket_getAssociationKey((Socket*)descriptor) != 0) {
+			networkinterface_associate(loopback, (Socket*)descriptor);
+		}
+	}
+
+	return loopback;
+}
+
 NetworkInterface* node_lookupInterface(Node* node, in_addr_t handle) {
 	MAGIC_ASSERT(node);
-	return g_hash_table_lookup(node->interfaces, GUINT_TO_POINTER(handle));
+	NetworkInterface* interface = g_hash_table_lookup(node->interfaces, GUINT_TO_POINTER(handle));
+	if(!interface && handle == htonl(INADDR_LOOPBACK)) {
+		interface = _node_createLoopback(node);
+	}
+	return interface;
 }
 
 static void _node_associateInterface(Node* node, Socket* socket,
@@ -350,7 +431,8 @@ gint node_createDescriptor(Node* node, enum DescriptorType type) {
 
 		case DT_TCPSOCKET: {
 			descriptor = (Descriptor*) tcp_new((node->descriptorHandleCounter)++,
-					node->receiveBufferSize, node->sendBufferSize);
+					node->receiveBufferSize, node->sendBufferSize,
+					node->tcpCongestion, node->tcpSelectiveAcks);
 			break;
 		}
 
@@ -770,7 +852,7 @@ gint node_sendUserData(Node* node, gint handle, gconstpointer buffer, gsize nByt
 		 * immediately schedule an event to tell the socket it can write. it will
 		 * pop out when the CPU delay is absorbed. otherwise we could miss writes.
 		 */
-		descriptor_adjustStatus(descriptor, DS_WRITABLE, TRUE);
+		descriptor_signalStatus(descriptor, DS_WRITABLE);
 
 		return EAGAIN;
 	}
@@ -854,7 +936,7 @@ gint node_receiveUserData(Node* node, gint handle, gpointer buffer, gsize nBytes
 		 * immediately schedule an event to tell the socket it can read. it will
 		 * pop out when the CPU delay is absorbed. otherwise we could miss reads.
 		 */
-		descriptor_adjustStatus(descriptor, DS_READABLE, TRUE);
+		descriptor_signalStatus(descriptor, DS_READABLE);
 
 		return EAGAIN;
 	}
@@ -892,6 +974,39 @@ gint node_closeUser(Node* node, gint handle) {
 	return 0;
 }
 
+void node_logMemoryUsage(Node* node) {
+	MAGIC_ASSERT(node);
+
+	gsize structBytes = sizeof(Node) + (node->name ? strlen(node->name) + 1 : 0);
+	gsize eventBytes = eventqueue_getMemoryUsage(node->events);
+	gsize timerBytes = timerwheel_getMemoryUsage(node->timers);
+	gsize cpuBytes = cpu_getMemoryUsage(node->cpu);
+	gsize trackerBytes = tracker_getMemoryUsage(node->tracker);
+
+	guint numInterfaces = g_hash_table_size(node->interfaces);
+	gsize interfaceBytes = numInterfaces * UTILITY_HASH_ENTRY_SIZE;
+	GHashTableIter iter;
+	gpointer key, value;
+	g_hash_table_iter_init(&iter, node->interfaces);
+	while(g_hash_table_iter_next(&iter, &key, &value)) {
+		interfaceBytes += networkinterface_getMemoryUsage((NetworkInterface*) value);
+	}
+
+	/* descriptors are counted by the plug-in memory tracker, only the table is ours */
+	guint numDescriptors = g_hash_table_size(node->descriptors);
+	gsize descriptorBytes = numDescriptors * UTILITY_HASH_ENTRY_SIZE;
+
+	gsize total = structBytes + eventBytes + timerBytes + cpuBytes + trackerBytes +
+			interfaceBytes + descriptorBytes;
+
+	info("[shadow-memory] total %"G_GSIZE_FORMAT" B: node %"G_GSIZE_FORMAT" B, "
+			"events %"G_GSIZE_FORMAT" B, timers %"G_GSIZE_FORMAT" B, "
+			"interfaces %"G_GSIZE_FORMAT" B (%u), descriptors %"G_GSIZE_FORMAT" B (%u), "
+			"cpu %"G_GSIZE_FORMAT" B, tracker %"G_GSIZE_FORMAT" B",
+			total, structBytes, eventBytes, timerBytes, interfaceBytes, numInterfaces,
+			descriptorBytes, numDescriptors, cpuBytes, trackerBytes);
+}
+
 Tracker* node_getTracker(Node* node) {
 	MAGIC_ASSERT(node);
 	return node->tracker;
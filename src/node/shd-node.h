@@ -32,6 +32,7 @@ Node* node_new(GQuark id, Network* network, guint32 ip,
 		GString* hostname, guint64 bwDownKiBps, guint64 bwUpKiBps, guint cpuFrequency, gint cpuThreshold, gint cpuPrecision,
 		guint nodeSeed, SimulationTime heartbeatInterval, GLogLevelFlags heartbeatLogLevel,
 		GLogLevelFlags logLevel, gboolean logPcap, gchar* pcapDir, gchar* qdisc,
+		TCPCongestionType tcpCongestion, gboolean tcpSelectiveAcks,
 		guint64 receiveBufferSize, guint64 sendBufferSize, guint64 interfaceReceiveLength);
 void node_free(Node* node, gpointer userData);
 
@@ -39,17 +40,20 @@ void node_lock(Node* node);
 void node_unlock(Node* node);
 
 EventQueue* node_getEvents(Node* node);
+TimerWheel* node_getTimerWheel(Node* node);
 
 void node_addApplication(Node* node, GQuark pluginID, gchar* pluginPath,
 		SimulationTime startTime, SimulationTime stopTime, gchar* arguments);
 void node_startApplication(Node* node, Application* application);
 void node_stopApplication(Node* node, Application* application);
 void node_freeAllApplications(Node* node, gpointer userData);
+void node_hibernate(Node* node);
 
 gint node_compare(gconstpointer a, gconstpointer b, gpointer user_data);
 gboolean node_isEqual(Node* a, Node* b);
 CPU* node_getCPU(Node* node);
 Network* node_getNetwork(Node* node);
+GQuark node_getID(Node* node);
 gchar* node_getName(Node* node);
 in_addr_t node_getDefaultIP(Node* node);
 gchar* node_getDefaultIPName(Node* node);
@@ -77,6 +81,7 @@ gint node_getPeerName(Node* node, gint handle, in_addr_t* ip, in_port_t* port);
 gint node_getSocketName(Node* node, gint handle, in_addr_t* ip, in_port_t* port);
 
 Tracker* node_getTracker(Node* node);
+void node_logMemoryUsage(Node* node);
 GLogLevelFlags node_getLogLevel(Node* node);
 gchar node_isLoggingPcap(Node *node);
 
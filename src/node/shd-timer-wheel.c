@@ -0,0 +1,426 @@
+/**
+ * The Shadow Simulator
+ *
+ * Copyright (c) 2010-2012 Rob Jansen <jansen@cs.umn.edu>
+ *
+ * This file is part of Shadow.
+ *
+ * Shadow is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shadow is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shadow.h"
+
+/* each level has 64 slots. level 0 slots are CONFIG_TIMERWHEEL_GRANULARITY
+ * wide, and each following level is 64 times coarser than the one before. */
+#define TIMERWHEEL_LEVELS 4
+#define TIMERWHEEL_SLOT_BITS 6
+#define TIMERWHEEL_SLOTS (1 << TIMERWHEEL_SLOT_BITS)
+#define TIMERWHEEL_SLOT_MASK (TIMERWHEEL_SLOTS - 1)
+#define TIMERWHEEL_TOP_LEVEL (TIMERWHEEL_LEVELS - 1)
+
+struct _Timer {
+	/* the exact time this timer fires */
+	SimulationTime expireTime;
+	/* breaks ties between timers expiring at the same time, FIFO */
+	guint64 sequence;
+
+	CallbackFunc callback;
+	gpointer data;
+	gpointer callbackArgument;
+	GDestroyNotify dataFree;
+
+	/* our link in the bucket holding us, so removal is O(1) */
+	GList link;
+	GQueue* bucket;
+	/* the level and slot of our bucket, level is -1 if not on the wheel */
+	gint level;
+	gint slot;
+	/* true while our callback is running */
+	gboolean isExpiring;
+
+	MAGIC_DECLARE;
+};
+
+struct _TimerWheel {
+	GQueue buckets[TIMERWHEEL_LEVELS][TIMERWHEEL_SLOTS];
+	/* one bit per slot, set if the slot holds any timers */
+	guint64 occupied[TIMERWHEEL_LEVELS];
+	/* timers beyond the current rotation of our highest level. they are all
+	 * later than every timer on the wheel, and move onto it when it wraps. */
+	GQueue overflow;
+
+	/* the time all bucket positions are relative to */
+	SimulationTime now;
+	guint numTimers;
+	guint64 sequenceCounter;
+
+	/* the expiration event we keep in the event queue. events from older
+	 * generations were superseded by an earlier one and are ignored. */
+	SimulationTime armedTime;
+	guint64 armedGeneration;
+
+	MAGIC_DECLARE;
+};
+
+static guint64 _timerwheel_toUnit(SimulationTime time, gint level) {
+	return (time / CONFIG_TIMERWHEEL_GRANULARITY) >> (TIMERWHEEL_SLOT_BITS * level);
+}
+
+static gboolean _timerwheel_fits(TimerWheel* wheel, guint64 unit, gint level) {
+	guint64 nowUnit = _timerwheel_toUnit(wheel->now, level);
+	if(level < TIMERWHEEL_TOP_LEVEL) {
+		return unit < nowUnit + TIMERWHEEL_SLOTS;
+	}
+	/* the top level only takes the rest of its current rotation */
+	return unit <= (nowUnit | TIMERWHEEL_SLOT_MASK);
+}
+
+static void _timerwheel_link(TimerWheel* wheel, Timer* timer) {
+	/* use the finest level where the timer is less than a full rotation away */
+	for(gint level = 0; level < TIMERWHEEL_LEVELS; level++) {
+		guint64 unit = _timerwheel_toUnit(timer->expireTime, level);
+		if(_timerwheel_fits(wheel, unit, level)) {
+			gint slot = (gint)(unit & TIMERWHEEL_SLOT_MASK);
+			timer->level = level;
+			timer->slot = slot;
+			timer->bucket = &(wheel->buckets[level][slot]);
+			wheel->occupied[level] |= (((guint64)1) << slot);
+			g_queue_push_tail_link(timer->bucket, &(timer->link));
+			return;
+		}
+	}
+
+	timer->level = -1;
+	timer->slot = -1;
+	timer->bucket = &(wheel->overflow);
+	g_queue_push_tail_link(timer->bucket, &(timer->link));
+}
+
+static void _timerwheel_unlink(TimerWheel* wheel, Timer* timer) {
+	g_assert(timer->bucket);
+
+	g_queue_unlink(timer->bucket, &(timer->link));
+	if(timer->level >= 0 && g_queue_is_empty(timer->bucket)) {
+		wheel->occupied[timer->level] &= ~(((guint64)1) << timer->slot);
+	}
+	timer->bucket = NULL;
+}
+
+static gboolean _timer_isBefore(Timer* a, Timer* b) {
+	return (a->expireTime < b->expireTime) ||
+			(a->expireTime == b->expireTime && a->sequence < b->sequence);
+}
+
+static gint _timer_compare(gconstpointer a, gconstpointer b, gpointer userData) {
+	Timer* ta = (Timer*) a;
+	Timer* tb = (Timer*) b;
+	return _timer_isBefore(ta, tb) ? -1 : _timer_isBefore(tb, ta) ? +1 : 0;
+}
+
+static Timer* _timerwheel_findFirstInBucket(GQueue* bucket, Timer* best) {
+	for(GList* item = g_queue_peek_head_link(bucket); item != NULL; item = item->next) {
+		Timer* timer = item->data;
+		if(best == NULL || _timer_isBefore(timer, best)) {
+			best = timer;
+		}
+	}
+	return best;
+}
+
+static Timer* _timerwheel_findFirst(TimerWheel* wheel) {
+	Timer* first = NULL;
+	gboolean isWheelEmpty = TRUE;
+
+	for(gint level = 0; level < TIMERWHEEL_LEVELS; level++) {
+		guint64 occupied = wheel->occupied[level];
+		if(!occupied) {
+			continue;
+		}
+		isWheelEmpty = FALSE;
+
+		/* slots are ordered by time starting at the slot holding 'now', so the
+		 * first occupied slot after rotating holds the earliest timers of this
+		 * level and we never have to look at the others */
+		gint start = (gint)(_timerwheel_toUnit(wheel->now, level) & TIMERWHEEL_SLOT_MASK);
+		guint64 rotated = start == 0 ? occupied :
+				(occupied >> start) | (occupied << (TIMERWHEEL_SLOTS - start));
+		gint slot = (start + __builtin_ctzll(rotated)) & TIMERWHEEL_SLOT_MASK;
+
+		first = _timerwheel_findFirstInBucket(&(wheel->buckets[level][slot]), first);
+	}
+
+	/* overflow timers are later than any timer on the wheel */
+	return isWheelEmpty ? _timerwheel_findFirstInBucket(&(wheel->overflow), first) : first;
+}
+
+static void _timerwheel_schedule(TimerWheel* wheel, SimulationTime expireTime) {
+	/* an earlier or equal expiration event is already waiting for us */
+	if(wheel->armedTime != SIMTIME_INVALID && wheel->armedTime <= expireTime) {
+		return;
+	}
+
+	Worker* worker = worker_getPrivate();
+	SimulationTime now = worker->clock_now;
+	SimulationTime delay = expireTime > now ? expireTime - now : 0;
+
+	/* any expiration event we had scheduled before is now stale */
+	wheel->armedGeneration++;
+	wheel->armedTime = now + delay;
+
+	TimerExpiredEvent* event = timerexpired_new(wheel->armedGeneration);
+	worker_scheduleEvent((Event*)event, delay, 0);
+}
+
+static void _timerwheel_arm(TimerWheel* wheel) {
+	Timer* first = _timerwheel_findFirst(wheel);
+	if(first) {
+		_timerwheel_schedule(wheel, first->expireTime);
+	}
+}
+
+static void _timerwheel_setDue(Timer* timer, GQueue* due) {
+	timer->level = -1;
+	timer->bucket = due;
+	g_queue_push_tail_link(due, &(timer->link));
+}
+
+static void _timerwheel_collectDue(TimerWheel* wheel, gint level, SimulationTime now, GQueue* due) {
+	/* only the slots from our old time up to the one holding 'now' can hold
+	 * due timers, and the bitmap tells us which of them to look at */
+	guint64 nowUnit = _timerwheel_toUnit(wheel->now, level);
+	guint64 lastUnit = MIN(_timerwheel_toUnit(now, level), nowUnit + TIMERWHEEL_SLOT_MASK);
+
+	for(guint64 unit = nowUnit; unit <= lastUnit && wheel->occupied[level]; unit++) {
+		gint slot = (gint)(unit & TIMERWHEEL_SLOT_MASK);
+		if(!(wheel->occupied[level] & (((guint64)1) << slot))) {
+			continue;
+		}
+
+		GList* item = g_queue_peek_head_link(&(wheel->buckets[level][slot]));
+		while(item != NULL) {
+			GList* next = item->next;
+			Timer* timer = item->data;
+			if(timer->expireTime <= now) {
+				_timerwheel_unlink(wheel, timer);
+				_timerwheel_setDue(timer, due);
+			}
+			item = next;
+		}
+	}
+}
+
+static void _timerwheel_cascade(TimerWheel* wheel, GQueue* overflow) {
+	/* timers in the current slot of the coarser levels are now close enough
+	 * to move down to a finer level */
+	for(gint level = 1; level < TIMERWHEEL_LEVELS; level++) {
+		gint slot = (gint)(_timerwheel_toUnit(wheel->now, level) & TIMERWHEEL_SLOT_MASK);
+		GQueue* bucket = &(wheel->buckets[level][slot]);
+
+		GQueue moving = G_QUEUE_INIT;
+		while(!g_queue_is_empty(bucket)) {
+			GList* link = g_queue_pop_head_link(bucket);
+			g_queue_push_tail_link(&moving, link);
+		}
+		wheel->occupied[level] &= ~(((guint64)1) << slot);
+
+		while(!g_queue_is_empty(&moving)) {
+			Timer* timer = g_queue_pop_head_link(&moving)->data;
+			_timerwheel_link(wheel, timer);
+		}
+	}
+
+	/* overflow timers from before the top level wrapped, which may fit now */
+	while(!g_queue_is_empty(overflow)) {
+		Timer* timer = g_queue_pop_head_link(overflow)->data;
+		_timerwheel_link(wheel, timer);
+	}
+}
+
+static void _timer_free(Timer* timer) {
+	MAGIC_ASSERT(timer);
+
+	if(timer->dataFree) {
+		timer->dataFree(timer->data);
+	}
+
+	MAGIC_CLEAR(timer);
+	g_free(timer);
+}
+
+TimerWheel* timerwheel_new() {
+	TimerWheel* wheel = g_new0(TimerWheel, 1);
+	MAGIC_INIT(wheel);
+
+	for(gint level = 0; level < TIMERWHEEL_LEVELS; level++) {
+		for(gint slot = 0; slot < TIMERWHEEL_SLOTS; slot++) {
+			g_queue_init(&(wheel->buckets[level][slot]));
+		}
+	}
+	g_queue_init(&(wheel->overflow));
+
+	wheel->armedTime = SIMTIME_INVALID;
+
+	return wheel;
+}
+
+void timerwheel_free(TimerWheel* wheel) {
+	MAGIC_ASSERT(wheel);
+
+	/* timers that never fired still own their data */
+	for(gint level = 0; level < TIMERWHEEL_LEVELS; level++) {
+		for(gint slot = 0; slot < TIMERWHEEL_SLOTS; slot++) {
+			GQueue* bucket = &(wheel->buckets[level][slot]);
+			while(!g_queue_is_empty(bucket)) {
+				_timer_free(g_queue_pop_head_link(bucket)->data);
+			}
+		}
+	}
+	while(!g_queue_is_empty(&(wheel->overflow))) {
+		_timer_free(g_queue_pop_head_link(&(wheel->overflow))->data);
+	}
+
+	MAGIC_CLEAR(wheel);
+	g_free(wheel);
+}
+
+Timer* timerwheel_add(TimerWheel* wheel, SimulationTime expireTime, CallbackFunc callback,
+		gpointer data, gpointer callbackArgument, GDestroyNotify dataFree) {
+	MAGIC_ASSERT(wheel);
+	/* better have a non-null callback if we are going to execute it */
+	g_assert(callback);
+
+	Timer* timer = g_new0(Timer, 1);
+	MAGIC_INIT(timer);
+
+	timer->expireTime = expireTime;
+	timer->sequence = wheel->sequenceCounter++;
+	timer->callback = callback;
+	timer->data = data;
+	timer->callbackArgument = callbackArgument;
+	timer->dataFree = dataFree;
+	timer->link.data = timer;
+
+	_timerwheel_link(wheel, timer);
+	wheel->numTimers++;
+
+	_timerwheel_schedule(wheel, timer->expireTime);
+
+	return timer;
+}
+
+void timerwheel_cancel(TimerWheel* wheel, Timer* timer) {
+	MAGIC_ASSERT(wheel);
+	MAGIC_ASSERT(timer);
+
+	/* if this was the earliest timer, the armed event will find nothing to do
+	 * and simply re-arm for the next one */
+	if(timer->bucket) {
+		_timerwheel_unlink(wheel, timer);
+		wheel->numTimers--;
+	}
+
+	/* timers cancelled from their own callback are freed once it returns */
+	if(!timer->isExpiring) {
+		_timer_free(timer);
+	}
+}
+
+void timerwheel_reschedule(TimerWheel* wheel, Timer* timer, SimulationTime expireTime) {
+	MAGIC_ASSERT(wheel);
+	MAGIC_ASSERT(timer);
+
+	if(timer->bucket) {
+		_timerwheel_unlink(wheel, timer);
+	} else {
+		/* rescheduled from its own callback, so its pending again */
+		g_assert(timer->isExpiring);
+		wheel->numTimers++;
+	}
+
+	timer->expireTime = expireTime;
+	timer->sequence = wheel->sequenceCounter++;
+	_timerwheel_link(wheel, timer);
+
+	/* if this was the earliest timer and moved later, the armed event will
+	 * find nothing to do and simply re-arm for the next one */
+	_timerwheel_schedule(wheel, timer->expireTime);
+}
+
+guint timerwheel_getNumTimers(TimerWheel* wheel) {
+	MAGIC_ASSERT(wheel);
+	return wheel->numTimers;
+}
+
+gsize timerwheel_getMemoryUsage(TimerWheel* wheel) {
+	MAGIC_ASSERT(wheel);
+	return sizeof(TimerWheel) + wheel->numTimers * sizeof(Timer);
+}
+
+void timerwheel_expire(TimerWheel* wheel, guint64 generation) {
+	MAGIC_ASSERT(wheel);
+
+	/* a stale event, an earlier one took over its job */
+	if(generation != wheel->armedGeneration) {
+		return;
+	}
+	wheel->armedTime = SIMTIME_INVALID;
+
+	SimulationTime now = worker_getPrivate()->clock_now;
+	g_assert(now >= wheel->now);
+
+	/* pull out everything that is due while bucket positions are still relative
+	 * to our old time. we may be late if our event was delayed by the CPU. */
+	GQueue due = G_QUEUE_INIT;
+	for(gint level = 0; level < TIMERWHEEL_LEVELS; level++) {
+		_timerwheel_collectDue(wheel, level, now, &due);
+	}
+
+	/* overflow timers only become due or fit on the wheel once it wraps */
+	GQueue overflow = G_QUEUE_INIT;
+	guint64 rotation = _timerwheel_toUnit(wheel->now, TIMERWHEEL_TOP_LEVEL) >> TIMERWHEEL_SLOT_BITS;
+	if((_timerwheel_toUnit(now, TIMERWHEEL_TOP_LEVEL) >> TIMERWHEEL_SLOT_BITS) != rotation) {
+		while(!g_queue_is_empty(&(wheel->overflow))) {
+			Timer* timer = g_queue_pop_head_link(&(wheel->overflow))->data;
+			if(timer->expireTime <= now) {
+				_timerwheel_setDue(timer, &due);
+			} else {
+				g_queue_push_tail_link(&overflow, &(timer->link));
+			}
+		}
+	}
+
+	/* fire in time order, and in the order they were set for equal times */
+	g_queue_sort(&due, _timer_compare, NULL);
+
+	wheel->now = now;
+	_timerwheel_cascade(wheel, &overflow);
+
+	/* callbacks may add, cancel, or reschedule any timer, including due ones */
+	while(!g_queue_is_empty(&due)) {
+		Timer* timer = g_queue_pop_head_link(&due)->data;
+		timer->bucket = NULL;
+		wheel->numTimers--;
+
+		timer->isExpiring = TRUE;
+		timer->callback(timer->data, timer->callbackArgument);
+		timer->isExpiring = FALSE;
+
+		/* a timer rescheduled from its own callback is back on the wheel */
+		if(!timer->bucket) {
+			_timer_free(timer);
+		}
+	}
+
+	_timerwheel_arm(wheel);
+}
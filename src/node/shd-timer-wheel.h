@@ -0,0 +1,50 @@
+/**
+ * The Shadow Simulator
+ *
+ * Copyright (c) 2010-2012 Rob Jansen <jansen@cs.umn.edu>
+ *
+ * This file is part of Shadow.
+ *
+ * Shadow is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shadow is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHD_TIMER_WHEEL_H_
+#define SHD_TIMER_WHEEL_H_
+
+#include "shadow.h"
+
+/**
+ * A hashed hierarchical timer wheel holding all of a node's pending timers.
+ * Timers are bucketed by expiration time so adding and cancelling them is
+ * O(1), and only a single event for the earliest expiring timer is kept in the
+ * node's event queue at any time. Timers still fire at their exact expiration
+ * time; the buckets only determine how cheaply we can find the next one.
+ */
+
+typedef struct _TimerWheel TimerWheel;
+typedef struct _Timer Timer;
+
+TimerWheel* timerwheel_new();
+void timerwheel_free(TimerWheel* wheel);
+
+Timer* timerwheel_add(TimerWheel* wheel, SimulationTime expireTime, CallbackFunc callback,
+		gpointer data, gpointer callbackArgument, GDestroyNotify dataFree);
+void timerwheel_cancel(TimerWheel* wheel, Timer* timer);
+void timerwheel_reschedule(TimerWheel* wheel, Timer* timer, SimulationTime expireTime);
+guint timerwheel_getNumTimers(TimerWheel* wheel);
+gsize timerwheel_getMemoryUsage(TimerWheel* wheel);
+
+void timerwheel_expire(TimerWheel* wheel, guint64 generation);
+
+#endif /* SHD_TIMER_WHEEL_H_ */
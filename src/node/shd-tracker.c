@@ -39,6 +39,7 @@ struct _Tracker {
 	gsize outputBytesTotal;
 	gsize outputBytesLastInterval;
 
+	/* only exists once the memory tracker reports an allocation */
 	GHashTable* allocatedLocations;
 	gsize allocatedBytesTotal;
 	gsize allocatedBytesLastInterval;
@@ -55,7 +56,6 @@ Tracker* tracker_new(SimulationTime interval, GLogLevelFlags loglevel) {
 
 	tracker->interval = interval;
 	tracker->loglevel = loglevel;
-	tracker->allocatedLocations = g_hash_table_new(g_direct_hash, g_direct_equal);
 
 	return tracker;
 }
@@ -63,19 +63,29 @@ Tracker* tracker_new(SimulationTime interval, GLogLevelFlags loglevel) {
 void tracker_free(Tracker* tracker) {
 	MAGIC_ASSERT(tracker);
 
-	g_hash_table_destroy(tracker->allocatedLocations);
+	if(tracker->allocatedLocations) {
+		g_hash_table_destroy(tracker->allocatedLocations);
+	}
 
 	MAGIC_CLEAR(tracker);
 	g_free(tracker);
 }
 
 void tracker_addProcessingTime(Tracker* tracker, SimulationTime processingTime) {
+	/* nodes without heartbeats have no tracker */
+	if(!tracker) {
+		return;
+	}
 	MAGIC_ASSERT(tracker);
 	tracker->processingTimeTotal += processingTime;
 	tracker->processingTimeLastInterval += processingTime;
 }
 
 void tracker_addVirtualProcessingDelay(Tracker* tracker, SimulationTime delay) {
+	/* nodes without heartbeats have no tracker */
+	if(!tracker) {
+		return;
+	}
 	MAGIC_ASSERT(tracker);
 	(tracker->numDelayedTotal)++;
 	tracker->delayTimeTotal += delay;
@@ -84,57 +94,103 @@ void tracker_addVirtualProcessingDelay(Tracker* tracker, SimulationTime delay) {
 }
 
 void tracker_addInputBytes(Tracker* tracker, gsize inputBytes) {
+	/* nodes without heartbeats have no tracker */
+	if(!tracker) {
+		return;
+	}
 	MAGIC_ASSERT(tracker);
 	tracker->inputBytesTotal += inputBytes;
 	tracker->inputBytesLastInterval += inputBytes;
 }
 
 void tracker_addOutputBytes(Tracker* tracker, gsize outputBytes) {
+	/* nodes without heartbeats have no tracker */
+	if(!tracker) {
+		return;
+	}
 	MAGIC_ASSERT(tracker);
 	tracker->outputBytesTotal += outputBytes;
 	tracker->outputBytesLastInterval += outputBytes;
 }
 
 void tracker_addAllocatedBytes(Tracker* tracker, gpointer location, gsize allocatedBytes) {
+	/* nodes without heartbeats have no tracker */
+	if(!tracker) {
+		return;
+	}
 	MAGIC_ASSERT(tracker);
 	tracker->allocatedBytesTotal += allocatedBytes;
 	tracker->allocatedBytesLastInterval += allocatedBytes;
+	if(!tracker->allocatedLocations) {
+		tracker->allocatedLocations = g_hash_table_new(g_direct_hash, g_direct_equal);
+	}
 	g_hash_table_insert(tracker->allocatedLocations, location, GSIZE_TO_POINTER(allocatedBytes));
 }
 
 void tracker_removeAllocatedBytes(Tracker* tracker, gpointer location) {
+	/* nodes without heartbeats have no tracker */
+	if(!tracker) {
+		return;
+	}
 	MAGIC_ASSERT(tracker);
+	if(!tracker->allocatedLocations) {
+		return;
+	}
 	gpointer value = g_hash_table_lookup(tracker->allocatedLocations, location);
 	if(value) {
 		gsize allocatedBytes = GPOINTER_TO_SIZE(value);
 		tracker->allocatedBytesTotal -= allocatedBytes;
 		tracker->deallocatedBytesLastInterval += allocatedBytes;
+		g_hash_table_remove(tracker->allocatedLocations, location);
 	}
 }
 
-void tracker_heartbeat(Tracker* tracker) {
+gsize tracker_getMemoryUsage(Tracker* tracker) {
+	if(!tracker) {
+		return 0;
+	}
 	MAGIC_ASSERT(tracker);
 
-	/* prefer our level over the global config */
-	GLogLevelFlags level = tracker->loglevel;
-	if(!level) {
-		Worker* w = worker_getPrivate();
-		if(w->cached_engine) {
-			Configuration* c = engine_getConfig(w->cached_engine);
-			level = configuration_getHeartbeatLogLevel(c);
-		}
+	gsize bytes = sizeof(Tracker);
+	if(tracker->allocatedLocations) {
+		bytes += g_hash_table_size(tracker->allocatedLocations) * UTILITY_HASH_ENTRY_SIZE;
 	}
+	return bytes;
+}
 
-	/* prefer our interval over the global config */
-	SimulationTime interval = tracker->interval;
-	if(!interval) {
-		Worker* w = worker_getPrivate();
-		if(w->cached_engine) {
-			Configuration* c = engine_getConfig(w->cached_engine);
-			interval = configuration_getHearbeatInterval(c);
-		}
-	}
+SimulationTime tracker_getNextHeartbeat(Tracker* tracker) {
+	MAGIC_ASSERT(tracker);
+	return tracker->lastHeartbeat + tracker->interval;
+}
+
+void tracker_appendHeartbeatHeader(GString* rows) {
+	g_string_append(rows, "time,node,nodes,interval,cpu,mem,alloc,dealloc,rx,tx,delayed,delay\n");
+}
+
+void tracker_appendHeartbeatRow(GString* rows, SimulationTime now, const gchar* name,
+		SimulationTime interval, TrackerCounters* counters) {
+	/* raw integers in bytes and nanoseconds, so rows sum across nodes */
+	g_string_append_printf(rows, "%"G_GUINT64_FORMAT",%s,%u,%"G_GUINT64_FORMAT",%"G_GUINT64_FORMAT","
+			"%"G_GSIZE_FORMAT",%"G_GSIZE_FORMAT",%"G_GSIZE_FORMAT",%"G_GSIZE_FORMAT","
+			"%"G_GSIZE_FORMAT",%"G_GSIZE_FORMAT",%"G_GUINT64_FORMAT"\n",
+			now, name, counters->numNodes, interval, counters->processingTime,
+			counters->memoryBytes, counters->allocatedBytes, counters->deallocatedBytes,
+			counters->inputBytes, counters->outputBytes, counters->numDelayed, counters->delayTime);
+}
+
+void tracker_addCounters(TrackerCounters* totals, TrackerCounters* counters) {
+	totals->numNodes += counters->numNodes;
+	totals->processingTime += counters->processingTime;
+	totals->memoryBytes += counters->memoryBytes;
+	totals->allocatedBytes += counters->allocatedBytes;
+	totals->deallocatedBytes += counters->deallocatedBytes;
+	totals->inputBytes += counters->inputBytes;
+	totals->outputBytes += counters->outputBytes;
+	totals->numDelayed += counters->numDelayed;
+	totals->delayTime += counters->delayTime;
+}
 
+static void _tracker_logHeartbeat(Tracker* tracker, SimulationTime interval) {
 	guint seconds = (guint) (interval / SIMTIME_ONE_SECOND);
 
 	double in = (double) (tracker->inputBytesLastInterval);
@@ -151,10 +207,39 @@ void tracker_heartbeat(Tracker* tracker) {
 		avedelayms = (double) (delayms / ((double) tracker->numDelayedLastInterval));
 	}
 
-	/* log the things we are tracking */
-	logging_log(G_LOG_DOMAIN, level, __FUNCTION__,
+	/* log the things we are tracking. the function name is part of the
+	 * format that contrib/analyze.py parses. */
+	logging_log(G_LOG_DOMAIN, tracker->loglevel, "tracker_heartbeat",
 			"[shadow-heartbeat] CPU %f \%, MEM %f KiB, interval %u seconds, alloc %f KiB, dealloc %f KiB, Rx %f B, Tx %f B, avgdelay %f milliseconds",
 			cpuutil, mem, seconds, alloc, dealloc, in, out, avedelayms);
+}
+
+void tracker_heartbeat(Tracker* tracker, const gchar* name, SimulationTime now,
+		GString* rows, TrackerCounters* totals) {
+	MAGIC_ASSERT(tracker);
+
+	/* a window may end well past our due time, report what really elapsed */
+	SimulationTime interval = now - tracker->lastHeartbeat;
+
+	if(rows) {
+		TrackerCounters counters;
+		counters.numNodes = 1;
+		counters.processingTime = tracker->processingTimeLastInterval;
+		counters.memoryBytes = tracker->allocatedBytesTotal;
+		counters.allocatedBytes = tracker->allocatedBytesLastInterval;
+		counters.deallocatedBytes = tracker->deallocatedBytesLastInterval;
+		counters.inputBytes = tracker->inputBytesLastInterval;
+		counters.outputBytes = tracker->outputBytesLastInterval;
+		counters.numDelayed = tracker->numDelayedLastInterval;
+		counters.delayTime = tracker->delayTimeLastInterval;
+
+		tracker_appendHeartbeatRow(rows, now, name, interval, &counters);
+		if(totals) {
+			tracker_addCounters(totals, &counters);
+		}
+	} else {
+		_tracker_logHeartbeat(tracker, interval);
+	}
 
 	/* clear interval stats */
 	tracker->processingTimeLastInterval = 0;
@@ -165,8 +250,5 @@ void tracker_heartbeat(Tracker* tracker) {
 	tracker->allocatedBytesLastInterval = 0;
 	tracker->deallocatedBytesLastInterval = 0;
 
-	/* schedule the next heartbeat */
-	tracker->lastHeartbeat = worker_getPrivate()->clock_now;
-	HeartbeatEvent* heartbeat = heartbeat_new(tracker);
-	worker_scheduleEvent((Event*)heartbeat, interval, 0);
+	tracker->lastHeartbeat = now;
 }
@@ -23,8 +23,22 @@
 #define SHD_TRACKER_H_
 
 typedef struct _Tracker Tracker;
+typedef struct _TrackerCounters TrackerCounters;
 
-Tracker* tracker_new();
+/* statistics of one heartbeat interval, for one node or summed over many */
+struct _TrackerCounters {
+	guint numNodes;
+	SimulationTime processingTime;
+	gsize memoryBytes;
+	gsize allocatedBytes;
+	gsize deallocatedBytes;
+	gsize inputBytes;
+	gsize outputBytes;
+	gsize numDelayed;
+	SimulationTime delayTime;
+};
+
+Tracker* tracker_new(SimulationTime interval, GLogLevelFlags loglevel);
 void tracker_free(Tracker* tracker);
 
 void tracker_addProcessingTime(Tracker* tracker, SimulationTime processingTime);
@@ -33,6 +47,14 @@ void tracker_addInputBytes(Tracker* tracker, gsize inputBytes);
 void tracker_addOutputBytes(Tracker* tracker, gsize outputBytes);
 void tracker_addAllocatedBytes(Tracker* tracker, gpointer location, gsize allocatedBytes);
 void tracker_removeAllocatedBytes(Tracker* tracker, gpointer location);
-void tracker_heartbeat(Tracker* tracker);
+gsize tracker_getMemoryUsage(Tracker* tracker);
+
+SimulationTime tracker_getNextHeartbeat(Tracker* tracker);
+void tracker_heartbeat(Tracker* tracker, const gchar* name, SimulationTime now,
+		GString* rows, TrackerCounters* totals);
+void tracker_appendHeartbeatHeader(GString* rows);
+void tracker_appendHeartbeatRow(GString* rows, SimulationTime now, const gchar* name,
+		SimulationTime interval, TrackerCounters* counters);
+void tracker_addCounters(TrackerCounters* totals, TrackerCounters* counters);
 
 #endif /* SHD_TRACKER_H_ */
@@ -250,6 +250,13 @@ static void browser_downloaded_document(browser_tp b, browser_activate_result_tp
 		(gint)(doc_stats.download_time.tv_nsec / 1000000),
 		obj_count);
 
+	if(b->shadowlib->recordMetric) {
+		gchar tags[64];
+		g_snprintf(tags, sizeof(tags), "bytes=%zu;objects=%i", b->document_size, obj_count);
+		b->shadowlib->recordMetric("browser-document-complete",
+			doc_stats.download_time.tv_sec + (doc_stats.download_time.tv_nsec / 1000000000.0), tags);
+	}
+
 	/* Try to reuse initial connection */
 	if (!browser_reuse_connection(b, result->connection)) {
 		g_hash_table_steal(b->connections, &result->connection->fg.sockd);
@@ -463,5 +470,14 @@ void browser_free(browser_tp b) {
 			(gint)(duration_embedded_downloads.tv_nsec / 1000000),
 			b->bytes_uploaded,
  			b->bytes_downloaded);
+
+		if(b->shadowlib->recordMetric) {
+			gchar tags[128];
+			g_snprintf(tags, sizeof(tags), "completed=%d;expected=%d;bytes=%zu;sent=%zu;received=%zu",
+				b->embedded_downloads_completed, b->embedded_downloads_expected,
+				b->cumulative_size - b->document_size, b->bytes_uploaded, b->bytes_downloaded);
+			b->shadowlib->recordMetric("browser-embedded-complete",
+				duration_embedded_downloads.tv_sec + (duration_embedded_downloads.tv_nsec / 1000000000.0), tags);
+		}
 	}
 }
\ No newline at end of file
@@ -49,6 +49,12 @@ static void _filetransfer_logCallback(enum service_filegetter_loglevel level, co
 	}
 }
 
+static void _filetransfer_metricCallback(const gchar* name, gdouble value, const gchar* tags) {
+	if(ft->shadowlib->recordMetric) {
+		ft->shadowlib->recordMetric(name, value, tags);
+	}
+}
+
 static in_addr_t _filetransfer_HostnameCallback(const gchar* hostname) {
 	in_addr_t addr = 0;
 
@@ -136,6 +142,7 @@ void filetransfer_new(int argc, char* argv[]) {
 			args.filepath = _filetransfer_getHomePath(argv[8]);
 
 			args.log_cb = &_filetransfer_logCallback;
+			args.metric_cb = &_filetransfer_metricCallback;
 			args.hostbyname_cb = &_filetransfer_HostnameCallback;
 			args.sleep_cb = &_filetransfer_sleepCallback;
 
@@ -167,6 +174,7 @@ void filetransfer_new(int argc, char* argv[]) {
 			}
 
 			args.log_cb = &_filetransfer_logCallback;
+			args.metric_cb = &_filetransfer_metricCallback;
 			args.hostbyname_cb = &_filetransfer_HostnameCallback;
 			args.sleep_cb = &_filetransfer_sleepCallback;
 
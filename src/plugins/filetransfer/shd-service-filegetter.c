@@ -71,6 +71,20 @@ static void service_filegetter_report(service_filegetter_tp sfg, enum service_fi
 	}
 }
 
+static void service_filegetter_record(service_filegetter_tp sfg, filegetter_filestats_tp stats) {
+	if(sfg != NULL && sfg->metric_cb != NULL && stats != NULL) {
+		gdouble ttfb = stats->first_byte_time.tv_sec + (stats->first_byte_time.tv_nsec / 1000000000.0);
+		gdouble ttlb = stats->download_time.tv_sec + (stats->download_time.tv_nsec / 1000000000.0);
+
+		gchar tags[128];
+		g_snprintf(tags, sizeof(tags), "ttfb=%f;bytes=%zu;expected=%zu",
+				ttfb, stats->body_bytes_downloaded, stats->body_bytes_expected);
+
+		/* the value is the time to last byte, tags hold the rest */
+		(*(sfg->metric_cb))("fg-download-complete", ttlb, tags);
+	}
+}
+
 static in_addr_t service_filegetter_getaddr(service_filegetter_tp sfg, service_filegetter_server_args_tp server,
 		service_filegetter_hostbyname_cb hostname_cb) {
 	/* check if we have an address as a string */
@@ -194,8 +208,9 @@ enum filegetter_code service_filegetter_start_single(service_filegetter_tp sfg,
 	sfg->type = SFG_SINGLE;
 	sfg->state = SFG_NONE;
 
-	/* if null, we ignore logging */
+	/* if null, we ignore logging and metrics */
 	sfg->log_cb = args->log_cb;
+	sfg->metric_cb = args->metric_cb;
 	sfg->hostbyname_cb = args->hostbyname_cb;
 	sfg->sleep_cb = args->sleep_cb;
 
@@ -291,8 +306,9 @@ enum filegetter_code service_filegetter_start_multi(service_filegetter_tp sfg,
 	sfg->type = SFG_MULTI;
 	sfg->state = SFG_NONE;
 
-	/* if null, we ignore logging */
+	/* if null, we ignore logging and metrics */
 	sfg->log_cb = args->log_cb;
+	sfg->metric_cb = args->metric_cb;
 
 	/* not required if they only give us addresses. we complain later if needed */
 	sfg->hostbyname_cb = args->hostbyname_cb;
@@ -414,6 +430,7 @@ reactivate:;
 
 		/* report completion stats */
 		service_filegetter_report(sfg, SFG_NOTICE, "[fg-download-complete]", &stats, sfg->downloads_completed, sfg->downloads_requested);
+		service_filegetter_record(sfg, &stats);
 
 		if(sfg->downloads_requested > 0 &&
 				sfg->downloads_completed >= sfg->downloads_requested) {
@@ -43,6 +43,7 @@ enum service_filegetter_type {
 };
 
 typedef void (*service_filegetter_log_cb)(enum service_filegetter_loglevel level, const gchar* message);
+typedef void (*service_filegetter_metric_cb)(const gchar* name, gdouble value, const gchar* tags);
 typedef void (*service_filegetter_sleep_cb)(gpointer sfg, guint seconds);
 typedef in_addr_t (*service_filegetter_hostbyname_cb)(const gchar* hostname);
 
@@ -55,6 +56,7 @@ typedef struct service_filegetter_single_args_s {
 	service_filegetter_server_args_t http_server;
 	service_filegetter_server_args_t socks_proxy;
 	service_filegetter_log_cb log_cb;
+	service_filegetter_metric_cb metric_cb;
 	service_filegetter_sleep_cb sleep_cb;
 	service_filegetter_hostbyname_cb hostbyname_cb;
 	gchar* num_downloads;
@@ -70,6 +72,7 @@ typedef struct service_filegetter_multi_args_s {
 	service_filegetter_hostbyname_cb hostbyname_cb;
 	service_filegetter_sleep_cb sleep_cb;
 	service_filegetter_log_cb log_cb;
+	service_filegetter_metric_cb metric_cb;
 } service_filegetter_multi_args_t, *service_filegetter_multi_args_tp;
 
 typedef struct service_filegetter_download_s {
@@ -86,6 +89,7 @@ typedef struct service_filegetter_s {
 	service_filegetter_hostbyname_cb hostbyname_cb;
 	service_filegetter_sleep_cb sleep_cb;
 	service_filegetter_log_cb log_cb;
+	service_filegetter_metric_cb metric_cb;
 	CumulativeDistribution* think_times;
 	gint pausetime_seconds;
 	struct timespec wakeup;
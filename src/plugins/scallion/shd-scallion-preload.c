@@ -39,6 +39,7 @@ typedef int (*router_get_advertised_bandwidth_capped_fp)(void*);
 typedef int (*event_base_loopexit_fp)();
 typedef int (*add_callback_log_fp)(const log_severity_list_t *, log_callback);
 typedef int (*crypto_global_cleanup_fp)(void);
+typedef int (*assign_onionskin_to_cpuworker_fp)(void*, void*, void*);
 
 /* the key used to store each threads version of their searched function library.
  * the use this key to retrieve this library when intercepting functions from tor.
@@ -58,6 +59,7 @@ struct _ScallionPreloadWorker {
 	event_base_loopexit_fp g;
 	add_callback_log_fp h;
 	crypto_global_cleanup_fp i;
+	assign_onionskin_to_cpuworker_fp j;
 };
 
 /* scallionpreload_init must be called before this so the worker gets created */
@@ -94,6 +96,7 @@ void scallionpreload_init(GModule* handle) {
 	g_assert(g_module_symbol(handle, TOR_LIB_PREFIX "event_base_loopexit", (gpointer*)&(worker->g)));
 	g_assert(g_module_symbol(handle, TOR_LIB_PREFIX "add_callback_log", (gpointer*)&(worker->h)));
 	g_assert(g_module_symbol(handle, TOR_LIB_PREFIX "crypto_global_cleanup", (gpointer*)&(worker->i)));
+	g_assert(g_module_symbol(handle, TOR_LIB_PREFIX "assign_onionskin_to_cpuworker", (gpointer*)&(worker->j)));
 
 	g_static_private_set(&scallionWorkerKey, worker, g_free);
 }
@@ -142,3 +145,8 @@ int add_callback_log(const log_severity_list_t *severity, log_callback cb) {
 int crypto_global_cleanup(void) {
 	return _scallionpreload_getWorker()->i();
 }
+
+/* connection_t* cpuworker, or_circuit_t* circ, create_cell_t* or char* onionskin */
+int assign_onionskin_to_cpuworker(gpointer cpuworker, gpointer circ, gpointer onionskin) {
+	return _scallionpreload_getWorker()->j(cpuworker, circ, onionskin);
+}
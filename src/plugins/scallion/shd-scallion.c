@@ -123,23 +123,57 @@ static void _scalliontor_secondCallback(ScallionTor* stor) {
 }
 
 #ifdef SCALLION_DOREFILLCALLBACKS
-static void _scalliontor_refillCallback(ScallionTor* stor) {
-	scalliontor_notify(stor);
+/*
+ * tor remembers when it last refilled and credits the token buckets for all
+ * milliseconds since then, so instead of a refill timer on every node we
+ * refill on demand whenever tor is about to run, at most once per interval.
+ */
+static void _scalliontor_refill(ScallionTor* stor) {
+	if(!stor || !stor->refillmsecs) {
+		return;
+	}
+
+	struct timeval now;
+	tor_gettimeofday(&now);
+	if(stor->lastRefill.tv_sec && tv_mdiff(&stor->lastRefill, &now) < stor->refillmsecs) {
+		return;
+	}
+	stor->lastRefill = now;
 
 	/* call Tor's refill function */
 	refill_callback(NULL, NULL);
 
-        /* notify stream BW events */
-        control_event_stream_bandwidth_used();
+	/* notify stream BW events */
+	control_event_stream_bandwidth_used();
+}
+
+/*
+ * tor only blocks connections on bandwidth once a token bucket runs empty, so
+ * we check the global buckets instead of walking every connection on each
+ * wakeup. connections that only emptied their own bucket are refilled the next
+ * time tor runs, at the latest on the next second tick.
+ */
+static gboolean _scalliontor_isBlockedOnBandwidth() {
+	return global_read_bucket <= 0 || global_write_bucket <= 0;
+}
 
-	/* make sure we handle any event creations that happened in Tor */
+static void _scalliontor_refillCallback(ScallionTor* stor) {
+	/* the timer is done, a new wakeup needs a new one */
+	stor->refillTimerID = 0;
+
+	/* refills, runs the connections that were waiting, and re-arms if needed */
 	scalliontor_notify(stor);
+}
 
-	/* schedule the next callback */
-	if(stor) {
-		stor->shadowlibFuncs->createCallback((ShadowPluginCallbackFunc)_scalliontor_refillCallback,
-				stor, stor->refillmsecs);
+static void _scalliontor_scheduleRefill(ScallionTor* stor) {
+	/* idle nodes and nodes under their rate limit need no timer at all */
+	if(!stor || !stor->refillmsecs || stor->refillTimerID || !_scalliontor_isBlockedOnBandwidth()) {
+		return;
 	}
+
+	stor->refillTimerID = stor->shadowlibFuncs->createTimer(
+			(ShadowPluginCallbackFunc)_scalliontor_refillCallback, (gpointer)stor,
+			((guint64)stor->refillmsecs) * 1000000);
 }
 #endif
 
@@ -238,7 +272,7 @@ gint scalliontor_start(ScallionTor* stor, gint argc, gchar *argv[]) {
 //                                      NULL);
 //    tor_assert(refill_timer);
     stor->refillmsecs = msecs;
-	_scalliontor_refillCallback(stor);
+	_scalliontor_refill(stor);
   }
 #endif
 #endif
@@ -343,8 +377,18 @@ ScallionTor* scalliontor_new(ShadowFunctionTable* shadowlibFuncs, char* hostname
 void scalliontor_notify(ScallionTor* stor) {
 	update_approx_time(time(NULL));
 
+#ifdef SCALLION_DOREFILLCALLBACKS
+	/* credit the buckets for the time since tor last ran */
+	_scalliontor_refill(stor);
+#endif
+
 	/* tell libevent to check epoll and activate the ready sockets without blocking */
 	event_base_loop(tor_libevent_get_base(), EVLOOP_NONBLOCK);
+
+#ifdef SCALLION_DOREFILLCALLBACKS
+	/* wake up when the buckets have tokens for whoever ran out */
+	_scalliontor_scheduleRefill(stor);
+#endif
 }
 
 /*
@@ -358,6 +402,9 @@ void scalliontor_notify(ScallionTor* stor) {
  * as a callback so we don't invoke event_base_loop while it is currently being
  * executed. */
 static void scalliontor_loopexitCallback(ScallionTor* stor) {
+	/* the timer is done, a new loopexit needs a new one */
+	stor->loopexitTimerID = 0;
+
 	update_approx_time(time(NULL));
 
 	scalliontor_notify(stor);
@@ -381,7 +428,16 @@ static void scalliontor_loopexitCallback(ScallionTor* stor) {
 	scalliontor_notify(stor);
 }
 void scalliontor_loopexit(ScallionTor* stor) {
-	stor->shadowlibFuncs->createCallback((ShadowPluginCallbackFunc)scalliontor_loopexitCallback, (gpointer)stor, 1);
+	/* tor may ask to exit the loop many times before we get to it, but one
+	 * pending loopexit already handles all of them */
+	if(!stor->loopexitTimerID) {
+		stor->loopexitTimerID = stor->shadowlibFuncs->createTimer(
+				(ShadowPluginCallbackFunc)scalliontor_loopexitCallback, (gpointer)stor, 1000000);
+	}
+}
+
+static ScallionTor* scalliontor_getPointer() {
+	return scallion.stor;
 }
 
 /* return -1 to kill, 0 for EAGAIN, bytes read/written for success */
@@ -541,6 +597,9 @@ ret:
 
 end:
 	if (cpuw != NULL) {
+		if(scalliontor_getPointer()->cpuw == cpuw) {
+			scalliontor_getPointer()->cpuw = NULL;
+		}
 		memwipe(&cpuw->req, 0, sizeof(cpuw->req));
 		memwipe(&cpuw->rpl, 0, sizeof(cpuw->req));
 		release_server_onion_keys(&cpuw->onion_keys);
@@ -717,6 +776,9 @@ exit:
 
 kill:
 	if(cpuw != NULL) {
+		if(scalliontor_getPointer()->cpuw == cpuw) {
+			scalliontor_getPointer()->cpuw = NULL;
+		}
 		if (cpuw->onion_key)
 			crypto_pk_free(cpuw->onion_key);
 		if (cpuw->last_onion_key)
@@ -730,11 +792,11 @@ kill:
 
 void scalliontor_newCPUWorker(ScallionTor* stor, int fd) {
 	g_assert(stor);
-	if(stor->cpuw) {
-		g_free(stor->cpuw);
-	}
 
+	/* an older worker frees itself when tor closes its connection during key
+	 * rotation, so we only replace our reference to it here */
 	vtor_cpuworker_tp cpuw = calloc(1, sizeof(vtor_cpuworker_t));
+	stor->cpuw = cpuw;
 
 	cpuw->fd = fd;
 	cpuw->state = CPUW_NONE;
@@ -745,15 +807,13 @@ void scalliontor_newCPUWorker(ScallionTor* stor, int fd) {
 	dup_onion_keys(&(cpuw->onion_key), &(cpuw->last_onion_key));
 #endif
 
-	/* setup event so we will get a callback */
+	/* onionskins are handed to us directly, see
+	 * intercept_assign_onionskin_to_cpuworker. we still watch the socket so
+	 * we notice when tor closes it. */
 	event_assign(&(cpuw->read_event), tor_libevent_get_base(), cpuw->fd, EV_READ|EV_PERSIST, scalliontor_readCPUWorkerCallback, cpuw);
 	event_add(&(cpuw->read_event), NULL);
 }
 
-static ScallionTor* scalliontor_getPointer() {
-	return scallion.stor;
-}
-
 /*
  * Tor function interceptions
  */
@@ -895,6 +955,100 @@ int intercept_spawn_func(void (*func)(void *), void *data)
 	return 0;
 }
 
+/* this takes the place of sending the onionskin to a cpuworker over its socket
+ * and reading back the answer. we answer it right away, the same way tor
+ * answers CREATE_FAST cells, so the handshake work is charged to this node's
+ * CPU as part of the current plug-in execution. */
+#ifdef SCALLION_USEV2CPUWORKER
+int intercept_assign_onionskin_to_cpuworker(connection_t *cpuworker,
+		or_circuit_t *circ, create_cell_t *onionskin) {
+	ScallionTor* stor = scalliontor_getPointer();
+	g_assert(stor);
+
+	vtor_cpuworker_tp cpuw = stor->cpuw;
+	if(!cpuw || !circ->p_chan) {
+		log_info(LD_OR,"no cpuworker or circ->p_chan gone. Failing circ.");
+		tor_free(onionskin);
+		return -1;
+	}
+
+	created_cell_t cell_out;
+	uint8_t keys[CPATH_KEY_MATERIAL_LEN];
+	uint8_t rend_auth_material[DIGEST_LEN];
+	memset(&cell_out, 0, sizeof(cell_out));
+
+	int n = onion_skin_server_handshake(onionskin->handshake_type, onionskin->onionskin,
+			onionskin->handshake_len, &cpuw->onion_keys, cell_out.reply,
+			keys, CPATH_KEY_MATERIAL_LEN, rend_auth_material);
+	uint8_t cell_type = onionskin->cell_type;
+	tor_free(onionskin);
+
+	if (n < 0) {
+		log_debug(LD_OR, "onion_skin_server_handshake failed.");
+		circuit_mark_for_close(TO_CIRCUIT(circ), END_CIRC_REASON_TORPROTOCOL);
+	} else {
+		log_debug(LD_OR, "onion_skin_server_handshake succeeded.");
+		cell_out.handshake_len = n;
+		switch (cell_type) {
+		case CELL_CREATE:
+			cell_out.cell_type = CELL_CREATED;
+			break;
+		case CELL_CREATE2:
+			cell_out.cell_type = CELL_CREATED2;
+			break;
+		case CELL_CREATE_FAST:
+			cell_out.cell_type = CELL_CREATED_FAST;
+			break;
+		default:
+			tor_assert(0);
+			break;
+		}
+
+		if (onionskin_answer(circ, &cell_out, (const char*)keys, rend_auth_material) < 0) {
+			log_warn(LD_OR,"onionskin_answer failed. Closing.");
+			circuit_mark_for_close(TO_CIRCUIT(circ), END_CIRC_REASON_INTERNAL);
+		}
+	}
+
+	memwipe(keys, 0, sizeof(keys));
+	return 0;
+}
+#else
+int intercept_assign_onionskin_to_cpuworker(connection_t *cpuworker,
+		or_circuit_t *circ, char *onionskin) {
+	ScallionTor* stor = scalliontor_getPointer();
+	g_assert(stor);
+
+	vtor_cpuworker_tp cpuw = stor->cpuw;
+	if(!cpuw || !circ->p_conn) {
+		log_info(LD_OR,"no cpuworker or circ->p_conn gone. Failing circ.");
+		tor_free(onionskin);
+		return -1;
+	}
+
+	char keys[CPATH_KEY_MATERIAL_LEN];
+	char reply_to_proxy[ONIONSKIN_REPLY_LEN];
+
+	int r = onion_skin_server_handshake(onionskin, cpuw->onion_key, cpuw->last_onion_key,
+			reply_to_proxy, keys, CPATH_KEY_MATERIAL_LEN);
+	tor_free(onionskin);
+
+	if (r < 0) {
+		log_debug(LD_OR,"onion_skin_server_handshake failed.");
+		circuit_mark_for_close(TO_CIRCUIT(circ), END_CIRC_REASON_TORPROTOCOL);
+	} else {
+		log_debug(LD_OR,"onion_skin_server_handshake succeeded.");
+		if (onionskin_answer(circ, CELL_CREATED, reply_to_proxy, keys) < 0) {
+			log_warn(LD_OR,"onionskin_answer failed. Closing.");
+			circuit_mark_for_close(TO_CIRCUIT(circ), END_CIRC_REASON_INTERNAL);
+		}
+	}
+
+	memwipe(keys, 0, sizeof(keys));
+	return 0;
+}
+#endif
+
 /* this function is where the relay will return its bandwidth and send to auth */
 int intercept_rep_hist_bandwidth_assess() {
 	ScallionTor* stor = scalliontor_getPointer();
@@ -234,6 +234,12 @@ struct _ScallionTor {
 	int refillmsecs;
 	vtor_cpuworker_tp cpuw;
 	GList *logfiles;
+	/* pending loopexit timer, 0 if none */
+	guint loopexitTimerID;
+	/* pending wakeup for connections blocked on bandwidth, 0 if none */
+	guint refillTimerID;
+	/* when we last credited the token buckets */
+	struct timeval lastRefill;
 	ShadowFunctionTable* shadowlibFuncs;
 };
 
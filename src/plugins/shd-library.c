@@ -75,6 +75,38 @@ void shadowlib_createCallback(ShadowPluginCallbackFunc callback, gpointer data,
 	plugin_setShadowContext(worker->cached_plugin, FALSE);
 }
 
+guint shadowlib_createTimer(ShadowPluginCallbackFunc callback, gpointer data, guint64 nanosecondsDelay) {
+	Worker* worker = worker_getPrivate();
+	plugin_setShadowContext(worker->cached_plugin, TRUE);
+
+	guint timerID = application_createTimer(worker->cached_application,
+			_shadowlib_executeCallbackInPluginContext, data, callback, (SimulationTime)nanosecondsDelay);
+
+	plugin_setShadowContext(worker->cached_plugin, FALSE);
+	return timerID;
+}
+
+gboolean shadowlib_cancelTimer(guint timerID) {
+	Worker* worker = worker_getPrivate();
+	plugin_setShadowContext(worker->cached_plugin, TRUE);
+
+	gboolean success = application_cancelTimer(worker->cached_application, timerID);
+
+	plugin_setShadowContext(worker->cached_plugin, FALSE);
+	return success;
+}
+
+gboolean shadowlib_rescheduleTimer(guint timerID, guint64 nanosecondsDelay) {
+	Worker* worker = worker_getPrivate();
+	plugin_setShadowContext(worker->cached_plugin, TRUE);
+
+	gboolean success = application_rescheduleTimer(worker->cached_application,
+			timerID, (SimulationTime)nanosecondsDelay);
+
+	plugin_setShadowContext(worker->cached_plugin, FALSE);
+	return success;
+}
+
 gboolean shadowlib_getBandwidth(in_addr_t ip, guint* bwdown, guint* bwup) {
 	if(!bwdown || !bwup) {
 		return FALSE;
@@ -100,6 +132,15 @@ gboolean shadowlib_getBandwidth(in_addr_t ip, guint* bwdown, guint* bwup) {
 	return success;
 }
 
+void shadowlib_recordMetric(const gchar* name, gdouble value, const gchar* tags) {
+	Worker* worker = worker_getPrivate();
+	plugin_setShadowContext(worker->cached_plugin, TRUE);
+
+	worker_recordMetric(worker, name, value, tags);
+
+	plugin_setShadowContext(worker->cached_plugin, FALSE);
+}
+
 extern const void* intercept_RAND_get_rand_method(void);
 gboolean shadowlib_cryptoSetup(gint numLocks, gpointer* shadowLockFunc, gpointer* shadowIdFunc, gconstpointer* shadowRandomMethod) {
 	g_assert(shadowLockFunc && shadowIdFunc && shadowRandomMethod);
@@ -120,4 +161,8 @@ ShadowFunctionTable shadowlibFunctionTable = {
 	&shadowlib_createCallback,
 	&shadowlib_getBandwidth,
 	&shadowlib_cryptoSetup,
+	&shadowlib_createTimer,
+	&shadowlib_cancelTimer,
+	&shadowlib_rescheduleTimer,
+	&shadowlib_recordMetric,
 };
@@ -87,6 +87,24 @@ typedef void (*ShadowCreateCallbackFunc)(ShadowPluginCallbackFunc callback, gpoi
 typedef gboolean (*ShadowGetBandwidthFloorFunc)(in_addr_t ip, guint* bwdown, guint* bwup);
 typedef gboolean (*ShadowCryptoSetupFunc)(gint numLocks, gpointer* shadowLockFunc, gpointer* shadowIdFunc, gconstpointer* shadowRandomMethod);
 
+/*
+ * cancellable timers. delays are in nanoseconds of simulation time. the
+ * returned timer ID is never 0, and becomes invalid once the timer fires or is
+ * cancelled, after which cancelTimer and rescheduleTimer return FALSE.
+ */
+typedef guint (*ShadowCreateTimerFunc)(ShadowPluginCallbackFunc callback, gpointer data, guint64 nanosecondsDelay);
+typedef gboolean (*ShadowCancelTimerFunc)(guint timerID);
+typedef gboolean (*ShadowRescheduleTimerFunc)(guint timerID, guint64 nanosecondsDelay);
+
+/*
+ * structured results. records the value of the named metric for the calling
+ * node at the current simulation time, so results need not be scraped from
+ * the log. tags may be NULL, or 'key=value' pairs separated by ';'. records
+ * are only kept when shadow runs with --metrics-file. older plug-ins and
+ * stand-alone builds may see this pointer as NULL.
+ */
+typedef void (*ShadowRecordMetricFunc)(const gchar* name, gdouble value, const gchar* tags);
+
 typedef struct _ShadowFunctionTable ShadowFunctionTable;
 extern ShadowFunctionTable shadowlibFunctionTable;
 
@@ -101,6 +119,10 @@ struct _ShadowFunctionTable {
 	ShadowCreateCallbackFunc createCallback;
 	ShadowGetBandwidthFloorFunc getBandwidth;
 	ShadowCryptoSetupFunc cryptoSetup;
+	ShadowCreateTimerFunc createTimer;
+	ShadowCancelTimerFunc cancelTimer;
+	ShadowRescheduleTimerFunc rescheduleTimer;
+	ShadowRecordMetricFunc recordMetric;
 };
 
 /* Plug-ins must implement this function to communicate with Shadow.
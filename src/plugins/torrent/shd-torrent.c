@@ -98,6 +98,26 @@ static void torrent_report(TorrentClient* tc, gchar* preamble) {
 						tc->totalBytesDown, tc->fileSize, (gint)(((gdouble)tc->totalBytesDown / (gdouble)tc->fileSize) * 100),
 						curr_time.tv_sec, (gint)(curr_time.tv_nsec / 1000000),
 						tc->blocksDownloaded, tc->numBlocks, tc->blocksRemaining);
+
+		/* finished blocks and downloads are results, progress reports are not */
+		if(torrent->shadowlib->recordMetric != NULL) {
+			gboolean isBlock = g_str_equal(preamble, "[client-block-complete]");
+			gboolean isDownload = g_str_equal(preamble, "[client-complete]");
+
+			if(isBlock || isDownload) {
+				struct timespec* ttfb = isBlock ? &block_first_time : &first_time;
+				struct timespec* ttlb = isBlock ? &block_curr_time : &curr_time;
+				gint bytes = isBlock ? tc->currentBlockTransfer->downBytesTransfered : tc->totalBytesDown;
+
+				gchar tags[128];
+				g_snprintf(tags, sizeof(tags), "ttfb=%f;bytes=%d;block=%d;blocks=%d",
+						ttfb->tv_sec + (ttfb->tv_nsec / 1000000000.0), bytes,
+						tc->blocksDownloaded, tc->numBlocks);
+
+				torrent->shadowlib->recordMetric(isBlock ? "client-block-complete" : "client-complete",
+						ttlb->tv_sec + (ttlb->tv_nsec / 1000000000.0), tags);
+			}
+		}
 	}
 }
 
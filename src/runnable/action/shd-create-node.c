@@ -36,6 +36,8 @@ struct _CreateNodesAction {
 	GString* logLevelString;
 	GString* logPcapString;
 	GString* pcapDirString;
+	GString* tcpCongestionString;
+	GString* tcpSackString;
 	guint64 socketReceiveBufferSize;
 	guint64 socketSendBufferSize;
 	guint64 interfaceReceiveBufferLength;
@@ -63,7 +65,7 @@ CreateNodesAction* createnodes_new(GString* name, GString* cluster,
 		guint64 bandwidthdown, guint64 bandwidthup, guint64 quantity, guint64 cpuFrequency,
 		guint64 heartbeatIntervalSeconds, GString* heartbeatLogLevelString,
 		GString* logLevelString, GString* logPcapString, GString* pcapDirString,
-		guint64 socketReceiveBufferSize, guint64 socketSendBufferSize, guint64 interfaceReceiveBufferLength)
+		GString* tcpCongestionString, GString* tcpSackString, guint64 socketReceiveBufferSize, guint64 socketSendBufferSize, guint64 interfaceReceiveBufferLength)
 {
 	g_assert(name);
 	CreateNodesAction* action = g_new0(CreateNodesAction, 1);
@@ -91,6 +93,12 @@ CreateNodesAction* createnodes_new(GString* name, GString* cluster,
 	if(pcapDirString) {
 		action->pcapDirString = g_string_new(pcapDirString->str);
 	}
+	if(tcpCongestionString) {
+		action->tcpCongestionString = g_string_new(tcpCongestionString->str);
+	}
+	if(tcpSackString) {
+		action->tcpSackString = g_string_new(tcpSackString->str);
+	}
 	if(socketReceiveBufferSize) {
 		action->socketReceiveBufferSize = socketReceiveBufferSize;
 	}
@@ -182,6 +190,13 @@ void createnodes_run(CreateNodesAction* action) {
 
 	gchar* qdisc = configuration_getQueuingDiscipline(config);
 
+	TCPCongestionType tcpCongestion = tcpcongestion_typeFromString(action->tcpCongestionString ?
+			action->tcpCongestionString->str : configuration_getTCPCongestionControl(config));
+	gboolean tcpSack = config->tcpSelectiveAcks;
+	if(action->tcpSackString) {
+		tcpSack = !g_ascii_strcasecmp(action->tcpSackString->str, "true") ? TRUE : FALSE;
+	}
+
 	guint64 sockRecv = action->socketReceiveBufferSize; /* bytes */
 	if(!sockRecv) {
 		sockRecv = worker_getConfig()->initialSocketReceiveBufferSize;
@@ -196,16 +211,6 @@ void createnodes_run(CreateNodesAction* action) {
 	}
 
 	for(gint i = 0; i < action->quantity; i++) {
-		/* get a random network if they didnt assign one */
-		gdouble randomDouble = engine_nextRandomDouble(worker->cached_engine);
-		Network* network = assignedNetwork ? assignedNetwork :
-				internetwork_getRandomNetwork(worker_getInternet(), randomDouble);
-		g_assert(network);
-
-		/* use network bandwidth unless an override was given */
-		guint64 bwUpKiBps = action->bandwidthup ? action->bandwidthup : network_getBandwidthUp(network);
-		guint64 bwDownKiBps = action->bandwidthdown ? action->bandwidthdown : network_getBandwidthDown(network);
-
 		/* hostname */
 		GString* hostnameBuffer = g_string_new(hostname);
 		if(action->quantity > 1) {
@@ -215,12 +220,27 @@ void createnodes_run(CreateNodesAction* action) {
 		}
 		GQuark id = g_quark_from_string((const gchar*) hostnameBuffer->str);
 
+		/* all randomness for the node comes from its name, not from the order
+		 * nodes are created in, and needs no lock on the engine */
+		Random* nodeRandom = random_new(engine_getNodeSeed(worker->cached_engine, hostnameBuffer->str));
+
+		/* get a random network if they didnt assign one */
+		gdouble randomDouble = random_nextDouble(nodeRandom);
+		Network* network = assignedNetwork ? assignedNetwork :
+				internetwork_getRandomNetwork(worker_getInternet(), randomDouble);
+		g_assert(network);
+
+		/* use network bandwidth unless an override was given */
+		guint64 bwUpKiBps = action->bandwidthup ? action->bandwidthup : network_getBandwidthUp(network);
+		guint64 bwDownKiBps = action->bandwidthdown ? action->bandwidthdown : network_getBandwidthDown(network);
+
 		/* the node is part of the internet */
-		guint nodeSeed = (guint) engine_nextRandomInt(worker->cached_engine);
+		guint nodeSeed = (guint) random_nextInt(nodeRandom);
+		random_free(nodeRandom);
 		Node* node = internetwork_createNode(worker_getInternet(), id, network,
 				hostnameBuffer, bwDownKiBps, bwUpKiBps, cpuFrequency, cpuThreshold, cpuPrecision,
 				nodeSeed, heartbeatInterval, heartbeatLogLevel, logLevel, logPcap, pcapDir, qdisc,
-				sockSend, sockRecv, ifaceRecv);
+				tcpCongestion, tcpSack, sockSend, sockRecv, ifaceRecv);
 
 		g_string_free(hostnameBuffer, TRUE);
 
@@ -238,12 +258,6 @@ void createnodes_run(CreateNodesAction* action) {
 
 			item = g_list_next(item);
 		}
-
-		/* make sure our bootstrap events are set properly */
-		worker->clock_now = 0;
-		HeartbeatEvent* heartbeat = heartbeat_new(node_getTracker(node));
-		worker_scheduleEvent((Event*)heartbeat, heartbeatInterval, id);
-		worker->clock_now = SIMTIME_INVALID;
 	}
 }
 
@@ -256,6 +270,12 @@ void createnodes_free(CreateNodesAction* action) {
 	if(action->logLevelString) {
 		g_string_free(action->logLevelString, TRUE);
 	}
+	if(action->tcpCongestionString) {
+		g_string_free(action->tcpCongestionString, TRUE);
+	}
+	if(action->tcpSackString) {
+		g_string_free(action->tcpSackString, TRUE);
+	}
 
 	GList* item = action->applications;
 	while (item && item->data) {
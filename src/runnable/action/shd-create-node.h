@@ -30,7 +30,7 @@ CreateNodesAction* createnodes_new(GString* name, GString* cluster,
 		guint64 bandwidthdown, guint64 bandwidthup, guint64 quantity, guint64 cpuFrequency,
 		guint64 heartbeatIntervalSeconds, GString* heartbeatLogLevelString,
 		GString* logLevelString, GString* logPcapString, GString* pcapDirString,
-		guint64 socketReceiveBufferSize, guint64 socketSendBufferSize, guint64 interfaceReceiveBufferLength);
+		GString* tcpCongestionString, GString* tcpSackString, guint64 socketReceiveBufferSize, guint64 socketSendBufferSize, guint64 interfaceReceiveBufferLength);
 void createnodes_addApplication(CreateNodesAction* action, GString* pluginName,
 		GString* arguments, guint64 starttime, guint64 stoptime);
 void createnodes_run(CreateNodesAction* action);
@@ -33,6 +33,7 @@ struct _CallbackEvent {
 EventFunctionTable callback_functions = {
 	(EventRunFunc) callback_run,
 	(EventFreeFunc) callback_free,
+	"CallbackEvent",
 	MAGIC_VALUE
 };
 
@@ -63,7 +63,15 @@ gboolean shadowevent_run(Event* event) {
 	}
 
 	/* if we get here, its ok to execute the event */
-	event->vtable->run(event, node);
+	Profiler* profiler = worker_getPrivate()->profiler;
+	if(profiler) {
+		guint64 startTicks = profiler_getTicks();
+		event->vtable->run(event, node);
+		profiler_addEvent(profiler, node_getID(node), event->vtable->name,
+				profiler_getTicks() - startTicks);
+	} else {
+		event->vtable->run(event, node);
+	}
 	/* we've actually executed it, so its ok to free it */
 	return TRUE;
 }
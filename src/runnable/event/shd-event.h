@@ -38,6 +38,8 @@ typedef void (*EventFreeFunc)(Event* event);
 struct _EventFunctionTable {
 	EventRunFunc run;
 	EventFreeFunc free;
+	/* the event type, used when profiling */
+	const gchar* name;
 	MAGIC_DECLARE;
 };
 
@@ -21,39 +21,42 @@
 
 #include "shadow.h"
 
-struct _TCPCloseTimerExpiredEvent {
+struct _InterfaceDeliveredEvent {
 	Event super;
-	TCP* tcp;
+	NetworkInterface* interface;
 	MAGIC_DECLARE;
 };
 
-EventFunctionTable tcpclosetimerexpired_functions = {
-	(EventRunFunc) tcpclosetimerexpired_run,
-	(EventFreeFunc) tcpclosetimerexpired_free,
+EventFunctionTable interfacedelivered_functions = {
+	(EventRunFunc) interfacedelivered_run,
+	(EventFreeFunc) interfacedelivered_free,
+	"InterfaceDeliveredEvent",
 	MAGIC_VALUE
 };
 
-TCPCloseTimerExpiredEvent* tcpclosetimerexpired_new(TCP* tcp) {
-	TCPCloseTimerExpiredEvent* event = g_new0(TCPCloseTimerExpiredEvent, 1);
+InterfaceDeliveredEvent* interfacedelivered_new(NetworkInterface* interface) {
+	InterfaceDeliveredEvent* event = g_new0(InterfaceDeliveredEvent, 1);
 	MAGIC_INIT(event);
 
-	shadowevent_init(&(event->super), &tcpclosetimerexpired_functions);
-	event->tcp = tcp;
-	descriptor_ref(tcp);
+	shadowevent_init(&(event->super), &interfacedelivered_functions);
+
+	event->interface = interface;
 
 	return event;
 }
 
-void tcpclosetimerexpired_run(TCPCloseTimerExpiredEvent* event, Node* node) {
+void interfacedelivered_run(InterfaceDeliveredEvent* event, Node* node) {
 	MAGIC_ASSERT(event);
-	tcp_closeTimerExpired(event->tcp);
-}
 
-void tcpclosetimerexpired_free(TCPCloseTimerExpiredEvent* event) {
-	MAGIC_ASSERT(event);
+	debug("event started");
 
-	descriptor_unref(event->tcp);
+	networkinterface_delivered(event->interface);
 
+	debug("event finished");
+}
+
+void interfacedelivered_free(InterfaceDeliveredEvent* event) {
+	MAGIC_ASSERT(event);
 	MAGIC_CLEAR(event);
 	g_free(event);
 }
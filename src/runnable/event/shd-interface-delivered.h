@@ -19,15 +19,15 @@
  * along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#ifndef SHD_TCP_CLOSE_TIMER_EXPIRED_H_
-#define SHD_TCP_CLOSE_TIMER_EXPIRED_H_
+#ifndef SHD_INTERFACE_DELIVERED_H_
+#define SHD_INTERFACE_DELIVERED_H_
 
 #include "shadow.h"
 
-typedef struct _TCPCloseTimerExpiredEvent TCPCloseTimerExpiredEvent;
+typedef struct _InterfaceDeliveredEvent InterfaceDeliveredEvent;
 
-TCPCloseTimerExpiredEvent* tcpclosetimerexpired_new(TCP* tcp);
-void tcpclosetimerexpired_run(TCPCloseTimerExpiredEvent* event, Node* node);
-void tcpclosetimerexpired_free(TCPCloseTimerExpiredEvent* event);
+InterfaceDeliveredEvent* interfacedelivered_new(NetworkInterface* interface);
+void interfacedelivered_run(InterfaceDeliveredEvent* event, Node* node);
+void interfacedelivered_free(InterfaceDeliveredEvent* event);
 
-#endif /* SHD_TCP_CLOSE_TIMER_EXPIRED_H_ */
+#endif /* SHD_INTERFACE_DELIVERED_H_ */
@@ -30,6 +30,7 @@ struct _InterfaceReceivedEvent {
 EventFunctionTable interfacereceived_functions = {
 	(EventRunFunc) interfacereceived_run,
 	(EventFreeFunc) interfacereceived_free,
+	"InterfaceReceivedEvent",
 	MAGIC_VALUE
 };
 
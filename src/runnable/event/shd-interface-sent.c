@@ -30,6 +30,7 @@ struct _InterfaceSentEvent {
 EventFunctionTable interfacesent_functions = {
 	(EventRunFunc) interfacesent_run,
 	(EventFreeFunc) interfacesent_free,
+	"InterfaceSentEvent",
 	MAGIC_VALUE
 };
 
@@ -24,6 +24,7 @@
 EventFunctionTable notifyplugin_functions = {
 	(EventRunFunc) notifyplugin_run,
 	(EventFreeFunc) notifyplugin_free,
+	"NotifyPluginEvent",
 	MAGIC_VALUE
 };
 
@@ -30,6 +30,7 @@ struct _PacketArrivedEvent {
 EventFunctionTable packetarrived_functions = {
 	(EventRunFunc) packetarrived_run,
 	(EventFreeFunc) packetarrived_free,
+	"PacketArrivedEvent",
 	MAGIC_VALUE
 };
 
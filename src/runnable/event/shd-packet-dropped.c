@@ -30,6 +30,7 @@ struct _PacketDroppedEvent {
 EventFunctionTable packetdropped_functions = {
 	(EventRunFunc) packetdropped_run,
 	(EventFreeFunc) packetdropped_free,
+	"PacketDroppedEvent",
 	MAGIC_VALUE
 };
 
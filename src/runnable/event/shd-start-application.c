@@ -30,6 +30,7 @@ struct _StartApplicationEvent {
 EventFunctionTable startapplication_functions = {
 	(EventRunFunc) startapplication_run,
 	(EventFreeFunc) startapplication_free,
+	"StartApplicationEvent",
 	MAGIC_VALUE
 };
 
@@ -30,6 +30,7 @@ struct _StopApplicationEvent {
 EventFunctionTable stopapplication_functions = {
 	(EventRunFunc) stopapplication_run,
 	(EventFreeFunc) stopapplication_free,
+	"StopApplicationEvent",
 	MAGIC_VALUE
 };
 
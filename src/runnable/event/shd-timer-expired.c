@@ -21,34 +21,36 @@
 
 #include "shadow.h"
 
-EventFunctionTable heartbeat_functions = {
-	(EventRunFunc) heartbeat_run,
-	(EventFreeFunc) heartbeat_free,
-	MAGIC_VALUE
-};
-
-struct _HeartbeatEvent {
+struct _TimerExpiredEvent {
 	Event super;
-	Tracker* tracker;
+	/* lets the timer wheel tell if it still wants this event */
+	guint64 generation;
 	MAGIC_DECLARE;
 };
 
-HeartbeatEvent* heartbeat_new(Tracker* tracker) {
-	HeartbeatEvent* event = g_new0(HeartbeatEvent, 1);
+EventFunctionTable timerexpired_functions = {
+	(EventRunFunc) timerexpired_run,
+	(EventFreeFunc) timerexpired_free,
+	"TimerExpiredEvent",
+	MAGIC_VALUE
+};
+
+TimerExpiredEvent* timerexpired_new(guint64 generation) {
+	TimerExpiredEvent* event = g_new0(TimerExpiredEvent, 1);
 	MAGIC_INIT(event);
 
-	shadowevent_init(&(event->super), &heartbeat_functions);
-	event->tracker = tracker;
+	shadowevent_init(&(event->super), &timerexpired_functions);
+	event->generation = generation;
 
 	return event;
 }
 
-void heartbeat_run(HeartbeatEvent* event, Node* node) {
+void timerexpired_run(TimerExpiredEvent* event, Node* node) {
 	MAGIC_ASSERT(event);
-	tracker_heartbeat(event->tracker);
+	timerwheel_expire(node_getTimerWheel(node), event->generation);
 }
 
-void heartbeat_free(HeartbeatEvent* event) {
+void timerexpired_free(TimerExpiredEvent* event) {
 	MAGIC_ASSERT(event);
 	MAGIC_CLEAR(event);
 	g_free(event);
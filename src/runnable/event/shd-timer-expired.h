@@ -19,15 +19,15 @@
  * along with Shadow.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#ifndef SHD_HEARTBEAT_H_
-#define SHD_HEARTBEAT_H_
+#ifndef SHD_TIMER_EXPIRED_H_
+#define SHD_TIMER_EXPIRED_H_
 
 #include "shadow.h"
 
-typedef struct _HeartbeatEvent HeartbeatEvent;
+typedef struct _TimerExpiredEvent TimerExpiredEvent;
 
-HeartbeatEvent* heartbeat_new(Tracker* tracker);
-void heartbeat_run(HeartbeatEvent* event, Node* node);
-void heartbeat_free(HeartbeatEvent* event);
+TimerExpiredEvent* timerexpired_new(guint64 generation);
+void timerexpired_run(TimerExpiredEvent* event, Node* node);
+void timerexpired_free(TimerExpiredEvent* event);
 
-#endif /* SHD_HEARTBEAT_H_ */
+#endif /* SHD_TIMER_EXPIRED_H_ */
@@ -40,7 +40,7 @@
  *
  * @section dep Dependencies
  *
- * We depend on GLib 2.0
+ * We depend on GLib 2.0 and liblzma
  *
  * @section install Installation
  *
@@ -65,6 +65,7 @@
 #include "runnable/shd-listener.h"
 #include "node/shd-protocol.h"
 #include "node/descriptor/shd-descriptor.h"
+#include "node/descriptor/shd-tcp-congestion.h"
 #include "runnable/shd-runnable.h"
 #include "runnable/event/shd-event.h"
 #include "runnable/action/shd-action.h"
@@ -83,6 +84,8 @@
 #include "utility/shd-random.h"
 
 #include "engine/shd-event-queue.h"
+#include "engine/shd-crypto-cache.h"
+#include "engine/shd-profiler.h"
 #include "plugins/shd-library.h"
 #include "engine/shd-plugin.h"
 
@@ -97,22 +100,23 @@
 #include "node/descriptor/shd-socket.h"
 #include "node/descriptor/shd-tcp.h"
 #include "node/descriptor/shd-udp.h"
+#include "node/shd-timer-wheel.h"
 #include "node/shd-application.h"
 #include "node/shd-network-interface.h"
 #include "node/shd-tracker.h"
 #include "engine/shd-system.h"
 #include "node/shd-node.h"
 
-#include "runnable/event/shd-heartbeat.h"
 #include "runnable/event/shd-callback.h"
 #include "runnable/event/shd-notify-plugin.h"
+#include "runnable/event/shd-interface-delivered.h"
 #include "runnable/event/shd-interface-received.h"
 #include "runnable/event/shd-interface-sent.h"
 #include "runnable/event/shd-packet-arrived.h"
 #include "runnable/event/shd-packet-dropped.h"
 #include "runnable/event/shd-start-application.h"
 #include "runnable/event/shd-stop-application.h"
-#include "runnable/event/shd-tcp-close-timer-expired.h"
+#include "runnable/event/shd-timer-expired.h"
 #include "runnable/action/shd-connect-network.h"
 #include "runnable/action/shd-create-network.h"
 #include "runnable/action/shd-create-node.h"
@@ -124,6 +128,7 @@
 #include "engine/shd-logging.h"
 #include "engine/shd-engine.h"
 #include "engine/shd-worker.h"
+#include "engine/shd-controller.h"
 
 #include "intercept/preload.h"
 
@@ -105,6 +105,7 @@ gpointer internetwork_createNode(Internetwork* internet, GQuark nodeID,
 		guint64 bwDownKiBps, guint64 bwUpKiBps, guint cpuFrequency, gint cpuThreshold, gint cpuPrecision,
 		guint nodeSeed, SimulationTime heartbeatInterval, GLogLevelFlags heartbeatLogLevel,
 		GLogLevelFlags logLevel, gchar logPcap, gchar *pcapDir, gchar* qdisc,
+		TCPCongestionType tcpCongestion, gboolean tcpSelectiveAcks,
 		guint64 receiveBufferSize, guint64 sendBufferSize, guint64 interfaceReceiveLength); /* XXX: return type is "Node*" */
 
 /**
@@ -242,7 +242,7 @@ gdouble network_sampleLinkLatency(in_addr_t sourceIP, in_addr_t destinationIP) {
 	return network_getLinkLatency(sourceIP, destinationIP, percentile);
 }
 
-void network_scheduleRetransmit(Network* network, Packet* packet) {
+void network_scheduleRetransmit(Network* network, Packet* packet, SimulationTime departureDelay) {
 	MAGIC_ASSERT(network);
 
 	// FIXME make sure loopback packets dont get here!!
@@ -266,12 +266,12 @@ void network_scheduleRetransmit(Network* network, Packet* packet) {
 		latency += network_sampleLinkLatency(destinationIP, sourceIP);
 	}
 
-	SimulationTime delay = (SimulationTime) floor(latency * SIMTIME_ONE_MILLISECOND);
+	SimulationTime delay = departureDelay + (SimulationTime) floor(latency * SIMTIME_ONE_MILLISECOND);
 	PacketDroppedEvent* event = packetdropped_new(packet);
 	worker_scheduleEvent((Event*)event, delay, (GQuark)sourceIP);
 }
 
-void network_schedulePacket(Network* sourceNetwork, Packet* packet) {
+void network_schedulePacket(Network* sourceNetwork, Packet* packet, SimulationTime departureDelay) {
 	MAGIC_ASSERT(sourceNetwork);
 
 	Internetwork* internet = worker_getInternet();
@@ -288,11 +288,11 @@ void network_schedulePacket(Network* sourceNetwork, Packet* packet) {
 		/* sender side is scheduling packets, but we are simulating
 		 * the packet being dropped between sender and receiver, so
 		 * it will need to be retransmitted */
-		network_scheduleRetransmit(sourceNetwork, packet);
+		network_scheduleRetransmit(sourceNetwork, packet, departureDelay);
 	} else {
-		/* packet will make it through, find latency */
+		/* packet will make it through, it arrives one latency after it leaves */
 		gdouble latency = network_sampleLinkLatency(sourceIP, destinationIP);
-		SimulationTime delay = (SimulationTime) floor(latency * SIMTIME_ONE_MILLISECOND);
+		SimulationTime delay = departureDelay + (SimulationTime) floor(latency * SIMTIME_ONE_MILLISECOND);
 
 		PacketArrivedEvent* event = packetarrived_new(packet);
 		worker_scheduleEvent((Event*)event, delay, (GQuark)destinationIP);
@@ -118,14 +118,18 @@ gdouble network_sampleLinkLatency(in_addr_t sourceIP, in_addr_t destinationIP);
  *
  * @param sourceNetwork
  * @param packet
+ * @param departureDelay time from now until the packet leaves the source
+ * interface, before any link latency
  */
-void network_schedulePacket(Network* sourceNetwork, Packet* packet);
+void network_schedulePacket(Network* sourceNetwork, Packet* packet, SimulationTime departureDelay);
 
 /**
  *
  * @param network
  * @param packet
+ * @param departureDelay time from now until the packet leaves the source
+ * interface, before any link latency
  */
-void network_scheduleRetransmit(Network* network, Packet* packet);
+void network_scheduleRetransmit(Network* network, Packet* packet, SimulationTime departureDelay);
 
 #endif /* SHD_NETWORK_H_ */
@@ -26,11 +26,28 @@
 
 #include "shd-byte-queue.h"
 
+/* chunks are carved from a small set of size classes (powers of 4 starting at
+ * 128 bytes) so that drained chunks can be recycled by any queue on the same
+ * thread instead of going back to malloc. larger chunks are not pooled. */
+#define BYTECHUNK_MIN_CLASS_SIZE 128
+#define BYTECHUNK_NUM_CLASSES 5
+/* the most free chunks we cache per size class per thread */
+#define BYTECHUNK_POOL_MAX_FREE 64
+
 typedef struct _ByteChunk ByteChunk;
 struct _ByteChunk {
 	gpointer buf;
 	gsize capacity;
 	ByteChunk* next;
+	/* index of our size class, or -1 if we are not pooled */
+	gint sizeClass;
+};
+
+typedef struct _ByteChunkPool ByteChunkPool;
+struct _ByteChunkPool {
+	/* singly linked free lists through ByteChunk.next, one per size class */
+	ByteChunk* freeChunks[BYTECHUNK_NUM_CLASSES];
+	guint numFreeChunks[BYTECHUNK_NUM_CLASSES];
 };
 
 struct _ByteQueue {
@@ -43,12 +60,68 @@ struct _ByteQueue {
 	gsize chunk_capacity;
 };
 
+static void bytechunk_pool_free(ByteChunkPool* pool) {
+	for(gint i = 0; i < BYTECHUNK_NUM_CLASSES; i++) {
+		ByteChunk* chunk = pool->freeChunks[i];
+		while(chunk != NULL) {
+			ByteChunk* next = chunk->next;
+			g_free(chunk);
+			chunk = next;
+		}
+	}
+	g_free(pool);
+}
+
+/* each worker thread gets its own pool, so no locking is needed */
+static GPrivate bytechunkPoolKey = G_PRIVATE_INIT((GDestroyNotify)bytechunk_pool_free);
+
+static ByteChunkPool* bytechunk_pool_get() {
+	ByteChunkPool* pool = g_private_get(&bytechunkPoolKey);
+	if(pool == NULL) {
+		pool = g_new0(ByteChunkPool, 1);
+		g_private_set(&bytechunkPoolKey, pool);
+	}
+	return pool;
+}
+
+static gsize bytechunk_class_size(gint sizeClass) {
+	return ((gsize)BYTECHUNK_MIN_CLASS_SIZE) << (2 * sizeClass);
+}
+
+/* the smallest class that fits the given size, or -1 if none does */
+static gint bytechunk_class_for(gsize size) {
+	for(gint i = 0; i < BYTECHUNK_NUM_CLASSES; i++) {
+		if(size <= bytechunk_class_size(i)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
 static ByteChunk* bytechunk_new(gsize chunkSize){
-	ByteChunk* chunk = g_new0(ByteChunk, 1);
+	gint sizeClass = bytechunk_class_for(chunkSize);
+	ByteChunk* chunk = NULL;
+
+	if(sizeClass >= 0) {
+		chunkSize = bytechunk_class_size(sizeClass);
+
+		/* reuse a drained chunk if we have one */
+		ByteChunkPool* pool = bytechunk_pool_get();
+		chunk = pool->freeChunks[sizeClass];
+		if(chunk != NULL) {
+			pool->freeChunks[sizeClass] = chunk->next;
+			pool->numFreeChunks[sizeClass]--;
+		}
+	}
 
-	chunk->buf = g_malloc(chunkSize);
+	if(chunk == NULL) {
+		/* header and data share one allocation */
+		chunk = g_malloc(sizeof(ByteChunk) + chunkSize);
+		chunk->buf = ((guchar*)chunk) + sizeof(ByteChunk);
+		chunk->capacity = chunkSize;
+		chunk->sizeClass = sizeClass;
+	}
 
-	chunk->capacity = chunkSize;
 	chunk->next = NULL;
 
 	return chunk;
@@ -57,9 +130,17 @@ static ByteChunk* bytechunk_new(gsize chunkSize){
 static void bytechunk_free(ByteChunk* chunk){
 	g_assert(chunk);
 
-	if(chunk->buf != NULL){
-		g_free(chunk->buf);
+	if(chunk->sizeClass >= 0) {
+		ByteChunkPool* pool = bytechunk_pool_get();
+		if(pool->numFreeChunks[chunk->sizeClass] < BYTECHUNK_POOL_MAX_FREE) {
+			/* keep it around for the next queue that needs this size */
+			chunk->next = pool->freeChunks[chunk->sizeClass];
+			pool->freeChunks[chunk->sizeClass] = chunk;
+			pool->numFreeChunks[chunk->sizeClass]++;
+			return;
+		}
 	}
+
 	chunk->capacity = 0;
 	chunk->next = NULL;
 	g_free(chunk);
@@ -67,12 +148,16 @@ static void bytechunk_free(ByteChunk* chunk){
 	return;
 }
 
-static void bytequeue_create_new_head(ByteQueue* bqueue) {
+static void bytequeue_create_new_head(ByteQueue* bqueue, gsize bytesWanted) {
+	/* only use as much of the chunk capacity as the pending write needs, so
+	 * small writes (e.g. wakeup signals over socketpairs) use small chunks */
+	gsize chunkSize = MIN(bytesWanted, bqueue->chunk_capacity);
+
 	if(bqueue->head == NULL) {
-		bqueue->head = bqueue->tail = bytechunk_new(bqueue->chunk_capacity);
+		bqueue->head = bqueue->tail = bytechunk_new(chunkSize);
 		bqueue->tail_r_offset = 0;
 	} else {
-		ByteChunk* newhead = bytechunk_new(bqueue->chunk_capacity);
+		ByteChunk* newhead = bytechunk_new(chunkSize);
 		bqueue->head->next = newhead;
 		bqueue->head = newhead;
 	}
@@ -188,7 +273,7 @@ gsize bytequeue_push(ByteQueue* bqueue, gconstpointer inputBuffer, gsize nBytes)
 	/* creates new buffer heads lazily as opposed to proactively */
 
 	if(bqueue->head == NULL){
-		bytequeue_create_new_head(bqueue);
+		bytequeue_create_new_head(bqueue, bytes_left);
 	}
 
 	/* we will need to copy data from src to bqueue */
@@ -197,7 +282,7 @@ gsize bytequeue_push(ByteQueue* bqueue, gconstpointer inputBuffer, gsize nBytes)
 
 		/* if we have no space, allocate a new chunk at head for more data */
 		if(head_space <= 0){
-			bytequeue_create_new_head(bqueue);
+			bytequeue_create_new_head(bqueue, bytes_left);
 			continue;
 		}
 
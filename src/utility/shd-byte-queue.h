@@ -33,6 +33,10 @@
  * Its basically a linked queue that is written (and grows) at the front and
  * read (and shrinks) from the back. As data is written, new chunks are created
  * automatically. As data is read, old chunks are freed automatically.
+ *
+ * Chunks are sized to the pending write (up to chunkSize) and recycled through
+ * a per-thread pool, so queues that see lots of small writes and reads do not
+ * hit the allocator for every chunk.
  */
 
 typedef struct _ByteQueue ByteQueue;
@@ -23,7 +23,8 @@
 
 #include "shd-priority-queue.h"
 
-static const gsize INITIAL_SIZE = 100;
+/* most queues stay tiny, so start small and double as needed */
+static const gsize INITIAL_SIZE = 8;
 
 struct _PriorityQueue {
 	gpointer *heap;
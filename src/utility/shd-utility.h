@@ -24,6 +24,10 @@
 
 #include "shadow.h"
 
+/* approximate bytes a GHashTable or GQueue spends per entry, for reports */
+#define UTILITY_HASH_ENTRY_SIZE (2 * sizeof(gpointer) + sizeof(guint))
+#define UTILITY_QUEUE_ENTRY_SIZE (sizeof(GList))
+
 guint utility_ipPortHash(in_addr_t ip, in_port_t port);
 guint utility_int16Hash(gconstpointer value);
 gboolean utility_int16Equal(gconstpointer value1, gconstpointer value2);